@@ -0,0 +1,86 @@
+/*
+    By Adrien Couvidat
+    états accélérés : un état qui boucle sur presque toutes les lettres n'en quitte que sur quelques lettres de sortie,
+    la lecture saute alors directement à la prochaine lettre de sortie (memchr, ou comparaisons SSE2 pour 2 ou 3 lettres)
+    au lieu d'avancer lettre par lettre
+*/
+
+#include "mygrep_interne.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ACCELERATION_SSE2
+#endif
+
+#define ACCELERATION_PREAMBULE 16 // lettres comparées une à une avant la recherche vectorisée
+
+/// @brief marque l'état comme accéléré si il a au plus ACCELERATION_SORTIES lettres de sortie
+/// @param a
+/// @param boucles lettres qui laissent l'état inchangé
+void Acceleration_init(Acceleration* a,const Classe* boucles)
+{
+    a->active = false;
+    a->nb_sorties = 0;
+    for(size_t c=0;c<256;c++)
+    {
+        if(Classe_mem(boucles,c))
+            continue;
+        if(a->nb_sorties==ACCELERATION_SORTIES)
+            return;
+        a->sorties[a->nb_sorties++] = c;
+    }
+    a->active = true;
+}
+
+/// @brief position de la première lettre de sortie de `texte`
+/// @note 16 octets par comparaison avec SSE2
+/// @param a état accéléré (voir `Acceleration_init`)
+/// @param texte
+/// @param size
+/// @return l'index de la première lettre de sortie, ou `size` si il n'y en a pas
+size_t Acceleration_sauter(const Acceleration* a,const unsigned char* texte,size_t size)
+{
+    if(a->nb_sorties==0)
+        return size;
+
+    // une lettre de sortie fréquente laisse peu à sauter : les premières lettres sont comparées une à une
+    // (une troisième lettre absente est remplacée par la deuxième, et la deuxième par la première)
+    unsigned char c0 = a->sorties[0];
+    unsigned char c1 = a->nb_sorties>=2?a->sorties[1]:c0;
+    unsigned char c2 = a->nb_sorties==3?a->sorties[2]:c1;
+    size_t i = 0;
+    for(;i<size && i<ACCELERATION_PREAMBULE;i++)
+        if(texte[i]==c0 || texte[i]==c1 || texte[i]==c2)
+            return i;
+    if(a->nb_sorties==1)
+    {
+        const unsigned char* trouve = memchr(texte+i,c0,size-i);
+        return trouve==NULL?size:(size_t)(trouve-texte);
+    }
+#ifdef ACCELERATION_SSE2
+    __m128i s0 = _mm_set1_epi8((char)c0);
+    __m128i s1 = _mm_set1_epi8((char)c1);
+    __m128i s2 = _mm_set1_epi8((char)c2);
+    for(;i+16<=size;i+=16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(texte+i));
+        __m128i sortie = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x,s0),_mm_cmpeq_epi8(x,s1)),_mm_cmpeq_epi8(x,s2));
+        int masque = _mm_movemask_epi8(sortie);
+        if(masque!=0)
+        {
+#ifdef __GNUC__
+            return i+__builtin_ctz(masque);
+#else
+            size_t k = 0;
+            while(!((masque>>k)&1))
+                k++;
+            return i+k;
+#endif
+        }
+    }
+#endif
+    for(;i<size;i++)
+        if(texte[i]==c0 || texte[i]==c1 || texte[i]==c2)
+            return i;
+    return size;
+}
@@ -0,0 +1,152 @@
+/*
+    By Adrien Couvidat
+    anneau de blocs rempli par un thread producteur (voir anneau.h)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mygrep.h"
+#include "memoire.h"
+#include "anneau.h"
+#include "trace.h"
+
+#ifdef ANNEAU_DISPONIBLE
+
+/// @brief boucle du thread producteur : remplit les blocs libres jusqu'à la fin de la source
+/// @param arg l'anneau
+/// @return
+void* Anneau_producteur(void* arg)
+{
+    Anneau* a = arg;
+    while(true)
+    {
+        pthread_mutex_lock(&a->verrou);
+        while(a->pleins==ANNEAU_NB_BLOCS && !a->arret)
+            pthread_cond_wait(&a->changement,&a->verrou);
+        if(a->arret)
+        {
+            pthread_mutex_unlock(&a->verrou);
+            return NULL;
+        }
+        Bloc* b = &a->blocs[(a->tete+a->pleins)%ANNEAU_NB_BLOCS];
+        pthread_mutex_unlock(&a->verrou);
+
+        // le bloc libre n'appartient qu'au producteur : on le remplit sans verrou
+        b->size = a->produire(a->source,b->data,ANNEAU_BLOC);
+
+        pthread_mutex_lock(&a->verrou);
+        if(b->size==0)
+            a->fin = true;
+        else
+            a->pleins++;
+        pthread_cond_broadcast(&a->changement);
+        pthread_mutex_unlock(&a->verrou);
+
+        if(b->size==0)
+            return NULL;
+    }
+}
+
+/// @brief instancie un anneau et démarre son thread producteur
+/// @param produire fonction appelée par le producteur pour remplir chaque bloc
+/// @param source argument de `produire`
+/// @return l'anneau, ou NULL si le thread n'a pas pu être créé
+Anneau* Anneau_init(Producteur produire,void* source)
+{
+    Anneau* a = malloc(sizeof(Anneau));
+    Memoire_prendre(ANNEAU_NB_BLOCS*ANNEAU_BLOC);
+    for(size_t i=0;i<ANNEAU_NB_BLOCS;i++)
+    {
+        a->blocs[i].data = malloc(ANNEAU_BLOC);
+        a->blocs[i].size = 0;
+    }
+    a->tete = 0;
+    a->pleins = 0;
+    a->lu = 0;
+    a->fin = false;
+    a->arret = false;
+    a->produire = produire;
+    a->source = source;
+    pthread_mutex_init(&a->verrou,NULL);
+    pthread_cond_init(&a->changement,NULL);
+    if(pthread_create(&a->producteur,NULL,Anneau_producteur,a)!=0)
+    {
+        pthread_mutex_destroy(&a->verrou);
+        pthread_cond_destroy(&a->changement);
+        for(size_t i=0;i<ANNEAU_NB_BLOCS;i++)
+            free(a->blocs[i].data);
+        Memoire_rendre(ANNEAU_NB_BLOCS*ANNEAU_BLOC);
+        free(a);
+        return NULL;
+    }
+    return a;
+}
+
+/// @brief arrête le producteur et libère l'anneau
+/// @param a
+void Anneau_free(Anneau* a)
+{
+    if(a==NULL)
+        return;
+
+    pthread_mutex_lock(&a->verrou);
+    a->arret = true;
+    pthread_cond_broadcast(&a->changement);
+    pthread_mutex_unlock(&a->verrou);
+    pthread_join(a->producteur,NULL);
+
+    pthread_mutex_destroy(&a->verrou);
+    pthread_cond_destroy(&a->changement);
+    for(size_t i=0;i<ANNEAU_NB_BLOCS;i++)
+        free(a->blocs[i].data);
+    Memoire_rendre(ANNEAU_NB_BLOCS*ANNEAU_BLOC);
+    free(a);
+}
+
+/// @brief copie dans `data` les prochains octets produits, en attendant qu'un bloc soit plein
+/// @param a
+/// @param data
+/// @param capacity
+/// @return le nombre d'octets copiés, 0 à la fin de la source
+size_t Anneau_lire(Anneau* a,char* data,size_t capacity)
+{
+    uint64_t attente = Trace_maintenant();
+    bool attendu = false;
+    pthread_mutex_lock(&a->verrou);
+    while(a->pleins==0 && !a->fin)
+    {
+        pthread_cond_wait(&a->changement,&a->verrou);
+        attendu = true;
+    }
+    if(attendu)
+        Trace_intervalle("attente décompression",attente,0);
+    if(a->pleins==0)
+    {
+        pthread_mutex_unlock(&a->verrou);
+        return 0;
+    }
+    Bloc* b = &a->blocs[a->tete];
+    pthread_mutex_unlock(&a->verrou);
+
+    // le bloc plein de tête n'appartient qu'au consommateur
+    size_t n = b->size-a->lu;
+    if(n>capacity)
+        n = capacity;
+    memcpy(data,b->data+a->lu,n);
+    a->lu += n;
+
+    if(a->lu==b->size)
+    {
+        // bloc vidé : il est rendu au producteur
+        pthread_mutex_lock(&a->verrou);
+        a->tete = (a->tete+1)%ANNEAU_NB_BLOCS;
+        a->pleins--;
+        a->lu = 0;
+        pthread_cond_broadcast(&a->changement);
+        pthread_mutex_unlock(&a->verrou);
+    }
+    return n;
+}
+
+#endif // ANNEAU_DISPONIBLE
@@ -0,0 +1,59 @@
+/*
+    By Adrien Couvidat
+    anneau de blocs rempli par un thread producteur (décompression, lecture anticipée)
+    pendant que le thread principal cherche les motifs dans les blocs déjà produits
+*/
+
+#ifndef ANNEAU_H
+#define ANNEAU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#define ANNEAU_DISPONIBLE // les threads POSIX sont disponibles
+#endif
+
+#define ANNEAU_NB_BLOCS 4
+#define ANNEAU_BLOC (256*1024)
+
+/// @brief fonction du producteur : écrit au plus `capacity` octets dans `data`
+/// @return le nombre d'octets produits, 0 à la fin de la source
+typedef size_t (*Producteur)(void* source,char* data,size_t capacity);
+
+#ifdef ANNEAU_DISPONIBLE
+
+/// @brief bloc de l'anneau
+struct Bloc
+{
+    char* data;
+    size_t size;
+};
+typedef struct Bloc Bloc;
+
+/// @brief file bornée de `ANNEAU_NB_BLOCS` blocs alloués une seule fois :
+/// le producteur remplit les blocs libres, le consommateur vide les blocs pleins dans l'ordre
+struct Anneau
+{
+    Bloc blocs[ANNEAU_NB_BLOCS];
+    size_t tete;        // index du plus ancien bloc plein
+    size_t pleins;      // nombre de blocs pleins
+    size_t lu;          // octets du bloc de tête déjà rendus au consommateur
+    bool fin;           // le producteur a terminé
+    bool arret;         // le consommateur n'attend plus rien
+    Producteur produire;
+    void* source;
+    pthread_mutex_t verrou;
+    pthread_cond_t changement;
+    pthread_t producteur;
+};
+typedef struct Anneau Anneau;
+
+Anneau* Anneau_init(Producteur produire,void* source);
+void Anneau_free(Anneau* a);
+size_t Anneau_lire(Anneau* a,char* data,size_t capacity);
+
+#endif // ANNEAU_DISPONIBLE
+
+#endif // ANNEAU_H
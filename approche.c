@@ -0,0 +1,410 @@
+/*
+    By Adrien Couvidat
+    recherche approchée : motifs à au plus K erreurs (insertion, suppression ou substitution d'une lettre)
+    simulation de Wu et Manber : la ligne i retient les états atteints avec i erreurs,
+    sur les positions de Glushkov en vecteurs de bits si elles tiennent dans un uint64_t, sinon sur les ensembles d'états de l'automate
+*/
+
+#include "mygrep_interne.h"
+
+/// @brief premières et dernières positions d'un sous-arbre, et si il reconnaît le mot vide
+struct Fragment
+{
+    uint64_t premiers;
+    uint64_t derniers;
+    bool vide;
+};
+typedef struct Fragment Fragment;
+
+/// @brief ajoute `premiers` aux suivants de chaque position de `derniers`
+/// @param g
+/// @param derniers
+/// @param premiers
+void Glushkov_suivre(Glushkov* g,uint64_t derniers,uint64_t premiers)
+{
+    for(size_t j=0;j<64;j++)
+        if((derniers>>j)&1)
+            g->suivants[j] |= premiers;
+}
+
+/// @brief remplace `a` par la concaténation de `a` et `b`
+/// @param g
+/// @param a
+/// @param b
+void Fragment_concatener(Glushkov* g,Fragment* a,const Fragment* b)
+{
+    Glushkov_suivre(g,a->derniers,b->premiers);
+    a->premiers |= a->vide?b->premiers:0;
+    a->derniers = b->derniers|(b->vide?a->derniers:0);
+    a->vide = a->vide && b->vide;
+}
+
+/// @brief numérote les positions de l'arbre et calcule leurs suivants (construction de Glushkov)
+/// @note une répétition e{n,m} est dépliée : n copies de e puis m-n copies de e?
+/// @param tree
+/// @param g
+/// @param alphabet_size
+/// @param inverse construit l'automate du langage miroir (les concaténations sont lues de droite à gauche)
+/// @param f premières et dernières positions de l'arbre
+/// @return false si l'arbre a plus de GLUSHKOV_POSITIONS_MAX positions
+bool Glushkov_noeud(Tree* tree,Glushkov* g,size_t alphabet_size,bool inverse,Fragment* f)
+{
+    if(tree->left_chilfren==NULL)
+    {
+        if(g->m==GLUSHKOV_POSITIONS_MAX)
+            return false;
+        size_t j = ++g->m;
+        Classe lettres;
+        Classe_clear(&lettres);
+        Tree_classe(tree,&lettres,alphabet_size); // classe vide pour une lettre hors de l'alphabet
+        for(size_t c=0;c<256;c++)
+            if(Classe_mem(&lettres,c))
+                g->lettres[c] |= (uint64_t)1<<j;
+        f->premiers = f->derniers = (uint64_t)1<<j;
+        f->vide = false;
+        return true;
+    }
+
+    Fragment a,b;
+    switch(tree->etiquette)
+    {
+    case SYNTAXE_OPERATOR_CONCATENATION:
+        if(!Glushkov_noeud(inverse?tree->right_children:tree->left_chilfren,g,alphabet_size,inverse,f)
+            || !Glushkov_noeud(inverse?tree->left_chilfren:tree->right_children,g,alphabet_size,inverse,&b))
+            return false;
+        Fragment_concatener(g,f,&b);
+        return true;
+    case SYNTAXE_OPERATOR_UNION:
+        if(!Glushkov_noeud(tree->left_chilfren,g,alphabet_size,inverse,f)
+            || !Glushkov_noeud(tree->right_children,g,alphabet_size,inverse,&b))
+            return false;
+        f->premiers |= b.premiers;
+        f->derniers |= b.derniers;
+        f->vide = f->vide || b.vide;
+        return true;
+    case SYNTAXE_OPERATOR_ETOILE:
+        if(!Glushkov_noeud(tree->left_chilfren,g,alphabet_size,inverse,f))
+            return false;
+        Glushkov_suivre(g,f->derniers,f->premiers);
+        f->vide = true;
+        return true;
+    case SYNTAXE_OPERATOR_JOKER:
+        if(!Glushkov_noeud(tree->left_chilfren,g,alphabet_size,inverse,f))
+            return false;
+        f->vide = true;
+        return true;
+    case SYNTAXE_OPERATOR_REPETITION:
+    {
+        f->premiers = f->derniers = 0;
+        f->vide = true;
+        size_t copies = (tree->max==REPETITION_INFINIE)?tree->min+1:tree->max;
+        for(size_t i=0;i<copies;i++)
+        {
+            if(!Glushkov_noeud(tree->left_chilfren,g,alphabet_size,inverse,&a))
+                return false;
+            if(i>=tree->min)
+            {
+                if(tree->max==REPETITION_INFINIE)
+                    Glushkov_suivre(g,a.derniers,a.premiers);
+                a.vide = true;
+            }
+            Fragment_concatener(g,f,&a);
+        }
+        return true;
+    }
+    default:
+        // ancres
+        return Glushkov_noeud(tree->left_chilfren,g,alphabet_size,inverse,f);
+    }
+}
+
+/// @brief instancie l'automate de Glushkov de l'arbre en vecteurs de bits
+/// @param tree arbre sans ancre
+/// @param alphabet_size
+/// @param inverse automate du langage miroir
+/// @return NULL si l'arbre a trop de positions
+Glushkov* Glushkov_init(Tree* tree,size_t alphabet_size,bool inverse)
+{
+    Glushkov* g = calloc(1,sizeof(Glushkov));
+    Fragment f;
+    if(!Glushkov_noeud(tree,g,alphabet_size,inverse,&f))
+    {
+        free(g);
+        return NULL;
+    }
+    Memoire_prendre(sizeof(Glushkov));
+    g->suivants[0] = f.premiers;
+    g->finaux = f.derniers|(f.vide?1:0);
+
+    // les suivants d'un vecteur de positions se lisent octet par octet dans des tables
+    g->nb_tables = (g->m+1+7)/8;
+    for(size_t k=0;k<g->nb_tables;k++)
+        for(size_t o=0;o<256;o++)
+            for(size_t i=0;i<8 && 8*k+i<=g->m;i++)
+                if((o>>i)&1)
+                    g->tables[k][o] |= g->suivants[8*k+i];
+    return g;
+}
+
+void Glushkov_free(Glushkov* g)
+{
+    Memoire_rendre(sizeof(Glushkov));
+    free(g);
+}
+
+/// @brief réunion des suivants des positions de `d`
+/// @param g
+/// @param d
+/// @return
+uint64_t Glushkov_suivants(const Glushkov* g,uint64_t d)
+{
+    uint64_t r = 0;
+    for(size_t k=0;k<g->nb_tables;k++)
+        r |= g->tables[k][(d>>(8*k))&0xff];
+    return r;
+}
+
+/// @brief lignes de départ : la ligne i contient les positions atteintes en supprimant i lettres du motif
+/// @param g
+/// @param erreurs
+/// @param r
+void Glushkov_depart(const Glushkov* g,size_t erreurs,uint64_t* r)
+{
+    r[0] = 1;
+    for(size_t i=1;i<=erreurs;i++)
+        r[i] = r[i-1]|Glushkov_suivants(g,r[i-1]);
+}
+
+/// @brief lit la lettre `c` : la ligne i suit une transition de la lettre, ou prend une erreur de plus à la ligne i-1
+/// (insertion : la lettre est ignorée, substitution : n'importe quelle position suivante, suppression : une position sautée)
+/// @param g
+/// @param erreurs
+/// @param r lignes courantes
+/// @param n lignes après lecture de `c`
+/// @param c
+/// @param recherche l'état initial reste actif, pour trouver un motif à toute position
+void Glushkov_pas(const Glushkov* g,size_t erreurs,const uint64_t* r,uint64_t* n,unsigned char c,bool recherche)
+{
+    uint64_t lettre = g->lettres[c];
+    n[0] = (Glushkov_suivants(g,r[0])&lettre)|(recherche?1:0);
+    for(size_t i=1;i<=erreurs;i++)
+    {
+        uint64_t precedente = r[i-1];
+        n[i] = (Glushkov_suivants(g,r[i])&lettre)|precedente|Glushkov_suivants(g,precedente|n[i-1]);
+    }
+}
+
+/*
+    sans vecteur de bits : une ligne est un ensemble d'états de l'automate
+*/
+
+/// @brief états atteints depuis `e` en lisant n'importe quelle lettre (substitution ou suppression)
+/// @param a
+/// @param e
+/// @param dest
+void Automate_read_any_into(Automate* a,Ensemble* e,Ensemble* dest)
+{
+    Ensemble_clear(dest);
+    for(size_t i=0;i<e->cardinal;i++)
+        for(Lettre l=EPSILON_TRANSITION_INDEX+1;l<a->alphabet_size;l++)
+            Ensemble_eat_list(dest,a->transitions[e->elements[i]][l]);
+    if(a->classes_debut!=NULL && e->cardinal<a->nb_classes)
+    {
+        for(size_t i=0;i<e->cardinal;i++)
+            for(size_t c=a->classes_debut[e->elements[i]];c<a->classes_debut[e->elements[i]+1];c++)
+                Ensemble_add(dest,a->classes[c].dest);
+        return;
+    }
+    for(size_t c=0;c<a->nb_classes;c++)
+        if(Ensemble_mem(e,a->classes[c].source))
+            Ensemble_add(dest,a->classes[c].dest);
+}
+
+/// @brief ajoute à `dest` les éléments de `source`
+/// @param dest
+/// @param source
+void Ensemble_ajouter(Ensemble* dest,Ensemble* source)
+{
+    for(size_t i=0;i<source->cardinal;i++)
+        Ensemble_add(dest,source->elements[i]);
+}
+
+/// @brief lignes de départ, depuis la cloture des états initiaux `init`
+/// @param a
+/// @param init
+/// @param erreurs
+/// @param r
+/// @param tampon
+void Automate_depart_approche(Automate* a,Ensemble* init,size_t erreurs,Ensemble** r,Ensemble* tampon)
+{
+    Ensemble_copy_into(r[0],init);
+    for(size_t i=1;i<=erreurs;i++)
+    {
+        Automate_read_any_into(a,r[i-1],tampon);
+        Ensemble_copy_into(r[i],r[i-1]);
+        Ensemble_ajouter(r[i],tampon);
+        Automate_cloture_instantanee_into(a,r[i]);
+    }
+}
+
+/// @brief même lecture que `Glushkov_pas` sur des ensembles d'états clos
+/// @param a automate sans compteur
+/// @param erreurs
+/// @param r
+/// @param n
+/// @param tampon
+/// @param c
+void Automate_pas_approche(Automate* a,size_t erreurs,Ensemble** r,Ensemble** n,Ensemble* tampon,unsigned char c)
+{
+    Automate_read_letter_into(a,r[0],c,n[0]);
+    Automate_cloture_instantanee_into(a,n[0]);
+    for(size_t i=1;i<=erreurs;i++)
+    {
+        Automate_read_letter_into(a,r[i],c,n[i]);
+        Ensemble_ajouter(n[i],r[i-1]);
+        Automate_read_any_into(a,r[i-1],tampon);
+        Ensemble_ajouter(n[i],tampon);
+        Automate_read_any_into(a,n[i-1],tampon);
+        Ensemble_ajouter(n[i],tampon);
+        Automate_cloture_instantanee_into(a,n[i]);
+    }
+}
+
+/*
+    recherche
+*/
+
+/// @brief lit `line` à partir de `from` et cherche la fin du premier motif à au plus `m->erreurs` erreurs
+/// @param m
+/// @param s
+/// @param line
+/// @param size
+/// @param from
+/// @param recherche le motif peut commencer à n'importe quelle position, sinon seulement en `from`
+/// @param fin seule la fin de la ligne est une fin de motif possible
+/// @param end index de la dernière lettre du motif
+/// @param vide le mot vide est reconnu avant toute lecture
+/// @return true si un motif a été trouvé
+bool approche_fin(const Motif* m,Scratch* s,const unsigned char* line,size_t size,size_t from,bool recherche,bool fin,size_t* end,bool* vide)
+{
+    size_t k = m->erreurs;
+    const Glushkov* g = m->plan.glushkov;
+    Automate* a = (recherche && m->line_automate!=NULL)?m->line_automate:m->automate;
+    Ensemble* init = (recherche && m->line_automate!=NULL)?m->line_init:m->init;
+    if(g!=NULL)
+    {
+        Glushkov_depart(g,k,s->rangs);
+        *vide = (s->rangs[k]&g->finaux)!=0;
+    }else
+    {
+        Automate_depart_approche(a,init,k,s->ensembles,s->tampon);
+        *vide = Automate_is_final_ensemble(a,s->ensembles[k]);
+    }
+
+    for(size_t i=from;i<size;i++)
+    {
+        bool final;
+        bool mort = true;
+        if(g!=NULL)
+        {
+            Glushkov_pas(g,k,s->rangs,s->rangs_suivants,line[i],recherche);
+            uint64_t* temp = s->rangs;
+            s->rangs = s->rangs_suivants;
+            s->rangs_suivants = temp;
+            final = (s->rangs[k]&g->finaux)!=0;
+            for(size_t j=0;j<=k && mort;j++)
+                mort = s->rangs[j]==0;
+        }else
+        {
+            Automate_pas_approche(a,k,s->ensembles,s->ensembles_suivants,s->tampon,line[i]);
+            Ensemble** temp = s->ensembles;
+            s->ensembles = s->ensembles_suivants;
+            s->ensembles_suivants = temp;
+            final = Automate_is_final_ensemble(a,s->ensembles[k]);
+            for(size_t j=0;j<=k && mort;j++)
+                mort = Ensemble_vide(s->ensembles[j]);
+        }
+        s->octets_lus++;
+
+        if(final && (!fin || i==size-1))
+        {
+            *end = i;
+            return true;
+        }
+        if(mort && !recherche)
+            break;
+    }
+    return false;
+}
+
+/// @brief relit la ligne de droite à gauche depuis `end` avec l'automate inverse pour trouver le début du motif le plus court
+/// @param m
+/// @param s
+/// @param line
+/// @param from
+/// @param end
+/// @return
+size_t approche_debut(const Motif* m,Scratch* s,const unsigned char* line,size_t from,size_t end)
+{
+    size_t k = m->erreurs;
+    const Glushkov* g = m->plan.glushkov_inverse;
+    Automate* a = m->reverse_automate;
+    bool final;
+    if(g!=NULL)
+    {
+        Glushkov_depart(g,k,s->rangs);
+        final = (s->rangs[k]&g->finaux)!=0;
+    }else
+    {
+        Automate_depart_approche(a,m->reverse_init,k,s->ensembles,s->tampon);
+        final = Automate_is_final_ensemble(a,s->ensembles[k]);
+    }
+
+    size_t current_index = end+1;
+    while(!final && current_index>from)
+    {
+        current_index--;
+        if(g!=NULL)
+        {
+            Glushkov_pas(g,k,s->rangs,s->rangs_suivants,line[current_index],false);
+            uint64_t* temp = s->rangs;
+            s->rangs = s->rangs_suivants;
+            s->rangs_suivants = temp;
+            final = (s->rangs[k]&g->finaux)!=0;
+        }else
+        {
+            Automate_pas_approche(a,k,s->ensembles,s->ensembles_suivants,s->tampon,line[current_index]);
+            Ensemble** temp = s->ensembles;
+            s->ensembles = s->ensembles_suivants;
+            s->ensembles_suivants = temp;
+            final = Automate_is_final_ensemble(a,s->ensembles[k]);
+        }
+        s->octets_lus++;
+    }
+
+    // motif vide : on le fait correspondre à la lettre de fin
+    return (!final || current_index==end+1)?end:current_index;
+}
+
+/// @brief `Motif_find_next` à au plus `m->erreurs` erreurs
+bool find_approche(const Motif* m,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* start,size_t* end)
+{
+    if(m->ancre_debut && from>0)
+        return false;
+    bool vide;
+    size_t last;
+    if(!approche_fin(m,s,line,size,from,!m->ancre_debut,m->ancre_fin,&last,&vide))
+        return false;
+    *start = m->ancre_debut?0:approche_debut(m,s,line,from,last);
+    *end = last+1;
+    return true;
+}
+
+/// @brief `Motif_match` à au plus `m->erreurs` erreurs
+bool match_approche(const Motif* m,Scratch* s,const unsigned char* line,size_t size)
+{
+    size_t end;
+    bool vide;
+    bool trouve = approche_fin(m,s,line,size,0,false,true,&end,&vide);
+    return (size==0)?vide:trouve;
+}
@@ -0,0 +1,200 @@
+/*
+    By Adrien Couvidat
+    recherche BNDM (Backward Nondeterministic DAWG Matching) d'une suite de classes de lettres :
+    chaque fenêtre de m lettres est lue de droite à gauche avec un vecteur de bits,
+    et la fenêtre avance jusqu'au dernier préfixe du motif reconnu (jusqu'à m lettres sans les lire)
+*/
+
+#include "mygrep_interne.h"
+
+/// @brief instancie la recherche de la suite de classes `positions`
+/// @param positions classe de lettres de chaque position du motif
+/// @param m nombre de positions, entre 1 et BNDM_POSITIONS_MAX
+/// @return
+Bndm* Bndm_init(const Classe* positions,size_t m)
+{
+    Bndm* b = malloc(sizeof(Bndm));
+    Memoire_prendre(sizeof(Bndm));
+    b->m = m;
+    // le bit m-1-i de masques[c] vaut 1 si la lettre c est acceptée à la position i
+    for(size_t c=0;c<256;c++)
+    {
+        b->masques[c] = 0;
+        for(size_t i=0;i<m;i++)
+            if(Classe_mem(&positions[i],c))
+                b->masques[c] |= (uint64_t)1<<(m-1-i);
+    }
+    return b;
+}
+
+void Bndm_free(Bndm* b)
+{
+    Memoire_rendre(sizeof(Bndm));
+    free(b);
+}
+
+/// @brief cherche la première occurrence du motif dans `texte`
+/// @param b
+/// @param texte
+/// @param size
+/// @param s brouillon dont les statistiques de lecture sont mises à jour
+/// @param position index de l'occurrence trouvée
+/// @return true si une occurrence a été trouvée
+bool Bndm_chercher(const Bndm* b,Scratch* s,const unsigned char* texte,size_t size,size_t* position)
+{
+    size_t m = b->m;
+    uint64_t complet = (m==64)?~(uint64_t)0:(((uint64_t)1<<m)-1);
+    uint64_t prefixe = (uint64_t)1<<(m-1);
+    size_t lectures = 0;
+    size_t pos = 0;
+    while(pos+m<=size)
+    {
+        size_t j = m;
+        size_t dernier = m;
+        uint64_t d = complet;
+        while(d!=0)
+        {
+            d &= b->masques[texte[pos+j-1]];
+            lectures++;
+            j--;
+            if(d&prefixe)
+            {
+                if(j>0)
+                {
+                    // texte[pos+j..pos+m[ est un préfixe du motif : la prochaine fenêtre commence ici
+                    dernier = j;
+                }else
+                {
+                    *position = pos;
+                    s->octets_lus += lectures;
+                    s->octets_evites += pos+m-lectures;
+                    return true;
+                }
+            }
+            d = (d<<1)&complet;
+        }
+        pos += dernier;
+    }
+    s->octets_lus += lectures;
+    s->octets_evites += size-lectures;
+    return false;
+}
+
+/// @brief détermine si `texte` est exactement une occurrence du motif
+/// @param b
+/// @param texte
+/// @param size
+/// @return
+bool Bndm_egal(const Bndm* b,const unsigned char* texte,size_t size)
+{
+    if(size!=b->m)
+        return false;
+    for(size_t i=0;i<size;i++)
+        if(!((b->masques[texte[i]]>>(size-1-i))&1))
+            return false;
+    return true;
+}
+
+/// @brief ajoute à `positions` la suite des classes de lettres lues par l'arbre, si il ne lit que des mots de même longueur
+/// formés d'une classe par position (concaténation de lettres, de classes et de '.')
+/// @param tree arbre sans ancre
+/// @param alphabet_size
+/// @param positions au moins `Tree_nb_positions(tree)` classes, ou NULL pour seulement tester l'arbre
+/// @param size nombre de positions déjà écrites, augmenté des positions de l'arbre
+/// @return
+bool Tree_positions(Tree* tree,size_t alphabet_size,Classe* positions,size_t* size)
+{
+    if(tree==NULL)
+        return false;
+    if(tree->left_chilfren==NULL)
+    {
+        Classe c;
+        Classe_clear(&c);
+        if(!Tree_classe(tree,&c,alphabet_size))
+            return false;
+        if(positions!=NULL)
+            positions[*size] = c;
+        (*size)++;
+        return true;
+    }
+    if(tree->etiquette!=SYNTAXE_OPERATOR_CONCATENATION)
+        return false;
+    return Tree_positions(tree->left_chilfren,alphabet_size,positions,size) && Tree_positions(tree->right_children,alphabet_size,positions,size);
+}
+
+/// @brief cherche dans la concaténation la plus longue suite de positions sélectives que tout motif doit contenir
+/// (facteur obligatoire), pour ne lire l'automate que sur les lignes qui le contiennent
+/// @param tree arbre sans ancre
+/// @param alphabet_size
+/// @param positions au moins `Tree_nb_positions(tree)` classes
+/// @param size nombre de positions du facteur trouvé, 0 si aucun
+/// @return le nombre de positions sélectives (au plus BNDM_LETTRES_SELECTIVES lettres) du facteur
+size_t Tree_facteur(Tree* tree,size_t alphabet_size,Classe* positions,size_t* size)
+{
+    size_t nb_noeuds = Tree_nb_noeuds(tree);
+    Tree** operandes = malloc(sizeof(Tree*)*(nb_noeuds+1));
+    size_t nb_operandes = 0;
+
+    // opérandes de la concaténation principale, de gauche à droite, sans modifier l'arbre
+    Tree** pile = malloc(sizeof(Tree*)*(nb_noeuds+1));
+    size_t hauteur = 0;
+    pile[hauteur++] = tree;
+    while(hauteur>0)
+    {
+        Tree* t = pile[--hauteur];
+        if(t->etiquette==SYNTAXE_OPERATOR_CONCATENATION && t->left_chilfren!=NULL)
+        {
+            pile[hauteur++] = t->right_children;
+            pile[hauteur++] = t->left_chilfren;
+        }else
+            operandes[nb_operandes++] = t;
+    }
+    free(pile);
+
+    size_t meilleur_score = 0;
+    size_t meilleur_size = 0;
+    Classe* suite = malloc(sizeof(Classe)*(nb_noeuds+1));
+    size_t i = 0;
+    while(i<nb_operandes)
+    {
+        // suite d'opérandes consécutifs qui lisent chacun une seule lettre
+        size_t n = 0;
+        while(i<nb_operandes && operandes[i]->left_chilfren==NULL)
+        {
+            Classe_clear(&suite[n]);
+            if(!Tree_classe(operandes[i],&suite[n],alphabet_size))
+                break;
+            n++;
+            i++;
+        }
+        if(n==0)
+        {
+            i++;
+            continue;
+        }
+
+        // les positions peu sélectives des bords sont retirées, la suite est limitée à BNDM_POSITIONS_MAX positions
+        size_t debut = 0;
+        size_t fin = n;
+        while(debut<fin && Classe_cardinal(&suite[debut])>BNDM_LETTRES_SELECTIVES)
+            debut++;
+        while(fin>debut && Classe_cardinal(&suite[fin-1])>BNDM_LETTRES_SELECTIVES)
+            fin--;
+        if(fin-debut>BNDM_POSITIONS_MAX)
+            fin = debut+BNDM_POSITIONS_MAX;
+        size_t score = 0;
+        for(size_t k=debut;k<fin;k++)
+            score += Classe_cardinal(&suite[k])<=BNDM_LETTRES_SELECTIVES;
+        if(score>meilleur_score)
+        {
+            meilleur_score = score;
+            meilleur_size = fin-debut;
+            memcpy(positions,suite+debut,sizeof(Classe)*(fin-debut));
+        }
+    }
+
+    free(suite);
+    free(operandes);
+    *size = meilleur_size;
+    return meilleur_score;
+}
@@ -0,0 +1,523 @@
+/*
+    By Adrien Couvidat
+    lecture d'un flux par blocs (voir entree.h)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ENTREE_SSE2
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#define ENTREE_AVX2
+#endif
+
+#include "mygrep.h"
+#include "memoire.h"
+#include "entree.h"
+#include "anneau.h"
+#include "lecture.h"
+#include "sortie.h"
+#include "trace.h"
+
+#if defined(MYGREP_ZLIB) && defined(ANNEAU_DISPONIBLE)
+#include <unistd.h>
+#include <zlib.h>
+#define ENTREE_GZIP // décompression disponible
+#define ENTREE_GZIP_OCTETS (3*(size_t)ANNEAU_BLOC+48*1024) // tampons de zlib (entrée, sortie double) et état d'inflate avec sa fenêtre
+#endif
+
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define ENTREE_SUIVI // --follow disponible
+#ifdef __linux__
+#include <sys/inotify.h>
+#define ENTREE_INOTIFY
+#endif
+#endif
+
+/// @brief cherche un octet nul ou hors de l'alphabet (un octet qu'aucun automate ne peut lire)
+/// @note 16 octets par comparaison avec SSE2
+/// @param data 
+/// @param size 
+/// @param alphabet_size 
+/// @return true si un tel octet est présent
+bool octets_binaires(const unsigned char* data,size_t size,size_t alphabet_size)
+{
+    // les octets valides sont 1..limite
+    unsigned char limite = (alphabet_size>255)?255:(unsigned char)(alphabet_size-1);
+    size_t i = 0;
+#ifdef ENTREE_SSE2
+    __m128i zero = _mm_setzero_si128();
+    __m128i max = _mm_set1_epi8((char)limite);
+    for(;i+16<=size;i+=16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data+i));
+        // x>limite <=> max(x,limite)!=limite
+        __m128i valide = _mm_cmpeq_epi8(_mm_max_epu8(x,max),max);
+        __m128i invalide = _mm_or_si128(_mm_cmpeq_epi8(x,zero),_mm_xor_si128(valide,_mm_set1_epi8(-1)));
+        if(_mm_movemask_epi8(invalide)!=0)
+            return true;
+    }
+#endif
+    for(;i<size;i++)
+        if(data[i]==0 || data[i]>limite)
+            return true;
+    return false;
+}
+
+/// @brief nombre de fins de ligne ('\n') de `data`
+/// @note 32 octets par comparaison avec AVX2, 16 avec SSE2
+/// @param data
+/// @param size
+/// @return
+size_t compter_lignes(const char* data,size_t size)
+{
+    size_t n = 0;
+    size_t i = 0;
+#ifdef ENTREE_AVX2
+    __m256i fin32 = _mm256_set1_epi8('\n');
+    for(;i+32<=size;i+=32)
+        n += __builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data+i)),fin32)));
+#endif
+#ifdef ENTREE_SSE2
+    __m128i fin = _mm_set1_epi8('\n');
+    for(;i+16<=size;i+=16)
+    {
+        int masque = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data+i)),fin));
+#ifdef __GNUC__
+        n += __builtin_popcount(masque);
+#else
+        for(;masque!=0;masque &= masque-1)
+            n++;
+#endif
+    }
+#endif
+    for(;i<size;i++)
+        n += data[i]=='\n';
+    return n;
+}
+
+/// @brief instancie une entrée lisant le flux `flux`
+/// @param flux flux ouvert en lecture, l'entrée standard est lue ligne par ligne
+/// @param detecter chercher les octets binaires dans chaque bloc lu (voir `octets_binaires`)
+/// @param alphabet_size 
+/// @return
+Entree* Entree_init(FILE* flux,bool detecter,size_t alphabet_size)
+{
+    Entree* e = malloc(sizeof(Entree));
+    e->flux = flux;
+    e->capacity = ENTREE_BLOC;
+    e->data = malloc(e->capacity);
+    Memoire_prendre(e->capacity);
+    e->size = 0;
+    e->decalage = 0;
+    e->position = 0;
+    e->fin = false;
+    e->interactif = (flux==stdin);
+    e->detecter = detecter;
+    e->alphabet_size = alphabet_size;
+    e->binaire = false;
+    e->anneau = NULL;
+    e->gz = NULL;
+    e->lecteur = NULL;
+    e->requete = NULL;
+    e->requete_lu = 0;
+    e->lecteur_fini = false;
+    e->suivre = false;
+    e->inotify = -1;
+    e->sortie = NULL;
+    e->emprunte = false;
+    return e;
+}
+
+/// @brief instancie une entrée qui lit un fichier déjà en mémoire, sans copie
+/// @param data octets du fichier, qui restent à l'appelant
+/// @param size
+/// @param binaire le fichier contient des octets binaires (voir `octets_binaires`)
+/// @return
+Entree* Entree_init_memoire(const char* data,size_t size,bool binaire)
+{
+    Entree* e = Entree_init(NULL,false,255);
+    free(e->data);
+    Memoire_rendre(e->capacity);
+    e->data = (char*)data;
+    e->size = size;
+    e->capacity = size;
+    e->fin = true;
+    e->binaire = binaire;
+    e->emprunte = true;
+    return e;
+}
+
+/// @brief lit l'entrée depuis les blocs d'un lecteur plutôt que depuis son flux :
+/// l'entrée correspond au prochain fichier de la file du lecteur
+/// @param e entrée sans flux dont rien n'a encore été lu
+/// @param lecteur
+void Entree_lire_depuis(Entree* e,struct Lecteur* lecteur)
+{
+    e->lecteur = lecteur;
+    e->interactif = false;
+}
+
+/// @brief à la fin du fichier, attend qu'il s'agrandisse au lieu de terminer la lecture (--follow) :
+/// la lecture reprend là où elle s'était arrêtée, et une ligne incomplète garde sa position et la partie déjà parcourue
+/// @param e entrée qui lit directement son flux (sans lecteur ni décompression), dont rien n'a encore été lu
+/// @param nom nom du fichier, surveillé avec inotify sous Linux
+/// @param sortie vidée avant chaque attente, ou NULL
+/// @return false si le suivi n'est pas disponible
+bool Entree_suivre(Entree* e,const char* nom,struct Sortie* sortie)
+{
+#ifdef ENTREE_SUIVI
+    e->suivre = true;
+    e->interactif = false;
+    e->sortie = sortie;
+#ifdef ENTREE_INOTIFY
+    // la surveillance commence avant la première lecture : aucune écriture ne peut être manquée
+    e->inotify = inotify_init1(IN_CLOEXEC);
+    if(e->inotify>=0 && inotify_add_watch(e->inotify,nom,IN_MODIFY|IN_ATTRIB|IN_MOVE_SELF|IN_DELETE_SELF)<0)
+    {
+        // le fichier est alors relu toutes les ENTREE_ATTENTE_MS millisecondes
+        close(e->inotify);
+        e->inotify = -1;
+    }
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef ENTREE_SUIVI
+/// @brief attend que le fichier suivi s'agrandisse (ou soit modifié)
+/// @note un fichier tronqué (rotation des journaux par copie) est relu depuis le début,
+/// un fichier supprimé ou renommé est lu une dernière fois puis n'est plus suivi
+/// @param e
+/// @return true si le fichier doit être lu à nouveau
+bool Entree_attendre(Entree* e)
+{
+    if(e->sortie!=NULL)
+        Sortie_flush(e->sortie);
+#ifdef ENTREE_INOTIFY
+    if(e->inotify>=0)
+    {
+        char evenements[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t n = read(e->inotify,evenements,sizeof(evenements));
+        if(n<0 && errno!=EINTR)
+            return false;
+        for(char* p=evenements;p<evenements+n;p+=sizeof(struct inotify_event)+((struct inotify_event*)p)->len)
+            if(((struct inotify_event*)p)->mask & (IN_MOVE_SELF|IN_DELETE_SELF|IN_IGNORED))
+                e->suivre = false;
+    }else
+#endif
+        usleep(ENTREE_ATTENTE_MS*1000);
+
+    struct stat infos;
+    long lu = ftell(e->flux);
+    if(fstat(fileno(e->flux),&infos)==0)
+    {
+        // le fichier ouvert reste lisible après sa suppression, mais n'a plus de nom
+        if(infos.st_nlink==0)
+            e->suivre = false;
+        if(lu>=0 && infos.st_size<lu)
+        {
+            fprintf(stderr,"Fichier tronqué : lecture reprise au début\n");
+            fseek(e->flux,0,SEEK_SET);
+        }
+    }
+    clearerr(e->flux);
+    return true;
+}
+#endif
+
+#ifdef LECTURE_DISPONIBLE
+/// @brief copie dans `data` les prochains octets du fichier courant du lecteur
+/// @param e
+/// @param data
+/// @param capacity
+/// @return le nombre d'octets copiés, 0 à la fin du fichier
+size_t Entree_lire_lecteur(Entree* e,char* data,size_t capacity)
+{
+    while(!e->lecteur_fini)
+    {
+        if(e->requete==NULL)
+        {
+            e->requete = Lecteur_suivant(e->lecteur);
+            e->requete_lu = 0;
+            if(e->requete==NULL)
+            {
+                e->lecteur_fini = true;
+                return 0;
+            }
+            if(e->requete->erreur!=0)
+                fprintf(stderr,"Impossible de lire le fichier %s : %s\n",e->lecteur->fichiers[e->requete->fichier],strerror(e->requete->erreur));
+        }
+
+        Requete* r = e->requete;
+        size_t n = r->size-e->requete_lu;
+        if(n>capacity)
+            n = capacity;
+        memcpy(data,r->data+e->requete_lu,n);
+        e->requete_lu += n;
+
+        if(e->requete_lu==r->size)
+        {
+            // bloc copié : son tampon repart pour une nouvelle lecture
+            e->lecteur_fini = r->fin_fichier;
+            Lecteur_rendre(e->lecteur,r);
+            e->requete = NULL;
+        }
+        if(n>0)
+            return n;
+    }
+    return 0;
+}
+#endif
+
+#ifdef ENTREE_GZIP
+/// @brief producteur de l'anneau d'une entrée compressée : décompresse le bloc suivant
+/// @param source flux gzip
+/// @param data 
+/// @param capacity 
+/// @return nombre d'octets décompressés, 0 à la fin du flux ou en cas d'erreur
+size_t Entree_produire_gzip(void* source,char* data,size_t capacity)
+{
+    Trace_nommer("décompression");
+    uint64_t trace = Trace_maintenant();
+    int lus = gzread((gzFile)source,data,(unsigned)capacity);
+    Trace_intervalle("décompression",trace,lus>0?(size_t)lus:0);
+    if(lus<0)
+    {
+        int erreur;
+        fprintf(stderr,"Erreur de décompression : %s\n",gzerror((gzFile)source,&erreur));
+        return 0;
+    }
+    return (size_t)lus;
+}
+#endif
+
+/// @brief lit désormais le flux de l'entrée comme un flux gzip (un flux non compressé est lu tel quel),
+/// la décompression a lieu dans un autre thread et remplit un anneau de blocs
+/// @param e entrée dont rien n'a encore été lu
+/// @return false si la décompression n'est pas disponible
+bool Entree_decompresser(Entree* e)
+{
+#ifdef ENTREE_GZIP
+    gzFile gz = gzdopen(dup(fileno(e->flux)),"rb");
+    if(gz==NULL)
+        return false;
+    gzbuffer(gz,ANNEAU_BLOC);
+    e->anneau = Anneau_init(Entree_produire_gzip,gz);
+    if(e->anneau==NULL)
+    {
+        gzclose(gz);
+        return false;
+    }
+    e->gz = gz;
+    Memoire_prendre(ENTREE_GZIP_OCTETS);
+    e->interactif = false;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// @brief libère une entrée (le flux n'est pas fermé)
+/// @param e
+void Entree_free(Entree* e)
+{
+    if(e==NULL)
+        return;
+#ifdef LECTURE_DISPONIBLE
+    // les blocs restants du fichier sont rendus pour que le lecteur passe au fichier suivant
+    while(e->lecteur!=NULL && !e->lecteur_fini)
+    {
+        if(e->requete==NULL)
+            e->requete = Lecteur_suivant(e->lecteur);
+        if(e->requete==NULL)
+            break;
+        e->lecteur_fini = e->requete->fin_fichier;
+        Lecteur_rendre(e->lecteur,e->requete);
+        e->requete = NULL;
+    }
+#endif
+#ifdef ENTREE_GZIP
+    // le producteur est arrêté avant de fermer le flux qu'il lit
+    Anneau_free(e->anneau);
+    if(e->gz!=NULL)
+    {
+        gzclose((gzFile)e->gz);
+        Memoire_rendre(ENTREE_GZIP_OCTETS);
+    }
+#endif
+#ifdef ENTREE_INOTIFY
+    if(e->inotify>=0)
+        close(e->inotify);
+#endif
+    if(!e->emprunte)
+    {
+        free(e->data);
+        Memoire_rendre(e->capacity);
+    }
+    free(e);
+}
+
+/// @brief retourne l'adresse dans le tampon de l'octet à la position `position` du flux
+/// @warning l'octet doit encore être dans le tampon
+/// @param e
+/// @param position
+/// @return
+const char* Entree_acces(Entree* e,size_t position)
+{
+    return e->data+(position-e->decalage);
+}
+
+/// @brief lit la suite du flux dans le tampon, en oubliant les octets situés avant `garder`
+/// et avant la prochaine ligne
+/// @param e
+/// @param garder position du premier octet à conserver (SIZE_MAX si seule la prochaine ligne compte)
+/// @return false si plus rien n'a pu être lu
+bool Entree_remplir(Entree* e,size_t garder)
+{
+    if(e->fin)
+        return false;
+
+    // on décale les octets encore utiles au début du tampon
+    size_t debut = (garder<e->position)?garder:e->position;
+    size_t oubli = debut-e->decalage;
+    if(oubli>0)
+    {
+        memmove(e->data,e->data+oubli,e->size-oubli);
+        e->size -= oubli;
+        e->decalage = debut;
+    }
+
+    if(e->capacity-e->size<ENTREE_BLOC)
+    {
+        if(Memoire_reserver(e->capacity))
+        {
+            e->capacity *= 2;
+            e->data = realloc(e->data,e->capacity);
+        }else if(e->size==e->capacity)
+        {
+            // la ligne ne tient plus dans le tampon : le reste de l'entrée n'est pas lu plutôt que d'épuiser la mémoire
+            fprintf(stderr,"Ligne de plus de %zu octets : au-delà de la limite de mémoire, la lecture de l'entrée s'arrête !\n",e->capacity);
+            e->fin = true;
+            return false;
+        }
+    }
+
+    uint64_t trace = Trace_maintenant();
+    size_t lus = 0;
+    if(e->interactif)
+    {
+        // on ne bloque pas sur un bloc entier : une ligne à la fois
+        int l = 0;
+        while(e->size+lus<e->capacity && l!='\n' && (l = getc(e->flux))!=EOF)
+            e->data[e->size+lus++] = (char)l;
+    }else if(e->lecteur!=NULL)
+    {
+#ifdef LECTURE_DISPONIBLE
+        lus = Entree_lire_lecteur(e,e->data+e->size,e->capacity-e->size);
+#endif
+    }else if(e->anneau!=NULL)
+    {
+#ifdef ANNEAU_DISPONIBLE
+        lus = Anneau_lire(e->anneau,e->data+e->size,e->capacity-e->size);
+#endif
+    }else
+    {
+        lus = fread(e->data+e->size,1,e->capacity-e->size,e->flux);
+#ifdef ENTREE_SUIVI
+        // fichier suivi : on attend la suite au lieu de terminer la lecture
+        while(lus==0 && e->suivre && Entree_attendre(e))
+            lus = fread(e->data+e->size,1,e->capacity-e->size,e->flux);
+#endif
+    }
+    Trace_intervalle("remplissage",trace,lus);
+
+    if(lus==0)
+    {
+        e->fin = true;
+        return false;
+    }
+    if(e->detecter && !e->binaire)
+        e->binaire = octets_binaires((const unsigned char*)e->data+e->size,lus,e->alphabet_size);
+    e->size += lus;
+    return true;
+}
+
+/// @brief lit d'un coup toutes les lignes complètes présentes dans le tampon, sans les séparer
+/// @note le bloc est lu comme une ligne, et suit les mêmes règles de validité (voir `Ligne`)
+/// @param e entrée qui n'est pas interactive
+/// @param bloc lignes séparées par '\n', sans le '\n' qui termine la dernière
+/// @return false si la fin de l'entrée est atteinte
+bool Entree_bloc(Entree* e,Ligne* bloc)
+{
+    size_t cherche = 0; // octets déjà parcourus sans trouver de fin de ligne
+    while(true)
+    {
+        const char* debut = Entree_acces(e,e->position);
+        size_t dispo = e->decalage+e->size-e->position;
+        size_t fin = dispo;
+        while(fin>cherche && debut[fin-1]!='\n')
+            fin--;
+        if(fin>cherche || e->fin)
+        {
+            bool terminee = (fin>cherche);
+            size_t size = terminee?fin-1:dispo;
+            if(!terminee && size==0)
+                return false;
+            bloc->data = debut;
+            bloc->size = size;
+            bloc->debut = e->position;
+            e->position += size+(terminee?1:0);
+            return true;
+        }
+        cherche = dispo;
+        Entree_remplir(e,SIZE_MAX);
+    }
+}
+
+/// @brief lit la prochaine ligne de l'entrée
+/// @note une ligne vide sur l'entrée standard termine la lecture
+/// @param e
+/// @param garder position dans le flux du premier octet qui doit rester accessible (SIZE_MAX si aucun)
+/// @param line ligne lue
+/// @return false si la fin de l'entrée est atteinte
+bool Entree_ligne(Entree* e,size_t garder,Ligne* line)
+{
+    size_t cherche = 0; // octets de la ligne déjà parcourus sans trouver de fin de ligne
+    while(true)
+    {
+        const char* debut = Entree_acces(e,e->position);
+        size_t dispo = e->decalage+e->size-e->position;
+        const char* fin = memchr(debut+cherche,'\n',dispo-cherche);
+        size_t size = (fin!=NULL)?(size_t)(fin-debut):dispo;
+        if(fin!=NULL || e->fin)
+        {
+            bool terminee = (fin!=NULL);
+            if(size==0 && (!terminee || e->interactif))
+            {
+                e->fin = true;
+                e->position = e->decalage+e->size;
+                return false;
+            }
+
+            line->data = debut;
+            line->size = size;
+            line->debut = e->position;
+            e->position += size+(terminee?1:0);
+            return true;
+        }
+
+        cherche = dispo;
+        Entree_remplir(e,garder);
+    }
+}
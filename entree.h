@@ -0,0 +1,67 @@
+/*
+    By Adrien Couvidat
+    lecture d'un flux par blocs : les lignes sont des portions du tampon de lecture, sans copie
+*/
+
+#ifndef ENTREE_H
+#define ENTREE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ENTREE_BLOC (64*1024) // taille minimale d'une lecture
+#define ENTREE_ATTENTE_MS 10 // sans inotify, intervalle entre deux lectures du fichier suivi
+
+/// @brief ligne lue, sans le '\n' final
+/// @note `data` pointe dans le tampon de l'entrée et n'est valide que jusqu'au prochain appel à `Entree_ligne`,
+/// `debut` (position dans le flux) reste valide tant que la ligne est conservée (voir `garder`)
+struct Ligne
+{
+    const char* data;
+    size_t size;
+    size_t debut;
+};
+typedef struct Ligne Ligne;
+
+/// @brief flux lu par blocs dans un tampon qui ne conserve que les lignes encore utiles
+struct Entree
+{
+    FILE* flux;
+    char* data;
+    size_t size;        // nombre d'octets lus présents dans `data`
+    size_t capacity;
+    size_t decalage;    // position dans le flux de data[0]
+    size_t position;    // position dans le flux du début de la prochaine ligne
+    bool fin;           // plus rien à lire dans le flux
+    bool interactif;    // entrée standard : lecture ligne par ligne, une ligne vide termine la lecture
+    bool detecter;      // chercher dans chaque bloc lu des octets qui ne peuvent pas être du texte
+    size_t alphabet_size; // un octet nul ou hors de l'alphabet marque un fichier binaire
+    bool binaire;       // un tel octet a été lu
+    struct Anneau* anneau; // blocs produits par un autre thread (décompression), ou NULL pour lire `flux` directement
+    void* gz;           // flux gzip lu par le producteur de `anneau`
+    struct Lecteur* lecteur; // lecture anticipée partagée par les fichiers d'une file, ou NULL
+    struct Requete* requete; // bloc du lecteur en cours de copie
+    size_t requete_lu;  // octets de `requete` déjà copiés
+    bool lecteur_fini;  // le dernier bloc du fichier a été rendu au lecteur
+    bool suivre;        // --follow : à la fin du fichier, on attend qu'il s'agrandisse au lieu de terminer la lecture
+    int inotify;        // descripteur inotify qui signale les écritures dans le fichier suivi, -1 sinon
+    struct Sortie* sortie; // vidée avant chaque attente, pour que les lignes trouvées soient affichées sans délai
+    bool emprunte;      // `data` appartient à l'appelant (fichier projeté en mémoire par le serveur) : rien n'est lu
+};
+typedef struct Entree Entree;
+
+bool octets_binaires(const unsigned char* data,size_t size,size_t alphabet_size);
+Entree* Entree_init(FILE* flux,bool detecter,size_t alphabet_size);
+Entree* Entree_init_memoire(const char* data,size_t size,bool binaire);
+void Entree_free(Entree* e);
+bool Entree_decompresser(Entree* e);
+void Entree_lire_depuis(Entree* e,struct Lecteur* lecteur);
+bool Entree_suivre(Entree* e,const char* nom,struct Sortie* sortie);
+bool Entree_remplir(Entree* e,size_t garder);
+bool Entree_ligne(Entree* e,size_t garder,Ligne* line);
+bool Entree_bloc(Entree* e,Ligne* bloc);
+size_t compter_lignes(const char* data,size_t size);
+const char* Entree_acces(Entree* e,size_t position);
+
+#endif // ENTREE_H
@@ -0,0 +1,493 @@
+/*
+    By Adrien Couvidat
+    lecture anticipée d'une file de fichiers (voir lecture.h)
+*/
+
+#define _GNU_SOURCE // pread, MAP_POPULATE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mygrep.h"
+#include "memoire.h"
+#include "lecture.h"
+#include "trace.h"
+
+#ifdef LECTURE_DISPONIBLE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef LECTURE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+/*
+    Préparation des requêtes (commun aux deux méthodes de lecture)
+*/
+
+/// @brief prépare la requête du prochain bloc de la file de fichiers, en ouvrant le fichier si nécessaire
+/// @param l
+/// @param r requête libre
+/// @return false si il n'y a plus rien à lire
+bool Lecteur_preparer(Lecteur* l,Requete* r)
+{
+    if(l->prochain_fichier>=l->nb_fichiers)
+        return false;
+
+    r->fichier = l->prochain_fichier;
+    r->size = 0;
+    r->erreur = 0;
+    r->terminee = false;
+    r->fin_fichier = false;
+
+    if(l->fd<0)
+    {
+        struct stat infos;
+        l->fd = open(l->fichiers[l->prochain_fichier],O_RDONLY);
+        if(l->fd>=0 && fstat(l->fd,&infos)!=0)
+        {
+            close(l->fd);
+            l->fd = -1;
+        }
+        if(l->fd<0)
+        {
+            // l'erreur est rendue à sa place dans la file
+            r->fd = -1;
+            r->erreur = errno;
+            r->attendu = 0;
+            r->terminee = true;
+            r->fin_fichier = true;
+            l->prochain_fichier++;
+            return true;
+        }
+        l->taille = (size_t)infos.st_size;
+        l->prochain_offset = 0;
+    }
+
+    r->fd = l->fd;
+    r->offset = l->prochain_offset;
+    r->attendu = LECTURE_BLOC;
+    if(r->offset+LECTURE_BLOC>=l->taille)
+    {
+        // dernier bloc : le fichier sera fermé quand ce bloc sera rendu
+        r->attendu = l->taille-r->offset;
+        r->fin_fichier = true;
+        l->fd = -1;
+        l->prochain_fichier++;
+    }
+    l->prochain_offset += r->attendu;
+    if(r->attendu==0)
+        r->terminee = true; // fichier vide
+    return true;
+}
+
+/// @brief prend en compte le résultat d'une lecture
+/// @param r
+/// @param resultat nombre d'octets lus ou -errno
+/// @return true si la requête est terminée, false si il reste des octets à lire
+bool Requete_lue(Requete* r,long resultat)
+{
+    if(resultat<0)
+    {
+        r->erreur = (int)-resultat;
+        r->terminee = true;
+    }else
+    {
+        r->size += (size_t)resultat;
+        // resultat==0 : le fichier a raccourci depuis son ouverture
+        r->terminee = (resultat==0 || r->size==r->attendu);
+    }
+    return r->terminee;
+}
+
+/*
+    Lecture avec io_uring
+*/
+
+#ifdef LECTURE_IO_URING
+
+/// @brief ajoute à l'anneau de soumission la lecture de la partie non lue de `r`
+/// @param l
+/// @param r
+void Lecteur_io_uring_soumettre(Lecteur* l,Requete* r)
+{
+    unsigned tail = *l->sq_tail;
+    unsigned index = tail & *l->sq_mask;
+    struct io_uring_sqe* sqe = &l->sqes[index];
+    memset(sqe,0,sizeof(struct io_uring_sqe));
+    sqe->opcode = l->fixes?IORING_OP_READ_FIXED:IORING_OP_READ;
+    sqe->fd = r->fd;
+    sqe->off = r->offset+r->size;
+    sqe->addr = (unsigned long long)(r->data+r->size);
+    sqe->len = (unsigned)(r->attendu-r->size);
+    sqe->buf_index = (unsigned short)(r-l->requetes);
+    sqe->user_data = (unsigned long long)(r-l->requetes);
+    l->sq_array[index] = index;
+    __atomic_store_n(l->sq_tail,tail+1,__ATOMIC_RELEASE);
+    l->a_soumettre++;
+}
+
+/// @brief soumet les lectures en attente et attend au plus `attendre` résultats
+/// @param l
+/// @param attendre
+void Lecteur_io_uring_enter(Lecteur* l,unsigned attendre)
+{
+    while(syscall(__NR_io_uring_enter,l->ring_fd,l->a_soumettre,attendre,(attendre>0)?IORING_ENTER_GETEVENTS:0,NULL,0)<0)
+    {
+        if(errno!=EINTR && errno!=EAGAIN && errno!=EBUSY)
+        {
+            perror("io_uring_enter");
+            exit(1);
+        }
+    }
+    l->a_soumettre = 0;
+}
+
+/// @brief traite les lectures terminées, et soumet à nouveau les lectures incomplètes
+/// @param l
+void Lecteur_io_uring_recolter(Lecteur* l)
+{
+    unsigned head = *l->cq_head;
+    while(head!=__atomic_load_n(l->cq_tail,__ATOMIC_ACQUIRE))
+    {
+        struct io_uring_cqe* cqe = &l->cqes[head & *l->cq_mask];
+        Requete* r = &l->requetes[cqe->user_data];
+        if(!Requete_lue(r,cqe->res))
+            Lecteur_io_uring_soumettre(l,r);
+        else
+            Trace_intervalle_piste("io_uring",(size_t)cqe->user_data,"lecture",r->trace,r->size);
+        head++;
+    }
+    __atomic_store_n(l->cq_head,head,__ATOMIC_RELEASE);
+}
+
+/// @brief crée l'anneau io_uring du lecteur et lui enregistre les tampons des requêtes
+/// @param l
+/// @return false si io_uring n'est pas disponible
+bool Lecteur_io_uring_init(Lecteur* l)
+{
+    struct io_uring_params p;
+    memset(&p,0,sizeof(p));
+    l->ring_fd = (int)syscall(__NR_io_uring_setup,(unsigned)l->profondeur,&p);
+    if(l->ring_fd<0)
+        return false;
+
+    l->sq_octets = p.sq_off.array+p.sq_entries*sizeof(unsigned);
+    l->cq_octets = p.cq_off.cqes+p.cq_entries*sizeof(struct io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(l->cq_octets>l->sq_octets)
+            l->sq_octets = l->cq_octets;
+        l->cq_octets = 0;
+    }
+    l->sqes_octets = p.sq_entries*sizeof(struct io_uring_sqe);
+
+    l->sq_ptr = mmap(NULL,l->sq_octets,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,l->ring_fd,IORING_OFF_SQ_RING);
+    l->cq_ptr = (l->cq_octets==0)?l->sq_ptr:mmap(NULL,l->cq_octets,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,l->ring_fd,IORING_OFF_CQ_RING);
+    l->sqes = mmap(NULL,l->sqes_octets,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,l->ring_fd,IORING_OFF_SQES);
+    if(l->sq_ptr==MAP_FAILED || l->cq_ptr==MAP_FAILED || l->sqes==MAP_FAILED)
+    {
+        if(l->sq_ptr!=MAP_FAILED)munmap(l->sq_ptr,l->sq_octets);
+        if(l->cq_octets!=0 && l->cq_ptr!=MAP_FAILED)munmap(l->cq_ptr,l->cq_octets);
+        if(l->sqes!=MAP_FAILED)munmap(l->sqes,l->sqes_octets);
+        close(l->ring_fd);
+        return false;
+    }
+
+    char* sq = l->sq_ptr;
+    char* cq = l->cq_ptr;
+    l->sq_tail = (unsigned*)(sq+p.sq_off.tail);
+    l->sq_mask = (unsigned*)(sq+p.sq_off.ring_mask);
+    l->sq_array = (unsigned*)(sq+p.sq_off.array);
+    l->cq_head = (unsigned*)(cq+p.cq_off.head);
+    l->cq_tail = (unsigned*)(cq+p.cq_off.tail);
+    l->cq_mask = (unsigned*)(cq+p.cq_off.ring_mask);
+    l->cqes = (struct io_uring_cqe*)(cq+p.cq_off.cqes);
+    l->a_soumettre = 0;
+
+    // tampons enregistrés : le noyau n'a pas à les reprojeter à chaque lecture (sinon simple IORING_OP_READ)
+    struct iovec* iovecs = malloc(sizeof(struct iovec)*l->profondeur);
+    for(size_t i=0;i<l->profondeur;i++)
+    {
+        iovecs[i].iov_base = l->requetes[i].data;
+        iovecs[i].iov_len = LECTURE_BLOC;
+    }
+    l->fixes = syscall(__NR_io_uring_register,l->ring_fd,IORING_REGISTER_BUFFERS,iovecs,(unsigned)l->profondeur)==0;
+    free(iovecs);
+    return true;
+}
+
+void Lecteur_io_uring_free(Lecteur* l)
+{
+    // on attend la fin des lectures en cours avant de libérer leurs tampons
+    size_t restantes = 0;
+    for(size_t i=0;i<l->en_cours;i++)
+        if(!l->requetes[(l->tete+i)%l->profondeur].terminee)
+            restantes++;
+    while(restantes>0)
+    {
+        Lecteur_io_uring_enter(l,1);
+        unsigned head = *l->cq_head;
+        while(head!=__atomic_load_n(l->cq_tail,__ATOMIC_ACQUIRE))
+        {
+            restantes--;
+            head++;
+        }
+        __atomic_store_n(l->cq_head,head,__ATOMIC_RELEASE);
+    }
+
+    munmap(l->sqes,l->sqes_octets);
+    if(l->cq_octets!=0)
+        munmap(l->cq_ptr,l->cq_octets);
+    munmap(l->sq_ptr,l->sq_octets);
+    close(l->ring_fd);
+}
+
+#endif // LECTURE_IO_URING
+
+/*
+    Lecture avec pread dans un thread
+*/
+
+/// @brief boucle du thread de lecture : lit les requêtes soumises dans l'ordre
+/// @param arg le lecteur
+/// @return
+void* Lecteur_thread(void* arg)
+{
+    Lecteur* l = arg;
+    Trace_nommer("lecture (pread)");
+    pthread_mutex_lock(&l->verrou);
+    while(true)
+    {
+        while(l->en_attente==0 && !l->arret)
+            pthread_cond_wait(&l->changement,&l->verrou);
+        if(l->arret)
+            break;
+        Requete* r = &l->requetes[l->a_lire];
+        pthread_mutex_unlock(&l->verrou);
+
+        // la requête n'appartient qu'au thread de lecture tant qu'elle n'est pas terminée
+        // (une requête déjà terminée, erreur d'ouverture ou fichier vide, est seulement passée)
+        bool terminee = r->terminee;
+        r->trace = Trace_maintenant();
+        while(!terminee)
+        {
+            ssize_t lus = pread(r->fd,r->data+r->size,r->attendu-r->size,(off_t)(r->offset+r->size));
+            if(lus<0 && errno==EINTR)
+                continue;
+            terminee = Requete_lue(r,(lus<0)?-errno:(long)lus);
+        }
+        Trace_intervalle("lecture",r->trace,r->size);
+
+        pthread_mutex_lock(&l->verrou);
+        l->a_lire = (l->a_lire+1)%l->profondeur;
+        l->en_attente--;
+        pthread_cond_broadcast(&l->changement);
+    }
+    pthread_mutex_unlock(&l->verrou);
+    return NULL;
+}
+
+/*
+    Interface du lecteur
+*/
+
+/// @brief prépare et soumet des requêtes tant qu'il y a des requêtes libres et des blocs à lire
+/// @param l
+void Lecteur_soumettre(Lecteur* l)
+{
+    if(!l->io_uring)
+        pthread_mutex_lock(&l->verrou);
+
+    while(l->en_cours<l->profondeur)
+    {
+        Requete* r = &l->requetes[(l->tete+l->en_cours)%l->profondeur];
+        if(!Lecteur_preparer(l,r))
+            break;
+        l->en_cours++;
+        r->trace = Trace_maintenant();
+
+        if(l->io_uring)
+        {
+#ifdef LECTURE_IO_URING
+            if(!r->terminee)
+                Lecteur_io_uring_soumettre(l,r);
+#endif
+        }else
+        {
+            // une requête déjà terminée (erreur, fichier vide) passe quand même par le thread pour garder l'ordre
+            l->en_attente++;
+        }
+    }
+
+    if(l->io_uring)
+    {
+#ifdef LECTURE_IO_URING
+        if(l->a_soumettre>0)
+            Lecteur_io_uring_enter(l,0);
+#endif
+    }else
+    {
+        pthread_cond_broadcast(&l->changement);
+        pthread_mutex_unlock(&l->verrou);
+    }
+}
+
+/// @brief instancie un lecteur et commence la lecture de la file de fichiers
+/// @param fichiers noms des fichiers, lus dans l'ordre
+/// @param nb_fichiers
+/// @param profondeur nombre maximal de blocs lus à l'avance (au moins 1)
+/// @return le lecteur, ou NULL si aucune méthode de lecture n'est disponible
+Lecteur* Lecteur_init(char** fichiers,size_t nb_fichiers,size_t profondeur)
+{
+    Lecteur* l = malloc(sizeof(Lecteur));
+    l->fichiers = fichiers;
+    l->nb_fichiers = nb_fichiers;
+    l->profondeur = (profondeur==0)?1:profondeur;
+    // au-delà de la limite de mémoire, moins de blocs sont lus à l'avance (au moins un)
+    while(l->profondeur>1 && !Memoire_reserver((size_t)LECTURE_BLOC*l->profondeur))
+        l->profondeur /= 2;
+    if(l->profondeur==1)
+        Memoire_prendre(LECTURE_BLOC);
+    l->requetes = malloc(sizeof(Requete)*l->profondeur);
+    l->tampon = malloc((size_t)LECTURE_BLOC*l->profondeur);
+    for(size_t i=0;i<l->profondeur;i++)
+        l->requetes[i].data = l->tampon+i*(size_t)LECTURE_BLOC;
+    l->tete = 0;
+    l->en_cours = 0;
+    l->prochain_fichier = 0;
+    l->prochain_offset = 0;
+    l->fd = -1;
+    l->taille = 0;
+    l->a_lire = 0;
+    l->en_attente = 0;
+    l->arret = false;
+
+    l->io_uring = false;
+#ifdef LECTURE_IO_URING
+    l->io_uring = Lecteur_io_uring_init(l);
+#endif
+    if(!l->io_uring)
+    {
+        pthread_mutex_init(&l->verrou,NULL);
+        pthread_cond_init(&l->changement,NULL);
+        if(pthread_create(&l->thread,NULL,Lecteur_thread,l)!=0)
+        {
+            pthread_mutex_destroy(&l->verrou);
+            pthread_cond_destroy(&l->changement);
+            free(l->tampon);
+            Memoire_rendre((size_t)LECTURE_BLOC*l->profondeur);
+            free(l->requetes);
+            free(l);
+            return NULL;
+        }
+    }
+
+    Lecteur_soumettre(l);
+    return l;
+}
+
+/// @brief retourne le prochain bloc de la file de fichiers, dans l'ordre, en attendant la fin de sa lecture
+/// @param l
+/// @return la requête terminée, à rendre avec `Lecteur_rendre`, ou NULL si tous les fichiers ont été lus
+Requete* Lecteur_suivant(Lecteur* l)
+{
+    if(l->en_cours==0)
+        return NULL;
+    Requete* r = &l->requetes[l->tete];
+    uint64_t attente = Trace_maintenant();
+
+    if(l->io_uring)
+    {
+#ifdef LECTURE_IO_URING
+        Lecteur_io_uring_recolter(l);
+        if(!r->terminee)
+        {
+            while(!r->terminee)
+            {
+                Lecteur_io_uring_enter(l,1);
+                Lecteur_io_uring_recolter(l);
+            }
+            Trace_intervalle("attente lecture",attente,r->size);
+        }
+        // les lectures incomplètes soumises à nouveau par la récolte
+        if(l->a_soumettre>0)
+            Lecteur_io_uring_enter(l,0);
+#endif
+    }else
+    {
+        pthread_mutex_lock(&l->verrou);
+        bool attendu = false;
+        while(l->en_attente>0 && l->a_lire==l->tete)
+        {
+            pthread_cond_wait(&l->changement,&l->verrou);
+            attendu = true;
+        }
+        pthread_mutex_unlock(&l->verrou);
+        if(attendu)
+            Trace_intervalle("attente lecture",attente,r->size);
+    }
+    return r;
+}
+
+/// @brief rend au lecteur le bloc retourné par `Lecteur_suivant`, son tampon sert à une nouvelle lecture
+/// @param l
+/// @param r
+void Lecteur_rendre(Lecteur* l,Requete* r)
+{
+    if(r->fin_fichier && r->fd>=0)
+        close(r->fd);
+
+    if(!l->io_uring)
+        pthread_mutex_lock(&l->verrou);
+    l->tete = (l->tete+1)%l->profondeur;
+    l->en_cours--;
+    if(!l->io_uring)
+        pthread_mutex_unlock(&l->verrou);
+
+    Lecteur_soumettre(l);
+}
+
+void Lecteur_free(Lecteur* l)
+{
+    if(l==NULL)
+        return;
+
+    if(l->io_uring)
+    {
+#ifdef LECTURE_IO_URING
+        Lecteur_io_uring_free(l);
+#endif
+    }else
+    {
+        pthread_mutex_lock(&l->verrou);
+        l->arret = true;
+        pthread_cond_broadcast(&l->changement);
+        pthread_mutex_unlock(&l->verrou);
+        pthread_join(l->thread,NULL);
+        pthread_mutex_destroy(&l->verrou);
+        pthread_cond_destroy(&l->changement);
+    }
+
+    // fichiers encore ouverts par les requêtes non rendues
+    for(size_t i=0;i<l->en_cours;i++)
+    {
+        Requete* r = &l->requetes[(l->tete+i)%l->profondeur];
+        if(r->fin_fichier && r->fd>=0)
+            close(r->fd);
+    }
+    if(l->fd>=0)
+        close(l->fd);
+    free(l->tampon);
+    Memoire_rendre((size_t)LECTURE_BLOC*l->profondeur);
+    free(l->requetes);
+    free(l);
+}
+
+#endif // LECTURE_DISPONIBLE
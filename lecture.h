@@ -0,0 +1,97 @@
+/*
+    By Adrien Couvidat
+    lecture anticipée d'une file de fichiers : plusieurs lectures de blocs sont en cours à la fois,
+    sur le fichier courant et sur les suivants, et les blocs sont rendus dans l'ordre des fichiers
+    avec io_uring sous Linux, sinon avec pread dans un thread de lecture
+*/
+
+#ifndef LECTURE_H
+#define LECTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#define LECTURE_DISPONIBLE // open/pread et les threads POSIX sont disponibles
+#if defined(__linux__) && !defined(LECTURE_SANS_IO_URING)
+#define LECTURE_IO_URING
+#endif
+#endif
+
+#define LECTURE_BLOC (1024*1024)
+#define LECTURE_PROFONDEUR 8 // nombre de lectures en cours par défaut
+
+#ifdef LECTURE_DISPONIBLE
+
+/// @brief lecture d'un bloc d'un fichier, dans un tampon qui appartient au lecteur
+struct Requete
+{
+    char* data;
+    size_t fichier;     // index du fichier dans la file
+    int fd;
+    size_t offset;      // position du bloc dans le fichier
+    size_t attendu;     // nombre d'octets demandés
+    size_t size;        // nombre d'octets lus
+    int erreur;         // errno de l'ouverture ou de la lecture, 0 si aucune
+    bool terminee;
+    bool fin_fichier;   // dernier bloc du fichier
+    uint64_t trace;     // --trace : début de la lecture (voir `Trace_maintenant`)
+};
+typedef struct Requete Requete;
+
+/// @brief file de fichiers lus par blocs de `LECTURE_BLOC` octets, au plus `profondeur` blocs à la fois
+/// les requêtes forment une file circulaire dans l'ordre de lecture, leurs tampons sont alloués une seule fois
+struct Lecteur
+{
+    char** fichiers;
+    size_t nb_fichiers;
+    size_t profondeur;
+    Requete* requetes;
+    char* tampon;       // tampons des requêtes, `profondeur` blocs contigus
+    size_t tete;        // index de la plus ancienne requête
+    size_t en_cours;    // nombre de requêtes soumises et pas encore rendues
+
+    // prochain bloc à demander
+    size_t prochain_fichier;
+    size_t prochain_offset;
+    int fd;
+    size_t taille;      // taille du fichier `prochain_fichier`
+
+    bool io_uring;      // sinon un thread lit les requêtes avec pread
+#ifdef LECTURE_IO_URING
+    int ring_fd;
+    bool fixes;         // tampons enregistrés auprès du noyau
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ptr;
+    size_t sq_octets;
+    void* cq_ptr;
+    size_t cq_octets;
+    size_t sqes_octets;
+    unsigned a_soumettre; // entrées ajoutées depuis le dernier io_uring_enter
+#endif
+    pthread_t thread;
+    pthread_mutex_t verrou;
+    pthread_cond_t changement;
+    size_t a_lire;      // index de la prochaine requête à lire par le thread
+    size_t en_attente;  // requêtes soumises au thread et pas encore lues
+    bool arret;
+};
+typedef struct Lecteur Lecteur;
+
+Lecteur* Lecteur_init(char** fichiers,size_t nb_fichiers,size_t profondeur);
+void Lecteur_free(Lecteur* l);
+Requete* Lecteur_suivant(Lecteur* l);
+void Lecteur_rendre(Lecteur* l,Requete* r);
+
+#endif // LECTURE_DISPONIBLE
+
+#endif // LECTURE_H
@@ -0,0 +1,3008 @@
+/*
+    By Adrien Couvidat
+    libmygrep : recherche de motifs décrits par une expression rationnelle
+    (arbre syntaxique, automate de Thomson et lecture du texte)
+    l'interface publique est décrite dans mygrep.h
+*/
+
+#include "mygrep_interne.h"
+
+/*
+    Classes de lettres
+*/
+
+void Classe_clear(Classe* c)
+{
+    memset(c->bits,0,sizeof(c->bits));
+}
+
+void Classe_add(Classe* c,Lettre l)
+{
+    if(l<256)
+        c->bits[l/64] |= (uint64_t)1<<(l%64);
+}
+
+/// @brief ajoute les lettres de `debut` à `fin` (incluses)
+void Classe_add_range(Classe* c,Lettre debut,Lettre fin)
+{
+    for(Lettre l=debut;l<=fin && l<256;l++)
+        Classe_add(c,l);
+}
+
+void Classe_union(Classe* dest,Classe* source)
+{
+    for(size_t i=0;i<4;i++)
+        dest->bits[i] |= source->bits[i];
+}
+
+/// @brief remplace une classe par son complémentaire (la lettre 0 est réservée aux epsilon transitions)
+void Classe_complement(Classe* c)
+{
+    for(size_t i=0;i<4;i++)
+        c->bits[i] = ~c->bits[i];
+    c->bits[0] &= ~(uint64_t)1;
+}
+
+bool Classe_mem(const Classe* c,Lettre l)
+{
+    return l<256 && ((c->bits[l/64]>>(l%64))&1);
+}
+
+size_t Classe_cardinal(const Classe* c)
+{
+    size_t n = 0;
+    for(Lettre l=0;l<256;l++)
+        n += Classe_mem(c,l);
+    return n;
+}
+
+/// @brief affiche une lettre, sous la forme \xNN si elle n'est pas imprimable
+void Lettre_print(Lettre l)
+{
+    if(l>=' ' && l<127)
+        printf("%c",(char)l);
+    else
+        printf("\\x%02lx",l);
+}
+
+/// @brief affiche une classe sous la forme [a-z...]
+void Classe_print(Classe* c)
+{
+    printf("[");
+    for(Lettre l=0;l<256;l++)
+    {
+        if(!Classe_mem(c,l))
+            continue;
+        Lettre fin = l;
+        while(fin+1<256 && Classe_mem(c,fin+1))
+            fin++;
+        Lettre_print(l);
+        if(fin>l+1)
+            printf("-");
+        if(fin>l)
+            Lettre_print(fin);
+        l = fin;
+    }
+    printf("]");
+}
+
+/*
+    Première Partie
+    Creation d'un arbre syntaxique depuis une expression rationnelle sous forme de chaîne de caractère
+*/
+
+Lettre OPERATORS[] = {SYNTAXE_OPERATOR_ETOILE,SYNTAXE_OPERATOR_CONCATENATION,SYNTAXE_OPERATOR_UNION};
+
+bool is_operator(Lettre l)
+{
+    return  l==SYNTAXE_OPERATOR_CONCATENATION ||
+            l==SYNTAXE_OPERATOR_ETOILE ||
+            l==SYNTAXE_OPERATOR_JOKER ||
+            l==SYNTAXE_OPERATOR_REPETITION ||
+            l==SYNTAXE_OPERATOR_UNION;
+}
+
+bool is_operator_binaire(Lettre l)
+{
+    return  l==SYNTAXE_OPERATOR_CONCATENATION ||
+            l==SYNTAXE_OPERATOR_UNION;
+}
+
+bool is_operator_unaire(Lettre l)
+{
+    return  l==SYNTAXE_OPERATOR_ETOILE ||
+            l==SYNTAXE_OPERATOR_JOKER ||
+            l==SYNTAXE_OPERATOR_REPETITION ;
+}
+
+Tree* Tree_init(Lettre etiquette,Tree* left,Tree* right)
+{
+    Tree* t = malloc(sizeof(Tree));
+    t->etiquette = etiquette;
+    t->left_chilfren = left;
+    t->right_children = right;
+    t->min = 0;
+    t->max = 0;
+    Classe_clear(&t->classe);
+    return t;
+}
+
+void Tree_free(Tree* tree)
+{
+    if(tree==NULL)
+        return;
+
+    if(tree->right_children!=NULL)
+    {
+        Tree_free(tree->right_children);
+    }
+    if(tree->left_chilfren!=NULL)
+    {
+        Tree_free(tree->left_chilfren);
+    }
+    free(tree);
+}
+
+/// @brief affiche l'arbre dans le terminal
+/// @param tree arbre à afficher (peut-être NULL)
+/// @return 
+void Tree_print(Tree* tree)
+{
+    if(tree==NULL)
+        return;
+
+    if(tree->etiquette==SYNTAXE_ANCRE_DEBUT && tree->left_chilfren!=NULL)
+    {
+        printf("^(");
+        Tree_print(tree->left_chilfren);
+        printf(")");
+        return;
+    }
+
+    if(tree->left_chilfren!=NULL)
+    {
+        printf("(");
+        Tree_print(tree->left_chilfren);
+        printf(")");
+    }
+    //printf("%c[%ld]",(char)tree->etiquette,tree->etiquette);
+    if(tree->etiquette==SYNTAXE_OPERATOR_CLASSE)
+    {
+        Classe_print(&tree->classe);
+    }else if(tree->etiquette==SYNTAXE_OPERATOR_REPETITION)
+    {
+        if(tree->max==REPETITION_INFINIE)
+            printf("{%ld,}",tree->min);
+        else
+            printf("{%ld,%ld}",tree->min,tree->max);
+    }else
+        printf("%c",(char)tree->etiquette);
+    if(tree->right_children!=NULL)
+    {
+        printf("(");
+        Tree_print(tree->right_children);
+        printf(")");
+    }
+
+    fflush(stdout);
+}
+
+/// @brief retourne si un arbre est réduit à sa racine
+/// @param tree 
+/// @return 
+bool is_racine(Tree* tree)
+{
+    return tree->left_chilfren==NULL && tree->right_children==NULL;
+}
+
+
+/// @brief retourne le premier Tree* non NULL dans `er` et le remplace par NULL
+Tree* get_next_tree(Tree** er,size_t er_size)
+{
+    for(size_t i=0;i<er_size;i++)
+    {
+        if(er[i]!=NULL)
+        {
+            Tree* temp = er[i];
+            er[i] = NULL;
+            return temp;
+        }
+    }
+    return NULL;
+}
+
+/// @brief rattache chaque opérateur unaire à l'arbre qui le précède, de gauche à droite
+/// (ainsi a?* donne (a?)* et a*{2} donne (a*){2})
+int operators_unaires_merge(Tree** er,size_t er_size)
+{
+    int count = 0;
+    Tree* last_tree = NULL;
+    size_t last_tree_index = 0;
+    for(size_t index=0;index<er_size;index++)
+    {
+        if(er[index] == NULL)
+        {
+            continue;
+        }
+        if(is_operator_unaire(er[index]->etiquette) && is_racine(er[index]))
+        {
+            if(last_tree==NULL)
+            {
+                fprintf(Motif_flux_erreurs(),"Mauvaise syntaxe dans l'utilisation de l'opérateur : %c\n",(char)er[index]->etiquette);
+                return -1;
+            }
+
+            er[index]->left_chilfren = last_tree;
+            er[last_tree_index] = NULL;
+            count++;
+
+            last_tree_index = index;
+            last_tree = er[index];
+        }else
+        {
+            last_tree = er[index];
+            last_tree_index = index;
+        }
+    }
+
+    return count;
+}
+
+int operator_binaire_merge(Tree** er,size_t er_size,Lettre operator)
+{
+    int count = 0;
+    Tree* last_tree = NULL;
+    size_t last_tree_index = 0;
+    for(size_t index=0;index<er_size;index++)
+    {
+        if(er[index] == NULL)
+        {
+            continue;
+        }
+        if(er[index]->etiquette == operator && is_racine(er[index]))
+        {
+            Tree* next_tree = get_next_tree(&er[index+1],er_size-index-1);
+            if(last_tree==NULL || next_tree==NULL)
+            {
+                fprintf(Motif_flux_erreurs(),"Mauvaise syntaxe dans l'utilisation de l'opérateur : %c\n",(char)operator);
+                return -1;
+            }
+
+            er[index]->left_chilfren = last_tree;
+            er[index]->right_children = next_tree;
+            er[last_tree_index] = NULL;
+            count++;
+
+            last_tree_index = index;
+            last_tree = er[index];
+        }else
+        {
+            last_tree = er[index];
+            last_tree_index = index;
+        }
+    }
+
+    return count;
+}
+
+Tree* merge_forest(Tree** forest,size_t forest_size);
+
+/// @brief fusionne les arbres entre la parenthèse ouvrante à l'index 0 et sa parenthèse fermante associée
+/// @param regular_trees un tableau d'arbre dont le premier est réduit à une racine dont l'étiquette est '('
+/// @param size la taille du tableau dans lequel la parenthèse fermante doit-être cherchée
+/// @return le nombre d'arbre fusionné (et donc le nombre d'index utilisé)
+size_t parentheses_merge(Tree** regular_trees,size_t size)
+{
+    if(regular_trees[0] == NULL || regular_trees[0]->etiquette!='(')
+    {
+        fprintf(Motif_flux_erreurs(),"mauvaise utilisation de parentheses_merge");
+        return 0;
+    }
+
+    // printf("parenthèse_merge de [");
+    // for(size_t i=0;i<size;i++)
+    //     if(regular_trees[i]!=NULL)
+    //         printf("%c;",regular_trees[i]->etiquette);
+    //     else
+    //         printf("NULL;");
+    // printf("]\n");
+
+    for(size_t index = 1; index<size;index++)
+    {
+        if(regular_trees[index]==NULL)
+            continue;
+
+        if(regular_trees[index]->etiquette == ')')
+        {
+            // on a trouvé la parenthèse fermante, on libère les arbres associés a '(' ')'
+            Tree_free(regular_trees[0]);
+            Tree_free(regular_trees[index]);
+
+            // reste à fusionner les arbres des index 1 à index-1 à l'aide de l'analyse des opérateur
+            Tree* t = merge_forest(&regular_trees[1],index-1);
+            
+            // on met à NULL les arbres utilisés
+            regular_trees[0]=NULL;
+            regular_trees[index]=NULL;
+                
+            // on met l'abre issu de la fusion dans la première case de notre tableau
+            regular_trees[0] = t;
+
+            // on retourne le nombre de case utilisées
+            return index;
+        }
+        else if(regular_trees[index]->etiquette == '(')
+        {
+            // on trouvé une autre parenthèse ouvrante imbiqué
+            // on utilise un appel récursif pour s'occuper de celle-ci
+            // on saute la zone de cette parenthèse pour continuer notre recherche après
+            size_t saut = parentheses_merge(&regular_trees[index],size-index-1);
+            if(saut==0)
+            {
+                // problème de parenthèsage
+                return 0;
+            }
+
+            index+= saut;
+        }else
+        {
+            // autres caractère on ne fait rien
+        }
+    }
+
+    // aucune parenthèse fermante trouvée
+    // problème
+    fprintf(Motif_flux_erreurs(),"Aucune parenthèse fermante trouvée, vérifiez votre usage de parenthèse_merge ou votre parenthèsage !\n");
+    return 0;    
+}
+
+size_t str_len(Lettre* str)
+{
+    size_t size = 0;
+    while (str[size]!=0)
+    {
+        size++;
+    }
+    return size;
+}
+
+/// @brief lit un nombre décimal dans `er` à partir de l'index `*index`
+/// @return false si aucun chiffre n'est lu ou si le nombre dépasse REPETITION_MAX
+bool read_nombre(Lettre* er,size_t* index,size_t* nombre)
+{
+    size_t debut = *index;
+    *nombre = 0;
+    while(er[*index]>='0' && er[*index]<='9')
+    {
+        *nombre = *nombre*10 + (er[*index]-'0');
+        if(*nombre>REPETITION_MAX)
+            return false;
+        (*index)++;
+    }
+    return *index>debut;
+}
+
+/// @brief lit une répétition "{n}", "{n,}" ou "{n,m}" dont l'accolade ouvrante est `er[*index]`
+/// @param er 
+/// @param index avancé jusqu'à l'accolade fermante
+/// @return un arbre réduit à sa racine portant les bornes de la répétition, NULL en cas d'erreur de syntaxe
+Tree* read_repetition(Lettre* er,size_t* index)
+{
+    size_t i = *index+1;
+    size_t min,max;
+    if(!read_nombre(er,&i,&min))
+        goto ERREUR;
+
+    if(er[i]==',')
+    {
+        i++;
+        if(er[i]=='}')
+            max = REPETITION_INFINIE;
+        else if(!read_nombre(er,&i,&max) || max<min)
+            goto ERREUR;
+    }else
+    {
+        max = min;
+    }
+    if(er[i]!='}')
+        goto ERREUR;
+
+    *index = i;
+    Tree* t = Tree_init(SYNTAXE_OPERATOR_REPETITION,NULL,NULL);
+    t->min = min;
+    t->max = max;
+    return t;
+
+    ERREUR:
+    fprintf(Motif_flux_erreurs(),"Mauvaise syntaxe dans l'utilisation de l'opérateur : %c (attendu {n}, {n,} ou {n,m} avec n<=m<=%d)\n",SYNTAXE_OPERATOR_REPETITION,REPETITION_MAX);
+    return NULL;
+}
+
+/// @brief lit une classe de lettres "[...]" dont le crochet ouvrant est `er[*index]`
+/// "[^...]" désigne le complémentaire, "a-z" un intervalle, 
+/// ']' en première position et '-' en première ou dernière position sont des lettres
+/// @param er 
+/// @param index avancé jusqu'au crochet fermant
+/// @return un arbre réduit à sa racine portant les lettres de la classe, NULL en cas d'erreur de syntaxe
+Tree* read_classe(Lettre* er,size_t* index)
+{
+    size_t i = *index+1;
+    bool complement = false;
+    if(er[i]=='^')
+    {
+        complement = true;
+        i++;
+    }
+
+    Tree* t = Tree_init(SYNTAXE_OPERATOR_CLASSE,NULL,NULL);
+    size_t debut = i;
+    while(er[i]!=0 && (er[i]!=']' || i==debut))
+    {
+        if(er[i+1]=='-' && er[i+2]!=']' && er[i+2]!=0)
+        {
+            if(er[i+2]<er[i])
+            {
+                fprintf(Motif_flux_erreurs(),"Intervalle %c-%c incorrect dans une classe de lettres\n",(char)er[i],(char)er[i+2]);
+                Tree_free(t);
+                return NULL;
+            }
+            Classe_add_range(&t->classe,er[i],er[i+2]);
+            i+=3;
+        }else
+        {
+            Classe_add(&t->classe,er[i]);
+            i++;
+        }
+    }
+
+    if(er[i]!=']')
+    {
+        fprintf(Motif_flux_erreurs(),"Aucun crochet fermant trouvé pour la classe de lettres !\n");
+        Tree_free(t);
+        return NULL;
+    }
+
+    if(complement)
+        Classe_complement(&t->classe);
+    *index = i;
+    return t;
+}
+
+/// @brief indique si une concaténation implicite doit être ajoutée entre deux arbres successifs
+/// @param precedent étiquette de l'arbre de gauche
+/// @param courant étiquette de l'arbre de droite
+bool is_concatenation_implicite(Lettre precedent,Lettre courant)
+{
+    // on fait une concaténation implicite entre deux lettres ou entre un opérateur unaire et une lettre à sa droite (ex :  a?a ou a*b)
+    // cas des parenthèses : '(' peut-être implicitement concatener à gauche et ')' peut l'être à droite
+    // si on a )( on doit faire la concaténation
+    if(courant=='(')
+    {
+        return precedent!='(' && !is_operator_binaire(precedent);
+    }else if(!is_operator(courant) && courant!=')')
+    {
+        return precedent!='(' && (is_operator_unaire(precedent) || !is_operator(precedent));
+    }
+    return false;
+}
+
+Tree** make_forest(Lettre* er,size_t* forest_size)
+{
+    size_t er_size = str_len(er);
+
+    // au plus une concaténation implicite avant chaque lettre
+    Tree** forest = malloc(sizeof(Tree*)*(2*er_size+1));
+    *forest_size = 0;
+
+    for(size_t i=0;i<er_size;i++)
+    {
+        Tree* t = NULL;
+        if(er[i]==SYNTAXE_OPERATOR_REPETITION)
+        {
+            t = read_repetition(er,&i);
+        }else if(er[i]==SYNTAXE_OPERATOR_CLASSE)
+        {
+            t = read_classe(er,&i);
+        }else
+        {
+            t = Tree_init(er[i],NULL,NULL);
+        }
+
+        if(t==NULL)
+        {
+            for(size_t j=0;j<*forest_size;j++)
+                Tree_free(forest[j]);
+            free(forest);
+            return NULL;
+        }
+
+        if(*forest_size>0 && is_concatenation_implicite(forest[*forest_size-1]->etiquette,t->etiquette))
+        {
+            forest[(*forest_size)++] = Tree_init(SYNTAXE_OPERATOR_CONCATENATION,NULL,NULL);
+        }
+        forest[(*forest_size)++] = t;
+    }
+
+    return forest;
+}
+
+int merge_parentheses(Tree** forest,size_t forest_size)
+{
+    int count = 0;
+    for(size_t i=0;i<forest_size;i++)
+    {
+       if(forest[i]!=NULL)
+        {
+            if(forest[i]->etiquette=='(')
+            {
+                if(parentheses_merge(&forest[i],forest_size-i)==0)
+                {
+                    return -1;
+                }else
+                {
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+Tree* merge_forest(Tree** forest,size_t forest_size)
+{
+#ifdef DEBUG
+    printf("etat initial : [");
+    for(size_t i=0;i<forest_size;i++)
+    {
+        Tree_print(forest[i]);
+        printf(";");
+    }
+    printf("]\n");
+#endif
+    // fusion par parenthèse
+    int error = merge_parentheses(forest,forest_size);
+    if(error==-1)
+        return NULL;
+
+#ifdef DEBUG
+    printf("après fusion des parenthèses : [");
+    for(size_t i=0;i<forest_size;i++)
+    {
+        Tree_print(forest[i]);
+        printf(";");
+    }
+    printf("]\n");
+#endif
+
+    // gestion des ? * et {n,m}
+    error = operators_unaires_merge(forest,forest_size);
+    if(error==-1)
+        return NULL;
+
+#ifdef DEBUG
+    printf("après gestion des ? * {} : [");
+    for(size_t i=0;i<forest_size;i++)
+    {
+        Tree_print(forest[i]);
+        printf(";");
+    }
+    printf("]\n");
+#endif   
+
+    // gestion des @
+    error = operator_binaire_merge(forest,forest_size,SYNTAXE_OPERATOR_CONCATENATION);
+    if(error==-1)
+        return NULL;
+
+#ifdef DEBUG
+    printf("après gestion des @ : [");
+    for(size_t i=0;i<forest_size;i++)
+    {
+        Tree_print(forest[i]);
+        printf(";");
+    }
+    printf("]\n");
+#endif
+
+    // gestion des |
+    error = operator_binaire_merge(forest,forest_size,SYNTAXE_OPERATOR_UNION);
+    if(error==-1)
+        return NULL;
+
+#ifdef DEBUG
+    printf("après gestion des | : [");
+    for(size_t i=0;i<forest_size;i++)
+    {
+        Tree_print(forest[i]);
+        printf(";");
+    }
+    printf("]\n");
+#endif
+
+    Tree* t = NULL;
+    for(size_t i=0;i<forest_size;i++)
+    {
+        if(forest[i]!=NULL)
+        {
+            if(t==NULL)
+            {
+                t=forest[i];
+                forest[i]=NULL;
+            }
+            else
+            {
+                fprintf(Motif_flux_erreurs(),"Erreur lors de la lecture de l'expression régulière !\n");
+                return NULL;
+            }
+        }
+    }
+    
+    return t;
+}
+
+
+/// @brief index du crochet fermant de la classe de lettres dont le crochet ouvrant est `er[i]` (voir `read_classe`)
+/// @return index du '\0' final si la classe n'est pas fermée
+size_t fin_classe(Lettre* er,size_t i)
+{
+    i++;
+    if(er[i]=='^')
+        i++;
+    size_t debut = i;
+    while(er[i]!=0 && (er[i]!=']' || i==debut))
+        i++;
+    return i;
+}
+
+/// @brief arbre qui ne reconnaît que le mot vide : `.{0}` (corps d'une expression réduite à ses ancres comme "^$")
+Tree* Tree_mot_vide(void)
+{
+    Tree* t = Tree_init(SYNTAXE_OPERATOR_REPETITION,Tree_init(SYNTAXE_OPERATOR_SIGMA,NULL,NULL),NULL);
+    t->min = 0;
+    t->max = 0;
+    return t;
+}
+
+Tree* make_syntaxique_tree(Lettre* er)
+{    
+    // les ancres ne sont reconnues qu'au début ('^') et à la fin ('$') de l'expression, ailleurs ce sont des lettres ordinaires ;
+    // une union hors parenthèses est découpée en alternatives, qui doivent alors porter les mêmes ancres (`^a|^b` est `^(a|b)`) :
+    // `^a|b` est refusé plutôt que lu comme `^(a|b)`
+    size_t size = str_len(er);
+    Lettre* corps = malloc(sizeof(Lettre)*(size+1));
+    size_t corps_size = 0;
+    bool ancre_debut = false;
+    bool ancre_fin = false;
+    size_t profondeur = 0;
+    size_t debut = 0; // première lettre de l'alternative en cours
+    for(size_t i=0;i<=size;i++)
+    {
+        if(i<size && (er[i]!=SYNTAXE_OPERATOR_UNION || profondeur>0))
+        {
+            if(er[i]==SYNTAXE_OPERATOR_CLASSE)
+                i = min(fin_classe(er,i),size-1);
+            else if(er[i]=='(')
+                profondeur++;
+            else if(er[i]==')' && profondeur>0)
+                profondeur--;
+            continue;
+        }
+
+        // alternative er[debut..i[
+        bool alternative_debut = i>debut && er[debut]==SYNTAXE_ANCRE_DEBUT;
+        bool alternative_fin = i>debut+(alternative_debut?1:0) && er[i-1]==SYNTAXE_ANCRE_FIN;
+        if(debut==0)
+        {
+            ancre_debut = alternative_debut;
+            ancre_fin = alternative_fin;
+        }else if(alternative_debut!=ancre_debut || alternative_fin!=ancre_fin)
+        {
+            fprintf(Motif_flux_erreurs(),"Les ancres ^ et $ doivent porter sur toute l'expression ou sur chacune de ses alternatives (^(a|b) ou ^a|^b, pas ^a|b) !\n");
+            free(corps);
+            return NULL;
+        }
+        size_t n = i-debut-(alternative_debut?1:0)-(alternative_fin?1:0);
+        memcpy(corps+corps_size,er+debut+(alternative_debut?1:0),sizeof(Lettre)*n);
+        corps_size += n;
+        if(i<size)
+            corps[corps_size++] = SYNTAXE_OPERATOR_UNION;
+        debut = i+1;
+    }
+    corps[corps_size] = 0;
+
+    Tree* syntaxique_tree = NULL;
+    if(corps_size==0 && (ancre_debut || ancre_fin))
+    {
+        // "^", "$" ou "^$" : le corps est le mot vide
+        syntaxique_tree = Tree_mot_vide();
+    }else
+    {
+        size_t er_size;
+        Tree** trees = make_forest(corps,&er_size);
+        if(trees!=NULL)
+        {
+            syntaxique_tree = merge_forest(trees,er_size);
+            free(trees);
+        }
+    }
+    free(corps);
+
+    // les ancres s'appliquent à toute l'expression : ce sont des noeuds unaires à la racine
+    if(syntaxique_tree!=NULL && ancre_fin)
+        syntaxique_tree = Tree_init(SYNTAXE_ANCRE_FIN,syntaxique_tree,NULL);
+    if(syntaxique_tree!=NULL && ancre_debut)
+        syntaxique_tree = Tree_init(SYNTAXE_ANCRE_DEBUT,syntaxique_tree,NULL);
+    return syntaxique_tree;
+}
+
+
+/*
+    Création d'un automate à partir d'un arbre syntaxique
+    Algorithme de Thomson
+
+        le a? est équivalent à a|epsilon : automate équivalent ->()-epsilon,a->()->
+        le . est équivalent à SIGMA : automate équivalent ->()-a,b,....->()->
+*/
+
+/// @brief 
+/// @param  
+/// @return 
+ListArray* ListArray_init(void)
+{
+    ListArray* list = malloc(sizeof(ListArray));
+    list->size = 0;
+    // le tableau n'est alloué qu'au premier ajout : la plupart des listes de transitions restent vides
+    list->capacity = 0;
+    list->data = NULL;
+
+    return list;
+}
+
+/// @brief 
+/// @param list 
+void ListArray_free(ListArray* list)
+{
+    free(list->data);
+    free(list);
+}
+
+/// @brief 
+/// @param list 
+/// @param s 
+void ListArray_push(ListArray* list,Sommet s)
+{
+    if(list->size==list->capacity)
+    {
+#ifdef _DEBUG
+        fprintf(stderr,"expansion de la liste %ld -> %ld\n",list->capacity,list->capacity*LISTARRAY_EXPANSION_COEF);
+#endif
+        size_t new_capacity = max(MIN_LISTARRAY_CAPACITY,list->capacity * LISTARRAY_EXPANSION_COEF);
+        Sommet* temp = malloc(sizeof(Sommet)*new_capacity);
+
+        for(size_t i=0;i<list->capacity;i++)
+            temp[i] = list->data[i];
+        
+        free(list->data);
+        list->data = temp;
+        list->capacity = new_capacity;
+
+        ListArray_push(list,s);
+    }else if(list->size < list->capacity)
+    {
+        list->data[list->size++] = s;
+    }else
+    {
+        fprintf(stderr,"Index out of range dans une ListArray !\n");
+    }
+}
+
+/// @brief 
+/// @param list 
+/// @return 
+Sommet ListArray_pop(ListArray* list)
+{
+    if(list->size==0)
+    {
+        // problème
+        fprintf(stderr,"tentative de pop sur une ListArray vide");
+        return -1;
+    }else
+    {
+        return list->data[--list->size];
+    }
+}
+
+/// @brief supprime l'élément d'index `index` et le renvoie
+/// @param list 
+/// @param index 
+/// @return 
+Sommet ListArray_remove(ListArray* list,size_t index)
+{
+    if(index==list->size-1)
+    {
+        return ListArray_pop(list);
+    }else
+    {
+        Sommet temp = list->data[index];
+        list->data[index] = list->data[list->size-1];
+        list->size = list->size-1;
+        return temp;
+    }
+    
+
+}
+
+/// @brief 
+/// @param list 
+/// @return 
+bool ListArray_empty(ListArray* list)
+{
+    return list->size==0;
+}
+
+void ListArray_print(ListArray* list)
+{
+    printf("[");
+    for(size_t i=0;i<list->size;i++)
+        printf("%ld;",list->data[i]);
+    printf("]\n");
+}
+
+/// @brief instancie une copie d'une liste
+/// @param list 
+/// @return 
+ListArray* ListArray_copy(ListArray* list)
+{
+    ListArray* copy = ListArray_init();
+    for(size_t i=0;i<list->size;i++)
+        ListArray_push(copy,list->data[i]);
+    return copy;
+}
+
+/// @brief Applique une fonction à chaque valeur d'une liste
+/// @param list 
+/// @param f 
+void ListArray_iter(ListArray* list,void (*f)(Sommet))
+{
+    for(size_t i=0;i<list->size;i++)
+        f(list->data[i]);
+}
+
+/// @brief Applique une fonction à chaque valeur d'une liste et remplace cette valeur par le retour de la fonction
+/// @param list 
+/// @param f 
+void ListArray_map(ListArray* list,Sommet (*f)(Sommet))
+{
+        for(size_t i=0;i<list->size;i++)
+            list->data[i] = f(list->data[i]);
+}
+
+/// @brief concatène deux listes en une nouvelle liste
+/// @param list1 
+/// @param list2 
+/// @return 
+ListArray* ListArray_concatenation(ListArray* list1,ListArray* list2)
+{
+    ListArray* l = ListArray_init();
+    for(size_t i=0;i<list1->size;i++)
+        ListArray_push(l,list1->data[i]);
+    for(size_t i=0;i<list2->size;i++)
+        ListArray_push(l,list2->data[i]);
+
+    return l;
+}
+
+/// @brief ajoute tous les éléments de `source` dans `dest`
+/// @param dest liste dans laquelle les éléments vont-être ajouté (modifiée)
+/// @param source liste d'ou les éléments seront récupérés (const)
+void ListArray_extend(ListArray* dest,ListArray* source)
+{
+    for(size_t i=0;i<source->size;i++)
+        ListArray_push(dest,source->data[i]);
+}
+
+/// @brief mémoire des tables de transitions d'un automate (une liste par état et par lettre, dont en moyenne une seule
+/// n'est pas vide), comptée dans le budget de mémoire avec la place réellement occupée par chaque bloc alloué
+/// @param nb_etat
+/// @param alphabet_size
+/// @return
+size_t Automate_octets(size_t nb_etat,size_t alphabet_size)
+{
+    return nb_etat*(sizeof(ListArray**)+Memoire_bloc(alphabet_size*sizeof(ListArray*))+alphabet_size*Memoire_bloc(sizeof(ListArray))
+        +Memoire_bloc(MIN_LISTARRAY_CAPACITY*sizeof(Sommet)));
+}
+
+Automate* Automate_init(size_t nb_etat,size_t alphabet_size)
+{
+    Memoire_prendre(Automate_octets(nb_etat,alphabet_size));
+    Automate* a = malloc(sizeof(Automate));
+    a->alphabet_size = alphabet_size;
+    a->nb_etat = nb_etat;
+    a->initiaux = ListArray_init();
+    a->finaux = ListArray_init();
+    a->transitions = malloc(sizeof(ListArray**)*nb_etat);
+    for(size_t i=0;i<nb_etat;i++)
+    {
+        a->transitions[i] = malloc(sizeof(ListArray*)*alphabet_size);
+        for(size_t l=0;l<alphabet_size;l++)
+        {
+            a->transitions[i][l] = ListArray_init();
+        }
+    }
+    a->classes = NULL;
+    a->nb_classes = 0;
+    a->compteurs = NULL;
+    a->nb_compteurs = 0;
+    a->nb_mots_compteurs = 0;
+    a->classes_debut = NULL;
+    a->compteurs_debut = NULL;
+
+    return a;
+}
+
+void Automate_free(Automate* a)
+{
+    ListArray_free(a->initiaux);
+    ListArray_free(a->finaux);
+    for(size_t i=0;i<a->nb_etat;i++)
+    {
+        for(size_t l=0;l<a->alphabet_size;l++)
+            ListArray_free(a->transitions[i][l]);
+        free(a->transitions[i]);
+    }
+    free(a->classes);
+    free(a->compteurs);
+    Automate_desindexer(a);
+
+    free(a->transitions);
+    Memoire_rendre(Automate_octets(a->nb_etat,a->alphabet_size));
+    free(a);
+}
+
+void Automate_print(Automate* a)
+{
+    if(a==NULL)return;
+    printf("taille de l'aphabet : %ld\n",a->alphabet_size);
+    printf("nombre d'état : %ld\n",a->nb_etat);
+    printf("Etats initiaux : "); ListArray_print(a->initiaux);
+    printf("Etats finaux : ");ListArray_print(a->finaux);
+    for (size_t i = 0; i < a->nb_etat; i++)
+    {
+        printf("Depuis le sommet %ld : [",i);
+        for(size_t lettre =0;lettre<a->alphabet_size;lettre++)
+            for(size_t j=0;j<a->transitions[i][lettre]->size;j++)
+                printf("(%c,%ld);",(char)lettre,a->transitions[i][lettre]->data[j]);
+        printf("]\n");
+    }
+    for(size_t c=0;c<a->nb_classes;c++)
+    {
+        printf("Depuis le sommet %ld : ",a->classes[c].source);
+        Classe_print(&a->classes[c].classe);
+        printf(" -> %ld\n",a->classes[c].dest);
+    }
+    for(size_t c=0;c<a->nb_compteurs;c++)
+    {
+        Compteur* k = &a->compteurs[c];
+        if(k->max==REPETITION_INFINIE)
+            printf("Compteur %ld : %ld -{%ld,}-> %ld\n",c,k->entree,k->min,k->sortie);
+        else
+            printf("Compteur %ld : %ld -{%ld,%ld}-> %ld\n",c,k->entree,k->min,k->max,k->sortie);
+    }
+}
+
+Automate* Automate_copy(Automate* a)
+{
+    Automate* b = Automate_init(a->nb_etat,a->alphabet_size);
+    ListArray_extend(b->initiaux,a->initiaux);
+    ListArray_extend(b->finaux,a->finaux);
+
+    for(Sommet source=0;source<a->nb_etat;source++)
+    {
+        for(Lettre l=0;l<a->alphabet_size;l++)
+        {
+            ListArray_extend(b->transitions[source][l],a->transitions[source][l]);
+        }
+    }
+    Automate_add_classes_et_compteurs(b,a,0);
+
+    return b;
+}
+
+/// @brief ajoute une transition de `source` vers `dest` par toutes les lettres de `classe`
+void Automate_add_transition_classe(Automate* a,Sommet source,Classe* classe,Sommet dest)
+{
+    Automate_desindexer(a);
+    a->classes = realloc(a->classes,sizeof(TransitionClasse)*(a->nb_classes+1));
+    a->classes[a->nb_classes].source = source;
+    a->classes[a->nb_classes].dest = dest;
+    a->classes[a->nb_classes].classe = *classe;
+    a->nb_classes++;
+}
+
+/// @brief ajoute à `dest` une copie des transitions par classe et des compteurs de `source`, 
+/// dont les états sont décalés de `delta_index`
+/// @param dest 
+/// @param source 
+/// @param delta_index 
+void Automate_add_classes_et_compteurs(Automate* dest,Automate* source,size_t delta_index)
+{
+    for(size_t c=0;c<source->nb_classes;c++)
+    {
+        TransitionClasse* t = &source->classes[c];
+        Automate_add_transition_classe(dest,t->source+delta_index,&t->classe,t->dest+delta_index);
+    }
+
+    if(source->nb_compteurs==0)
+        return;
+
+    Automate_desindexer(dest);
+    dest->compteurs = realloc(dest->compteurs,sizeof(Compteur)*(dest->nb_compteurs+source->nb_compteurs));
+    for(size_t c=0;c<source->nb_compteurs;c++)
+    {
+        Compteur k = source->compteurs[c];
+        k.entree += delta_index;
+        k.sortie += delta_index;
+        k.offset += dest->nb_mots_compteurs;
+        dest->compteurs[dest->nb_compteurs++] = k;
+    }
+    dest->nb_mots_compteurs += source->nb_mots_compteurs;
+}
+
+/// @brief ajoute `delta_index` à chaque sommet d'une liste
+/// @param list 
+/// @param delta_index 
+void ListArray_reindexation(ListArray* list,long long delta_index)
+{
+    for(size_t i=0;i<list->size;i++)
+        list->data[i] += delta_index;
+}
+
+/// @brief réindexe les sommets d'un automate en incrémentant chacune des référence de `delta_index`
+/// @param a 
+/// @param delta_index 
+/// @warning après l'usage de cette fonction un automate n'est plus utilisable en l'état sous peine de lecture hors mémoire
+void Automate_reindexation(Automate* a,long long delta_index)
+{
+    Automate_desindexer(a);
+    ListArray_reindexation(a->initiaux,delta_index);
+    ListArray_reindexation(a->finaux,delta_index);
+    for(size_t i=0;i<a->nb_etat;i++)
+        for(size_t l=0;l<a->alphabet_size;l++)
+            ListArray_reindexation(a->transitions[i][l],delta_index);
+    for(size_t c=0;c<a->nb_classes;c++)
+    {
+        a->classes[c].source += delta_index;
+        a->classes[c].dest += delta_index;
+    }
+    for(size_t c=0;c<a->nb_compteurs;c++)
+    {
+        a->compteurs[c].entree += delta_index;
+        a->compteurs[c].sortie += delta_index;
+    }
+}
+
+/// @brief trie les transitions par classe par source et les compteurs par entrée, et retient où commencent ceux de chaque état :
+/// la lecture d'une lettre ne parcourt alors que ceux des états actifs (voir `Automate_read_letter_into`)
+/// @note l'index est supprimé par toute modification des transitions par classe ou des compteurs
+/// @param a 
+void Automate_indexer(Automate* a)
+{
+    if(a->classes_debut!=NULL)
+        return;
+    Memoire_prendre(2*sizeof(size_t)*(a->nb_etat+1));
+    a->classes_debut = calloc(a->nb_etat+1,sizeof(size_t));
+    a->compteurs_debut = calloc(a->nb_etat+1,sizeof(size_t));
+
+    // tri par dénombrement : debut[q+1] compte d'abord les éléments de q
+    for(size_t c=0;c<a->nb_classes;c++)
+        a->classes_debut[a->classes[c].source+1]++;
+    for(size_t c=0;c<a->nb_compteurs;c++)
+        a->compteurs_debut[a->compteurs[c].entree+1]++;
+    for(Sommet q=0;q<a->nb_etat;q++)
+    {
+        a->classes_debut[q+1] += a->classes_debut[q];
+        a->compteurs_debut[q+1] += a->compteurs_debut[q];
+    }
+
+    if(a->nb_classes>0)
+    {
+        TransitionClasse* classes = malloc(sizeof(TransitionClasse)*a->nb_classes);
+        size_t* place = malloc(sizeof(size_t)*a->nb_etat);
+        memcpy(place,a->classes_debut,sizeof(size_t)*a->nb_etat);
+        for(size_t c=0;c<a->nb_classes;c++)
+            classes[place[a->classes[c].source]++] = a->classes[c];
+        free(a->classes);
+        a->classes = classes;
+        free(place);
+    }
+    if(a->nb_compteurs>0)
+    {
+        Compteur* compteurs = malloc(sizeof(Compteur)*a->nb_compteurs);
+        size_t* place = malloc(sizeof(size_t)*a->nb_etat);
+        memcpy(place,a->compteurs_debut,sizeof(size_t)*a->nb_etat);
+        for(size_t c=0;c<a->nb_compteurs;c++)
+            compteurs[place[a->compteurs[c].entree]++] = a->compteurs[c];
+        free(a->compteurs);
+        a->compteurs = compteurs;
+        free(place);
+    }
+}
+
+/// @brief supprime l'index de `Automate_indexer`
+/// @param a 
+void Automate_desindexer(Automate* a)
+{
+    if(a->classes_debut==NULL)
+        return;
+    Memoire_rendre(2*sizeof(size_t)*(a->nb_etat+1));
+    free(a->classes_debut);
+    free(a->compteurs_debut);
+    a->classes_debut = NULL;
+    a->compteurs_debut = NULL;
+}
+
+void Automate_add_etat_initial(Automate* a,size_t q)
+{
+    ListArray_push(a->initiaux,q);
+}
+
+void Automate_add_etat_final(Automate* a,size_t q)
+{
+    ListArray_push(a->finaux,q);
+}
+
+void Automate_add_transition(Automate* a,size_t source,size_t lettre,size_t dest)
+{
+    ListArray_push(a->transitions[source][lettre],dest);
+}
+
+
+
+/// @brief instancie un nouvel automate qui possède les états et transitions
+/// des deux automates passés en argument (avec une réindexation de +a1->nb_etat sur a2)
+/// mais ni les états finaux ni les états initiaux
+/// @param a1 
+/// @param a2 
+/// @return 
+Automate* Automate_merge(Automate* a1,Automate* a2)
+{
+    Automate* b = Automate_init(a1->nb_etat+a2->nb_etat,max(a1->alphabet_size,a2->alphabet_size));
+    size_t delta_index = a1->nb_etat;
+    // on réindexe temporairement a2
+    Automate_reindexation(a2,delta_index);
+
+    // on copie maintenant les transitions
+    for(size_t etat_source=0;etat_source<a1->nb_etat;etat_source++)
+    {
+        for(Lettre l=0;l<a1->alphabet_size;l++)
+        {
+            ListArray_extend(b->transitions[etat_source][l],a1->transitions[etat_source][l]);
+        }
+    }
+
+    for(size_t etat_source=0;etat_source<a2->nb_etat;etat_source++)
+    {
+        for(Lettre l=0;l<a2->alphabet_size;l++)
+        {
+            ListArray_extend(b->transitions[etat_source+delta_index][l],a2->transitions[etat_source][l]);
+        }
+    }
+    Automate_add_classes_et_compteurs(b,a1,0);
+    Automate_add_classes_et_compteurs(b,a2,0); // a2 est déjà réindexé
+    
+    
+    // on répare a2
+    Automate_reindexation(a2,-(long long)a1->nb_etat);
+
+    return b;
+}
+
+/// @brief Retourne un automate reconnaissant une lettre de l'alphabet
+/// @param lettre 
+/// @return 
+Automate* Automate_lettre(Lettre lettre,size_t alphabet_size)
+{
+    // ->()--lettre-->()->
+    Automate* a = Automate_init(2,alphabet_size);
+    Automate_add_etat_initial(a,0);
+    Automate_add_etat_final(a,1);
+
+    Automate_add_transition(a,0,lettre,1);
+    return a;
+}
+
+Automate* Automate_union(Automate* a1,Automate* a2)
+{
+    
+    Automate* b = Automate_merge(a1,a2);
+    size_t delta = a1->nb_etat;
+
+    // on copie les états finaux de a1 et de a2 vers b
+    ListArray_extend(b->initiaux,a1->initiaux);
+    for(size_t i=0;i<(a2->initiaux->size);i++)
+        ListArray_push(b->initiaux,a2->initiaux->data[i]+delta);
+
+    // on fait de même pour les états finaux
+    ListArray_extend(b->finaux,a1->finaux);
+    for(size_t i=0;i<(a2->finaux->size);i++)
+        ListArray_push(b->finaux,a2->finaux->data[i]+delta);
+
+    //on retourne l'automate nouvellement créer
+    return b;
+};
+
+Automate* Automate_concatenation(Automate* a1,Automate* a2)
+{
+    Automate* b = Automate_merge(a1,a2);
+    // printf("Concaténation : \n");
+    // Automate_print(a1);
+    // Automate_print(a2);
+    // printf("Après merge : \n");
+    // Automate_print(b);
+    size_t delta = a1->nb_etat;
+
+    // on ajoute une epsilon transition des états finaux de a1 vers les états initiaux de a2
+    for(size_t i=0;i<a1->finaux->size;i++)
+    {
+        Sommet source = a1->finaux->data[i];
+        for(size_t j=0;j<a2->initiaux->size;j++)
+        {
+            Sommet dest = a2->initiaux->data[j];
+            Automate_add_transition(b,source,EPSILON_TRANSITION_INDEX,dest+delta);
+        }
+    }
+
+    // on met les états initiaux de a1 en tant qu'états initiaux 
+    ListArray_extend(b->initiaux,a1->initiaux);
+    // et les états finaux de a2 en état finaux
+    ListArray_extend(b->finaux,a2->finaux);
+    ListArray_reindexation(b->finaux,delta);
+
+    // printf("fin de la concaténation : \n");
+    // Automate_print(b);
+    return b;
+}
+
+Automate* Automate_etoile(Automate* a)
+{
+    // on ajoute un état qui sera l'unique état initial et final (on va le noter q)
+    // on relie tous les états initiaux de a depuis cet état
+    // on relie tous les états finaux de a vers cet état
+
+    // printf("automate etoile : entrée : ");
+    // Automate_print(a);
+
+    Automate* b = Automate_init(a->nb_etat+1,a->alphabet_size);
+    Sommet q = a->nb_etat;
+    ListArray_push(b->initiaux,q);
+    ListArray_push(b->finaux,q);
+
+    // on copie les transitions
+    for(Sommet source =0;source<a->nb_etat;source++)
+    {
+        for(size_t lettre = 0;lettre<a->alphabet_size;lettre++)
+        {
+            ListArray_extend(b->transitions[source][lettre],a->transitions[source][lettre]);
+        }
+    }
+    Automate_add_classes_et_compteurs(b,a,0);
+
+    // on relie q vers les états initiaux de a
+    for(size_t i=0;i<a->initiaux->size;i++)
+    {
+        Automate_add_transition(b,q,EPSILON_TRANSITION_INDEX,a->initiaux->data[i]);
+    }
+
+    // on relie les états finaux de a vers q
+    for(size_t i=0;i<a->finaux->size;i++)
+    {
+        Automate_add_transition(b,a->finaux->data[i],EPSILON_TRANSITION_INDEX,q);
+    }
+    // printf("sortie : ");
+    // Automate_print(b);
+    return b;
+}
+
+
+Automate* Automate_joker(Automate* a)
+{
+    // automate reconnaissant une fois a ou rien
+    // on copie a, on ajoute un état, on met cet état comme final et initial
+
+    Automate* b = Automate_init(a->nb_etat+1,a->alphabet_size);
+    ListArray_extend(b->initiaux,a->initiaux);
+    ListArray_extend(b->finaux,a->finaux);
+    for(Sommet s=0;s<a->nb_etat;s++)
+    {
+        for(Lettre l=0;l<a->alphabet_size;l++)
+        {
+            ListArray_extend(b->transitions[s][l],a->transitions[s][l]);
+        }
+    }
+    Automate_add_classes_et_compteurs(b,a,0);
+
+    ListArray_push(b->initiaux,a->nb_etat);
+    ListArray_push(b->finaux,a->nb_etat);
+    return b;
+}
+
+Automate* Automate_sigma(size_t alphabet_size)
+{
+    // automate reconnaissant tous caractère de l'alphabet (la lettre 0 est réservée aux epsilon transitions)
+    Classe sigma;
+    Classe_clear(&sigma);
+    Classe_add_range(&sigma,EPSILON_TRANSITION_INDEX+1,alphabet_size-1);
+    return Automate_classe(&sigma,alphabet_size);
+}
+
+/// @brief Retourne un automate reconnaissant une lettre de `classe`
+/// ->()--classe-->()->  avec une seule transition quelle que soit la taille de la classe
+/// @param classe 
+/// @param alphabet_size 
+/// @return 
+Automate* Automate_classe(Classe* classe,size_t alphabet_size)
+{
+    Automate* a = Automate_init(2,alphabet_size);
+    Automate_add_etat_initial(a,0);
+    Automate_add_etat_final(a,1);
+    Automate_add_transition_classe(a,0,classe,1);
+    return a;
+}
+
+/// @brief détermine si un arbre reconnaît exactement une lettre (lettre, '.', classe ou union de telles expressions)
+/// et ajoute alors ces lettres à `lettres`
+/// @param tree 
+/// @param lettres 
+/// @param alphabet_size 
+/// @return 
+bool Tree_classe(Tree* tree,Classe* lettres,size_t alphabet_size)
+{
+    switch (tree->etiquette)
+    {
+    case SYNTAXE_OPERATOR_UNION:
+        return Tree_classe(tree->left_chilfren,lettres,alphabet_size) && Tree_classe(tree->right_children,lettres,alphabet_size);
+    case SYNTAXE_OPERATOR_SIGMA:
+        Classe_add_range(lettres,EPSILON_TRANSITION_INDEX+1,alphabet_size-1);
+        return true;
+    case SYNTAXE_OPERATOR_CLASSE:
+        Classe_union(lettres,&tree->classe);
+        return true;
+    default:
+        if(is_operator(tree->etiquette) || tree->etiquette>=alphabet_size)
+            return false;
+        Classe_add(lettres,tree->etiquette);
+        return true;
+    }
+}
+
+/// @brief Retourne un automate reconnaissant e{min,max} où e ne reconnaît pas le mot vide
+/// ->(entree)-{min,max}->(sortie)->
+/// la répétition est représentée par un unique compteur sur les positions de Glushkov de e, quelle que soit la valeur de max
+/// @param corps arbre de e
+/// @param min 
+/// @param max 
+/// @param alphabet_size 
+/// @return NULL si e a plus de COMPTEUR_POSITIONS_MAX positions ou reconnaît le mot vide
+Automate* Automate_compteur(Tree* corps,size_t min,size_t max,size_t alphabet_size)
+{
+    Compteur k;
+    memset(&k,0,sizeof(Compteur));
+    Classe lettres;
+    Classe_clear(&lettres);
+    if(Tree_classe(corps,&lettres,alphabet_size))
+    {
+        // e lit exactement une lettre : une seule position
+        k.nb_positions = 1;
+        k.positions[0] = lettres;
+        k.premiers = k.derniers = 1;
+    }else
+    {
+        Glushkov* g = Glushkov_init(corps,alphabet_size,false);
+        if(g==NULL)
+            return NULL;
+        // la position j+1 de Glushkov (0 est l'état initial) est la position j du compteur
+        bool vide = (g->finaux&1)!=0;
+        k.nb_positions = g->m;
+        if(!vide && k.nb_positions<=COMPTEUR_POSITIONS_MAX)
+        {
+            for(size_t j=0;j<k.nb_positions;j++)
+            {
+                Classe_clear(&k.positions[j]);
+                for(size_t c=0;c<256;c++)
+                    if((g->lettres[c]>>(j+1))&1)
+                        Classe_add(&k.positions[j],c);
+                k.suivants[j] = g->suivants[j+1]>>1;
+            }
+            k.premiers = g->suivants[0]>>1;
+            k.derniers = g->finaux>>1;
+        }
+        Glushkov_free(g);
+        if(vide || k.nb_positions>COMPTEUR_POSITIONS_MAX)
+            return NULL;
+    }
+
+    Automate* a = Automate_init(2,alphabet_size);
+    Automate_add_etat_initial(a,0);
+    Automate_add_etat_final(a,1);
+    if(min==0)
+        Automate_add_transition(a,0,EPSILON_TRANSITION_INDEX,1);
+
+    k.entree = 0;
+    k.sortie = 1;
+    k.min = min;
+    k.max = max;
+    k.borne = (max==REPETITION_INFINIE)?min:max;
+    k.offset = 0;
+    k.largeur = k.borne/64+1;
+    k.nb_mots = k.nb_positions*k.largeur;
+
+    a->compteurs = malloc(sizeof(Compteur));
+    a->compteurs[0] = k;
+    a->nb_compteurs = 1;
+    a->nb_mots_compteurs = k.nb_mots;
+    return a;
+}
+
+/// @brief retourne le compteur pour une lecture de droite à gauche : ses extrémités sont échangées
+/// et le corps e est remplacé par son miroir (premières et dernières positions échangées, suivants transposés)
+/// @param k 
+void Compteur_inverser(Compteur* k)
+{
+    Sommet temp = k->entree;
+    k->entree = k->sortie;
+    k->sortie = temp;
+
+    uint64_t premiers = k->premiers;
+    k->premiers = k->derniers;
+    k->derniers = premiers;
+
+    uint64_t suivants[COMPTEUR_POSITIONS_MAX] = {0};
+    for(size_t i=0;i<k->nb_positions;i++)
+        for(size_t j=0;j<k->nb_positions;j++)
+            if((k->suivants[i]>>j)&1)
+                suivants[j] |= (uint64_t)1<<i;
+    memcpy(k->suivants,suivants,sizeof(suivants));
+}
+
+/// @brief Retourne un automate reconnaissant a{min,max}
+/// l'automate `a` est construit une seule fois puis recopié (avec réindexation) dans un même automate :
+/// ->[a]->[a]->...->[a]->(q)->  chaque copie à partir de la min-ième est reliée à q
+/// pour {min,} la dernière copie boucle sur elle-même
+/// @param a 
+/// @param min 
+/// @param max 
+/// @return NULL si les automates dépliés dépassent REPETITION_MAX_OCTETS, ou ne tiennent pas dans la limite de mémoire
+Automate* Automate_repetition(Automate* a,size_t min,size_t max)
+{
+    size_t nb_copies = (max==REPETITION_INFINIE)?max(min,1):max;
+    size_t octets = AUTOMATE_COPIES*Automate_octets(nb_copies*a->nb_etat+1,a->alphabet_size);
+    if(octets>REPETITION_MAX_OCTETS)
+    {
+        fprintf(Motif_flux_erreurs(),"Répétition {%ld,%ld} trop grande : %zu octets estimés pour %zu copies dépliées de %zu états (au plus %zu Mo)\n",
+            min,max,octets,nb_copies,a->nb_etat,REPETITION_MAX_OCTETS/(1024*1024));
+        return NULL;
+    }
+    if(!Memoire_disponible(octets))
+    {
+        fprintf(Motif_flux_erreurs(),"Répétition {%ld,%ld} trop grande pour la limite de mémoire : %zu octets estimés\n",min,max,octets);
+        return NULL;
+    }
+
+    size_t n = a->nb_etat;
+    Sommet q = nb_copies*n;
+    Automate* b = Automate_init(nb_copies*n+1,a->alphabet_size);
+    Automate_add_etat_final(b,q);
+    if(min==0)
+        Automate_add_etat_initial(b,q);
+
+    for(size_t i=0;i<nb_copies;i++)
+    {
+        size_t delta = i*n;
+        for(Sommet source=0;source<n;source++)
+            for(Lettre l=0;l<a->alphabet_size;l++)
+                for(size_t j=0;j<a->transitions[source][l]->size;j++)
+                    Automate_add_transition(b,source+delta,l,a->transitions[source][l]->data[j]+delta);
+        Automate_add_classes_et_compteurs(b,a,delta);
+
+        if(i==0)
+        {
+            for(size_t j=0;j<a->initiaux->size;j++)
+                Automate_add_etat_initial(b,a->initiaux->data[j]);
+        }
+
+        for(size_t f=0;f<a->finaux->size;f++)
+        {
+            Sommet fin = a->finaux->data[f]+delta;
+            // copie suivante
+            if(i+1<nb_copies)
+                for(size_t j=0;j<a->initiaux->size;j++)
+                    Automate_add_transition(b,fin,EPSILON_TRANSITION_INDEX,a->initiaux->data[j]+delta+n);
+            // i+1 copies lues : on peut sortir
+            if(i+1>=min)
+                Automate_add_transition(b,fin,EPSILON_TRANSITION_INDEX,q);
+            // {min,} : la dernière copie se répète
+            if(i+1==nb_copies && max==REPETITION_INFINIE)
+                for(size_t j=0;j<a->initiaux->size;j++)
+                    Automate_add_transition(b,fin,EPSILON_TRANSITION_INDEX,a->initiaux->data[j]+delta);
+        }
+    }
+
+    return b;
+}
+
+/// @brief automate de Thomson de l'expression
+/// @param syntaxique_tree 
+/// @param alphabet_size 
+/// @param compteurs représenter les longues répétitions par des compteurs (sinon elles sont toutes dépliées)
+/// @return NULL si une répétition est trop grande
+Automate* make_thomson_automate(Tree* syntaxique_tree,size_t alphabet_size,bool compteurs)
+{
+    if(syntaxique_tree==NULL)
+        return NULL;
+
+    Automate* a = NULL;
+    Automate* b = NULL;
+    Automate* c = NULL;
+    //printf("lecture de l'abre syntaxique : "); 
+    //Tree_print(syntaxique_tree);
+    //printf("\n");
+    switch (syntaxique_tree->etiquette)
+    {
+        
+        case SYNTAXE_OPERATOR_CONCATENATION:
+            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size,compteurs);
+            b = make_thomson_automate(syntaxique_tree->right_children,alphabet_size,compteurs);
+
+            if(a==NULL)
+            {
+                if(b!=NULL)
+                    Automate_free(b);
+                return NULL;
+            }else if(b==NULL)
+            {
+                if(a!=NULL)
+                    Automate_free(a);
+                return NULL;
+            }
+
+            c = Automate_concatenation(a,b);
+            Automate_free(a);
+            Automate_free(b);
+
+            return c;
+            break;
+        case SYNTAXE_OPERATOR_UNION:
+            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size,compteurs);
+            b = make_thomson_automate(syntaxique_tree->right_children,alphabet_size,compteurs);
+
+            // une branche impossible à construire (répétition trop grande) fait échouer toute l'union
+            if(a==NULL || b==NULL)
+            {
+                if(a!=NULL)
+                    Automate_free(a);
+                if(b!=NULL)
+                    Automate_free(b);
+                return NULL;
+            }
+
+            c = Automate_union(a,b);
+            Automate_free(a);
+            Automate_free(b);
+            return c;
+            break;
+        case SYNTAXE_OPERATOR_ETOILE:
+            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size,compteurs);
+            if(a==NULL) return NULL;
+
+            b = Automate_etoile(a);
+            Automate_free(a);
+            return b;    
+            break;
+        case SYNTAXE_OPERATOR_JOKER:
+            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size,compteurs);
+            b = Automate_joker(a);
+            Automate_free(a);
+            return b;
+            break;
+        case SYNTAXE_OPERATOR_SIGMA:
+            return Automate_sigma(alphabet_size);
+            break;
+        case SYNTAXE_OPERATOR_CLASSE:
+            return Automate_classe(&syntaxique_tree->classe,alphabet_size);
+            break;
+        case SYNTAXE_ANCRE_DEBUT:
+        case SYNTAXE_ANCRE_FIN:
+            // une feuille '^' ou '$' est une lettre ordinaire (ancre au milieu de l'expression)
+            if(syntaxique_tree->left_chilfren==NULL)
+                return Automate_lettre(syntaxique_tree->etiquette,alphabet_size);
+            // les ancres sont prises en compte lors de la recherche (voir `Motif_find_next`)
+            return make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size,compteurs);
+            break;
+        case SYNTAXE_OPERATOR_REPETITION:
+        {
+            // une longue répétition d'un corps de peu de positions est représentée par un compteur
+            size_t borne = (syntaxique_tree->max==REPETITION_INFINIE)?syntaxique_tree->min:syntaxique_tree->max;
+            if(compteurs && borne>REPETITION_SEUIL_COMPTEUR)
+            {
+                a = Automate_compteur(syntaxique_tree->left_chilfren,syntaxique_tree->min,syntaxique_tree->max,alphabet_size);
+                if(a!=NULL)
+                    return a;
+            }
+
+            // sinon on déplie la répétition
+            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size,compteurs);
+            if(a==NULL) return NULL;
+
+            b = Automate_repetition(a,syntaxique_tree->min,syntaxique_tree->max);
+            Automate_free(a);
+            return b;
+            break;
+        }
+
+        default:
+            // lettre "normal"
+            return Automate_lettre(syntaxique_tree->etiquette,alphabet_size);
+            break;
+    }
+
+    return NULL;
+}
+
+
+
+// réserve d'ensembles libérés, propre à chaque thread pour que la bibliothèque soit réentrante
+// une liste chaînée d'ensembles libres par classe de taille : la classe k contient
+// les ensembles pouvant contenir jusqu'à 2^k éléments
+THREAD_LOCAL Ensemble* ensemble_pool[ENSEMBLE_NB_CLASSES];
+THREAD_LOCAL size_t ensemble_pool_octets = 0; // mémoire conservée dans la réserve
+
+/// @brief retourne la classe de taille d'un ensemble de `n` éléments, c'est à dire le plus petit k tel que n<=2^k
+/// @param n 
+/// @return 
+size_t Ensemble_classe(size_t n)
+{
+    if(n<=1)
+        return 0;
+#ifdef __GNUC__
+    return 64-__builtin_clzll((unsigned long long)(n-1));
+#else
+    size_t k = 0;
+    while(((size_t)1<<k)<n)
+        k++;
+    return k;
+#endif
+}
+
+/// @brief nombre d'octets occupés par les tableaux d'un ensemble de la classe `classe`
+/// @param classe 
+/// @return 
+size_t Ensemble_octets(size_t classe)
+{
+    return ((size_t)1<<classe)*(sizeof(bool)+sizeof(Sommet));
+}
+
+/// @brief libère tous les ensembles conservés dans la réserve du thread appelant
+void Ensemble_pool_teardown(void)
+{
+    for(size_t k=0;k<ENSEMBLE_NB_CLASSES;k++)
+    {
+        while(ensemble_pool[k]!=NULL)
+        {
+            Ensemble* e = ensemble_pool[k];
+            ensemble_pool[k] = e->suivant;
+            Memoire_rendre(Ensemble_octets(k));
+            free(e->data);
+            free(e->elements);
+            free(e);
+        }
+    }
+    ensemble_pool_octets = 0;
+}
+
+/// @brief Instancie un ensemble dont le nombre d'élément ne dépassera pas `n`
+/// l'ensemble est initialement vide
+/// @note O(1) en plus de la remise à zéro : on reprend le premier ensemble libre de la classe de `n`
+/// @param n 
+/// @return un pointeur vers un ensemble
+Ensemble* Ensemble_init(size_t n)
+{   
+    size_t classe = Ensemble_classe(n);
+    Ensemble* e = ensemble_pool[classe];
+    if(e!=NULL)
+    {
+        ensemble_pool[classe] = e->suivant;
+        ensemble_pool_octets -= Ensemble_octets(classe);
+    }else // pas d'ensemble libre de cette classe
+    {
+        e = malloc(sizeof(Ensemble));
+        Memoire_prendre(Ensemble_octets(classe));
+        e->classe = classe;
+        e->data = malloc(sizeof(bool)*((size_t)1<<classe));
+        e->elements = malloc(sizeof(Sommet)*((size_t)1<<classe));
+    }
+
+    e->size = n;
+    e->cardinal = 0;
+    e->suivant = NULL;
+    memset(e->data,0,sizeof(bool)*n);
+    return e;
+}
+
+/// @brief rend un ensemble à la réserve du thread appelant, 
+/// ou le libère si la réserve dépasse `ENSEMBLE_POOL_MAX_OCTETS`
+/// @param e 
+void Ensemble_free(Ensemble* e)
+{
+    size_t octets = Ensemble_octets(e->classe);
+    // au-delà de la limite de mémoire, la réserve n'est plus remplie
+    if(ensemble_pool_octets+octets>ENSEMBLE_POOL_MAX_OCTETS || Memoire_depassee())
+    {
+        Memoire_rendre(octets);
+        free(e->data);
+        free(e->elements);
+        free(e);
+        return;
+    }
+
+    e->suivant = ensemble_pool[e->classe];
+    ensemble_pool[e->classe] = e;
+    ensemble_pool_octets += octets;
+}
+
+void Ensemble_print(Ensemble* e)
+{
+    printf("{");
+    for(size_t i=0;i<e->size;i++)
+        if(e->data[i])
+            printf("%ld;",i);
+    printf("}\n");
+}
+
+/// @brief Ajoute un élément à un ensemble
+/// @param e 
+/// @param s 
+void Ensemble_add(Ensemble* e,Sommet s)
+{
+    if(e->data[s])
+        return;
+    e->data[s] = true;
+    e->elements[e->cardinal++] = s;
+}
+
+/// @brief teste si un élément est dans un ensemble
+/// @param e 
+/// @param s 
+/// @return true si `s` est dans `e`
+bool Ensemble_mem(Ensemble* e,Sommet s)
+{
+    return e->data[s];
+}
+
+/// @brief Instancie une copie d'un ensemble
+/// @param e 
+/// @return 
+Ensemble* Ensemble_copy(Ensemble* e)
+{
+    Ensemble* new_e = Ensemble_init(e->size);
+    Ensemble_copy_into(new_e,e);
+    return new_e;
+}
+
+/// @brief copie le contenu de `source` dans `dest` sans allouer de mémoire
+/// @note O(nombre d'éléments de `dest` et de `source`)
+/// @param dest ensemble de même taille que `source`
+/// @param source 
+void Ensemble_copy_into(Ensemble* dest,Ensemble* source)
+{
+    Ensemble_clear(dest);
+    for(size_t i=0;i<source->cardinal;i++)
+        dest->data[source->elements[i]] = true;
+    memcpy(dest->elements,source->elements,source->cardinal*sizeof(Sommet));
+    dest->cardinal = source->cardinal;
+}
+
+/// @brief vide un ensemble
+/// @note O(nombre d'éléments) : seules les cases actives sont remises à zéro
+/// @param e 
+void Ensemble_clear(Ensemble* e)
+{
+    for(size_t i=0;i<e->cardinal;i++)
+        e->data[e->elements[i]] = false;
+    e->cardinal = 0;
+}
+
+/// @brief Instancie un nouvel enemble contenant tous les éléments de a et de b
+/// @param a 
+/// @param b 
+/// @return 
+Ensemble* Ensemble_merge(Ensemble* a,Ensemble* b)
+{
+    Ensemble* c = Ensemble_copy(a);
+    for(size_t i=0;i<b->cardinal;i++)
+        Ensemble_add(c,b->elements[i]);
+    return c;
+}
+
+/// @brief retourne si un ensemble est vide
+/// @param e
+/// @return true si l'ensemble est vide, false sinon
+bool Ensemble_vide(Ensemble* e)
+{
+    return e->cardinal==0;
+}
+
+/// @brief teste si deux ensembles de même taille ont les mêmes éléments
+/// @param a 
+/// @param b 
+/// @return 
+bool Ensemble_egal(Ensemble* a,Ensemble* b)
+{
+    if(a->cardinal!=b->cardinal)
+        return false;
+    for(size_t i=0;i<a->cardinal;i++)
+        if(!b->data[a->elements[i]])
+            return false;
+    return true;
+}
+
+/// @brief insère tous les éléments d'une liste dans un ensemble
+/// @param e 
+/// @param list 
+void Ensemble_eat_list(Ensemble* e,ListArray* list)
+{
+    for(size_t i=0;i<list->size;i++)
+        Ensemble_add(e,list->data[i]);
+}
+
+void _rec_cloture_etat_depth_search(Automate* a,Sommet q,Ensemble* vus)
+{
+    if(Ensemble_mem(vus,q))
+    {
+        return;
+    }else
+    {
+        Ensemble_add(vus,q);
+        for(size_t i=0;i<a->transitions[q][EPSILON_TRANSITION_INDEX]->size;i++)
+            _rec_cloture_etat_depth_search(a,a->transitions[q][EPSILON_TRANSITION_INDEX]->data[i],vus);
+    }
+}
+
+/// @brief retoune la cloture instantanée d'un état dans un automate à epsilon transition
+/// @param a 
+/// @param q 
+/// @return 
+Ensemble* Automate_cloture_instantanee_etat(Automate* a,Sommet q)
+{
+    Ensemble* cloture = Ensemble_init(a->nb_etat);
+    _rec_cloture_etat_depth_search(a,q,cloture);
+    return cloture;
+}
+
+/// @brief Calcule l'union des clotures instantannées des états de `e`
+/// @param a 
+/// @param e 
+/// @return 
+Ensemble* Automate_cloture_instantanee(Automate* a,Ensemble* e)
+{
+    Ensemble* Q = Ensemble_copy(e);
+    Automate_cloture_instantanee_into(a,Q);
+    return Q;
+}
+
+/// @brief même chose que `Automate_cloture_instantanee` mais avec liberation/consommation de `e`
+/// @param a 
+/// @param e 
+/// @return 
+Ensemble* Automate_cloture_instantanee_inplace(Automate* a,Ensemble* e)
+{
+    Ensemble* temp = Automate_cloture_instantanee(a,e);
+    Ensemble_free(e);
+    return temp;
+}
+
+
+/// @brief Calcule sur place l'union des clotures instantannées des états de `e`
+/// @note n'alloue aucune mémoire, contrairement à `Automate_cloture_instantanee`
+/// parcours en largeur : la liste des éléments actifs de `e` sert de file
+/// @param a 
+/// @param e ensemble complété par sa cloture instantanée
+void Automate_cloture_instantanee_into(Automate* a,Ensemble* e)
+{
+    for(size_t i=0;i<e->cardinal;i++)
+    {
+        ListArray* epsilon = a->transitions[e->elements[i]][EPSILON_TRANSITION_INDEX];
+        for(size_t j=0;j<epsilon->size;j++)
+            Ensemble_add(e,epsilon->data[j]);
+    }
+}
+
+/// @brief retourne l'ensemble des états accessibles dans l'automate `a`
+/// depuis les états de `e` en lisant la lettre l
+/// @warning les epsilon transition ne sont pas considérées
+/// @param a 
+/// @param e 
+/// @param l 
+/// @return 
+Ensemble* Automate_read_letter(Automate* a,Ensemble* e,size_t l)
+{
+    Ensemble* dest = Ensemble_init(a->nb_etat);
+    Automate_read_letter_into(a,e,l,dest);
+    return dest;
+}
+
+/// @brief même chose que `Automate_read_letter` mais le résultat est écrit dans `dest` (préalablement vidé)
+/// @param a 
+/// @param e 
+/// @param l 
+/// @param dest ensemble de taille `a->nb_etat`
+void Automate_read_letter_into(Automate* a,Ensemble* e,size_t l,Ensemble* dest)
+{
+    Ensemble_clear(dest);
+    // '\0' (indice des epsilon transitions) et les octets hors de l'alphabet ne sont lus que par des classes
+    if(l!=EPSILON_TRANSITION_INDEX && l<a->alphabet_size)
+    {
+        for(size_t i=0;i<e->cardinal;i++)
+            Ensemble_eat_list(dest,a->transitions[e->elements[i]][l]);
+    }
+
+    if(a->classes_debut!=NULL && e->cardinal<a->nb_classes)
+    {
+        // seules les transitions par classe des états actifs (moins nombreux que les transitions par classe)
+        for(size_t i=0;i<e->cardinal;i++)
+        {
+            Sommet q = e->elements[i];
+            for(size_t c=a->classes_debut[q];c<a->classes_debut[q+1];c++)
+                if(Classe_mem(&a->classes[c].classe,l))
+                    Ensemble_add(dest,a->classes[c].dest);
+        }
+        return;
+    }
+    for(size_t c=0;c<a->nb_classes;c++)
+    {
+        TransitionClasse* t = &a->classes[c];
+        if(Ensemble_mem(e,t->source) && Classe_mem(&t->classe,l))
+            Ensemble_add(dest,t->dest);
+    }
+}
+
+/// @brief nombre de mots d'un tableau `bits` de `a` : les vecteurs de bits des compteurs, suivis du nombre de compteurs
+/// en cours (dont un vecteur n'est pas nul), de leurs numéros (au delà de COMPTEURS_LISTE_MIN compteurs seulement),
+/// puis pour chaque compteur des mots utiles de ses vecteurs
+/// (les mots au delà valent 0, quel que soit leur contenu ; 0 pour un compteur qui n'est pas en cours)
+/// @param a 
+/// @return 
+size_t Automate_mots_bits(Automate* a)
+{
+    return a->nb_mots_compteurs+1+2*a->nb_compteurs;
+}
+
+/// @brief aucun décompte en cours
+/// @param a 
+/// @param bits tableau de `Automate_mots_bits(a)` mots
+void Automate_compteurs_clear(Automate* a,uint64_t* bits)
+{
+    memset(bits+a->nb_mots_compteurs,0,sizeof(uint64_t)*(1+2*a->nb_compteurs));
+}
+
+/// @brief fait avancer les compteurs de `a` à la lecture de la lettre `l`
+/// et ajoute à `dest` la sortie de chaque compteur dont le nombre de copies terminées est dans [min;max]
+/// @note seuls les compteurs en cours et ceux dont l'entrée est active sont lus (voir `Automate_mots_bits`)
+/// @param a 
+/// @param e états courants (après cloture instantanée)
+/// @param bits vecteurs de bits courants des compteurs
+/// @param l 
+/// @param dest états après lecture de `l`
+/// @param dest_bits vecteurs de bits des compteurs après lecture de `l`
+void Automate_read_compteurs(Automate* a,Ensemble* e,uint64_t* bits,size_t l,Ensemble* dest,uint64_t* dest_bits)
+{
+    if(a->nb_compteurs==0)
+        return;
+    uint64_t* en_cours = bits+a->nb_mots_compteurs;
+    uint64_t* hauts = en_cours+1+a->nb_compteurs;
+    uint64_t* dest_en_cours = dest_bits+a->nb_mots_compteurs;
+    uint64_t* dest_hauts = dest_en_cours+1+a->nb_compteurs;
+
+    if(a->nb_compteurs<=COMPTEURS_LISTE_MIN)
+    {
+        // peu de compteurs : les parcourir coûte moins que tenir la liste de ceux en cours
+        size_t nb = 0;
+        for(size_t c=0;c<a->nb_compteurs;c++)
+        {
+            bool entree = Ensemble_mem(e,a->compteurs[c].entree);
+            size_t haut = 0;
+            if(entree || hauts[c]>0)
+                haut = Compteur_lire(&a->compteurs[c],entree,bits,hauts[c],l,dest,dest_bits);
+            dest_hauts[c] = haut;
+            nb += haut>0;
+        }
+        dest_en_cours[0] = nb;
+        return;
+    }
+
+    // `dest_bits` contient une lecture plus ancienne : ses compteurs en cours sont arrêtés
+    for(size_t i=0;i<dest_en_cours[0];i++)
+        dest_hauts[dest_en_cours[1+i]] = 0;
+    dest_en_cours[0] = 0;
+
+    // décomptes en cours (leur entrée peut aussi être active)
+    for(size_t i=0;i<en_cours[0];i++)
+    {
+        size_t c = en_cours[1+i];
+        size_t haut = Compteur_lire(&a->compteurs[c],Ensemble_mem(e,a->compteurs[c].entree),bits,hauts[c],l,dest,dest_bits);
+        if(haut>0)
+        {
+            dest_hauts[c] = haut;
+            dest_en_cours[1+dest_en_cours[0]++] = c;
+        }
+    }
+
+    // décomptes qui commencent : compteurs arrêtés dont l'entrée est active,
+    // cherchés parmi les compteurs des états actifs si ils sont moins nombreux que les compteurs
+    bool index = a->compteurs_debut!=NULL && e->cardinal<a->nb_compteurs;
+    size_t nb = index?e->cardinal:a->nb_compteurs;
+    for(size_t i=0;i<nb;i++)
+    {
+        size_t premier = i;
+        size_t fin = i+1;
+        if(index)
+        {
+            premier = a->compteurs_debut[e->elements[i]];
+            fin = a->compteurs_debut[e->elements[i]+1];
+        }else if(hauts[i]>0 || !Ensemble_mem(e,a->compteurs[i].entree))
+            continue;
+        for(size_t c=premier;c<fin;c++)
+        {
+            if(hauts[c]>0)
+                continue;
+            size_t haut = Compteur_lire(&a->compteurs[c],true,bits,0,l,dest,dest_bits);
+            if(haut>0)
+            {
+                dest_hauts[c] = haut;
+                dest_en_cours[1+dest_en_cours[0]++] = c;
+            }
+        }
+    }
+}
+
+/// @brief fait avancer un compteur à la lecture de la lettre `l` (voir `Automate_read_compteurs`)
+/// @param k 
+/// @param entree l'entrée de `k` est active : un décompte commence
+/// @param bits 
+/// @param haut mots utiles des vecteurs de `k` dans `bits`
+/// @param l 
+/// @param dest 
+/// @param dest_bits 
+/// @return mots utiles des vecteurs de `k` dans `dest_bits`, 0 si le compteur s'arrête
+size_t Compteur_lire(Compteur* k,bool entree,uint64_t* bits,size_t haut,size_t l,Ensemble* dest,uint64_t* dest_bits)
+{
+    uint64_t* source = bits+k->offset;
+    uint64_t* cible = dest_bits+k->offset;
+    size_t n = k->largeur;
+
+    // rangs gardés : au plus borne-1 copies terminées pendant la lecture d'une copie de e{min,max},
+    // borne pour e{min,} (le rang min est saturant)
+    size_t limite = (k->max==REPETITION_INFINIE)?k->borne:k->borne-1;
+    size_t mot_limite = limite/64;
+    uint64_t masque_limite = ((limite%64)==63)?~(uint64_t)0:(((uint64_t)1<<(limite%64+1))-1);
+    size_t seuil = (k->min>0)?k->min-1:0; // une copie terminée au rang seuil ou plus permet de sortir
+    uint64_t retenue = 0;
+    size_t nouveau_haut = 0;
+
+    // un décompte avance d'au plus un rang par lettre : un mot utile de plus au plus
+    size_t mots = min(haut+1,mot_limite+1);
+    if(k->nb_positions==1 && k->suivants[0]==0)
+    {
+        // e lit exactement une lettre : la lettre décale le vecteur d'un rang, ou interrompt les décomptes
+        if(!Classe_mem(&k->positions[0],l))
+            return 0;
+        for(size_t w=0;w<mots;w++)
+        {
+            uint64_t v = (w<haut)?source[w]:0;
+            uint64_t d = (v<<1)|retenue;
+            retenue = v>>63;
+            cible[w] = d;
+        }
+        cible[0] |= entree?1:0;
+        if(k->max==REPETITION_INFINIE && k->borne/64<haut)
+            cible[k->borne/64] |= source[k->borne/64]&((uint64_t)1<<(k->borne%64));
+        if(mot_limite<mots)
+            cible[mot_limite] &= masque_limite;
+        nouveau_haut = mots;
+        while(nouveau_haut>0 && cible[nouveau_haut-1]==0)
+            nouveau_haut--;
+        if(seuil/64<nouveau_haut && (nouveau_haut>seuil/64+1 || (cible[seuil/64]>>(seuil%64))!=0))
+            Ensemble_add(dest,k->sortie);
+        return nouveau_haut;
+    }
+
+    // positions qui acceptent `l` : les autres interrompent leurs décomptes
+    uint64_t acceptees = 0;
+    for(size_t j=0;j<k->nb_positions;j++)
+        if(l<256 && Classe_mem(&k->positions[j],l))
+            acceptees |= (uint64_t)1<<j;
+    if(acceptees==0)
+        return 0;
+
+    bool sortie = false;
+    for(size_t w=0;w<mots;w++)
+    {
+        // rangs des lectures entre deux copies : copie terminée (décalage d'un rang) ou décompte qui commence
+        uint64_t terminees = 0;
+        if(w<haut)
+            for(size_t j=0;j<k->nb_positions;j++)
+                if((k->derniers>>j)&1)
+                    terminees |= source[j*n+w];
+        uint64_t debut = (terminees<<1)|retenue|((w==0 && entree)?1:0);
+        retenue = terminees>>63;
+        if(k->max==REPETITION_INFINIE && w==k->borne/64)
+            debut |= terminees&((uint64_t)1<<(k->borne%64));
+
+        uint64_t nouvelles_terminees = 0;
+        uint64_t utiles = 0;
+        for(size_t j=0;j<k->nb_positions;j++)
+        {
+            uint64_t v = 0;
+            if((acceptees>>j)&1)
+            {
+                if((k->premiers>>j)&1)
+                    v = debut;
+                if(w<haut)
+                    for(size_t i=0;i<k->nb_positions;i++)
+                        if((k->suivants[i]>>j)&1)
+                            v |= source[i*n+w];
+                if(w==mot_limite)
+                    v &= masque_limite;
+            }
+            cible[j*n+w] = v;
+            utiles |= v;
+            if((k->derniers>>j)&1)
+                nouvelles_terminees |= v;
+        }
+        if(utiles!=0)
+            nouveau_haut = w+1;
+
+        // une copie terminée au rang r donne r+1 copies : il faut r+1>=min
+        if(w>seuil/64)
+            sortie = sortie || nouvelles_terminees!=0;
+        else if(w==seuil/64)
+            sortie = sortie || (nouvelles_terminees>>(seuil%64))!=0;
+    }
+    if(sortie)
+        Ensemble_add(dest,k->sortie);
+    return nouveau_haut;
+}
+
+/// @brief lit une lettre : transitions, compteurs puis cloture instantanée
+/// @param a 
+/// @param e états courants
+/// @param bits vecteurs de bits courants des compteurs de `a`
+/// @param l 
+/// @param dest états après lecture de `l` (écrasé)
+/// @param dest_bits vecteurs de bits après lecture de `l` (écrasé)
+void Automate_step(Automate* a,Ensemble* e,uint64_t* bits,size_t l,Ensemble* dest,uint64_t* dest_bits)
+{
+    Automate_read_letter_into(a,e,l,dest);
+    Automate_read_compteurs(a,e,bits,l,dest,dest_bits);
+    Automate_cloture_instantanee_into(a,dest);
+}
+
+/// @brief détermine si la lecture est terminée : aucun état actif et aucun compteur en cours
+/// @param a 
+/// @param e états courants
+/// @param bits vecteurs de bits courants des compteurs de `a`
+/// @return true si plus aucune lettre ne peut mener à un état final
+bool Automate_is_dead(Automate* a,Ensemble* e,uint64_t* bits)
+{
+    return Ensemble_vide(e) && Automate_compteurs_inactifs(a,bits);
+}
+
+/// @brief détermine si aucun compteur de `a` n'a de décompte en cours
+/// @param a 
+/// @param bits vecteurs de bits courants des compteurs de `a`
+/// @return 
+bool Automate_compteurs_inactifs(Automate* a,uint64_t* bits)
+{
+    return a->nb_compteurs==0 || bits[a->nb_mots_compteurs]==0;
+}
+
+/// @brief cherche l'état de repos de `a` : les états actifs lorsqu'aucune lecture n'est en cours 
+/// (pour l'automate (.)*e, seul le préfixe (.)* est actif), et les lettres qui le laissent inchangé
+/// depuis l'état de repos, ces lettres peuvent être sautées sans les lire
+/// @param a 
+/// @param init cloture des états initiaux de `a`
+/// @param neutres classe des lettres neutres (vide si il n'y a pas d'état de repos)
+/// @return l'ensemble des états de repos, ou NULL si aucun n'a été trouvé
+Ensemble* Automate_repos(Automate* a,Ensemble* init,Classe* neutres)
+{
+    Classe_clear(neutres);
+    Ensemble* repos = Ensemble_init(a->nb_etat);
+    Ensemble* dest = Ensemble_init(a->nb_etat);
+    uint64_t* bits = calloc(Automate_mots_bits(a),sizeof(uint64_t));
+    uint64_t* repos_bits = calloc(Automate_mots_bits(a),sizeof(uint64_t));
+    uint64_t* dest_bits = calloc(Automate_mots_bits(a),sizeof(uint64_t));
+
+    // l'état de repos est un point fixe atteint depuis les états initiaux par une lettre qui ne commence aucun motif
+    bool trouve = false;
+    for(Lettre l=0;!trouve && l<256;l++)
+    {
+        Automate_step(a,init,bits,l,repos,repos_bits);
+        if(!Automate_compteurs_inactifs(a,repos_bits) || Automate_is_final_ensemble(a,repos))
+            continue;
+        Automate_step(a,repos,repos_bits,l,dest,dest_bits);
+        trouve = Ensemble_egal(dest,repos) && Automate_compteurs_inactifs(a,dest_bits);
+    }
+
+    if(trouve)
+    {
+        for(Lettre l=0;l<256;l++)
+        {
+            Automate_step(a,repos,repos_bits,l,dest,dest_bits);
+            if(Ensemble_egal(dest,repos) && Automate_compteurs_inactifs(a,dest_bits))
+                Classe_add(neutres,l);
+        }
+    }else
+    {
+        Ensemble_free(repos);
+        repos = NULL;
+    }
+
+    free(bits);
+    free(repos_bits);
+    free(dest_bits);
+    Ensemble_free(dest);
+    return repos;
+}
+
+/// @brief détermine si il y a un état final dans un ensemble
+/// @param a 
+/// @param e 
+/// @return 
+bool Automate_is_final_ensemble(Automate* a,Ensemble* e)
+{
+    for(size_t i=0;i<a->finaux->size;i++)
+    {
+        if(Ensemble_mem(e,a->finaux->data[i]))
+            return true;
+    }
+    return false;
+}
+
+/// @brief retourne la cloture instantanée des états initiaux d'un automate, 
+/// c'est à dire l'ensemble des états actifs avant toute lecture
+/// @param a 
+/// @return 
+Ensemble* Automate_initiaux_clos(Automate* a)
+{
+    Ensemble* initiaux = Ensemble_init(a->nb_etat);
+    Ensemble_eat_list(initiaux,a->initiaux);
+    Automate_cloture_instantanee_into(a,initiaux);
+    return initiaux;
+}
+
+/// @brief détermine si un mot est reconnu par un automate
+/// @param a 
+/// @param init cloture des états initiaux de `a` (voir `Automate_initiaux_clos`)
+/// @param s brouillon dont les ensembles `R` et `next_R` sont de taille `a->nb_etat`
+/// @param word 
+/// @param size nombre de lettres de `word`
+/// @return 
+bool Automate_read_word(Automate* a,Ensemble* init,Scratch* s,const unsigned char* word,size_t size)
+{
+    // on part des états initiaux et des états dans leur cloture instantanée
+    Ensemble* Q = s->R;
+    Ensemble* next_Q = s->next_R;
+    uint64_t* bits = s->bits_R;
+    uint64_t* next_bits = s->bits_next_R;
+    Ensemble_copy_into(Q,init);
+    Automate_compteurs_clear(a,bits);
+
+    // on lit ensuite chaque lettre de manière itérative
+    // sans oublie de calculer la cloture instantanée à chaque fois
+    for(size_t index=0;index<size;index++)
+    {
+        Automate_step(a,Q,bits,word[index],next_Q,next_bits);
+
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+
+        // plus aucun état actif : inutile de lire la suite du mot
+        if(Automate_is_dead(a,Q,bits))
+        {
+            s->octets_lus += index+1;
+            s->octets_evites += size-index-1;
+            return false;
+        }
+    }
+
+    // on regarde si il y a un état final dans les états obtenus
+    s->octets_lus += size;
+    return Automate_is_final_ensemble(a,Q);
+}
+
+/// @brief retourne un automate, inverse le sens de ses transitions et inverse initiaux et finaux
+/// @param a 
+/// @return un nouvel automate
+Automate* Automate_reverse(Automate* a)
+{
+    Automate* b = Automate_init(a->nb_etat,a->alphabet_size);
+    
+    // on inverse initiaux et finaux
+    ListArray_extend(b->initiaux,a->finaux);
+    ListArray_extend(b->finaux,a->initiaux);
+
+    // on inverse les transitions
+    for(Sommet source=0;source<a->nb_etat;source++)
+    {
+        for(Lettre l=0;l<a->alphabet_size;l++)
+        {
+            for(size_t i=0;i<a->transitions[source][l]->size;i++)
+            {
+                Sommet dest = a->transitions[source][l]->data[i];
+                Automate_add_transition(b,dest,l,source);
+            }
+        }
+    }
+
+    // une transition par classe ou un compteur se lit dans l'autre sens en échangeant ses extrémités
+    Automate_add_classes_et_compteurs(b,a,0);
+    for(size_t c=0;c<b->nb_classes;c++)
+    {
+        Sommet temp = b->classes[c].source;
+        b->classes[c].source = b->classes[c].dest;
+        b->classes[c].dest = temp;
+    }
+    for(size_t c=0;c<b->nb_compteurs;c++)
+        Compteur_inverser(&b->compteurs[c]);
+
+    return b;
+}
+
+
+Automate* Automate_line(Automate* a)
+{
+    // on construit l'automate reconnaissant ".*e" avec e l'expression régulière dont le langage est dénoté par a
+    // c'est à dire "(.)*e", où le préfixe lit n'importe quel octet (y compris '\0' et ceux hors de l'alphabet)
+    Classe octets;
+    Classe_clear(&octets);
+    Classe_add_range(&octets,0,255);
+    Automate* b = Automate_classe(&octets,a->alphabet_size);
+    Automate* c = Automate_etoile(b);
+    Automate* temp = Automate_concatenation(c,a);
+    Automate_free(b);
+    Automate_free(c);
+    return temp;
+}
+
+/// @brief lit une chaîne de caractère à partir de l'index `from` et détecte le premier motif reconnu par l'automate `a`
+/// @note on privilégiera toujours les motifs les plus petits : 
+/// exemple avec le texte "abab" et l'automate reconnaissant "a(a|b)*b", "abab" est vu comme deux motifs
+/// @warning find("ab*a","aabbbaba") -> aa et aba donc [1;7]
+/// @param line_automate automate reconnaissant (.)*e
+/// @param line_init cloture des états initiaux de `line_automate`
+/// @param repos états de repos de `line_automate`, ou NULL (voir `Automate_repos`)
+/// @param neutres lettres qui laissent `repos` inchangé
+/// @param acceleration lettres de sortie de `repos`, cherchées directement si il est accéléré (voir `Acceleration_init`)
+/// @param s brouillon dont les ensembles `Q` et `next_Q` sont de taille `line_automate->nb_etat`
+/// @param line 
+/// @param size nombre de lettres de `line`
+/// @param from index de la première lettre à lire
+/// @param end index de la dernière lettre du motif trouvé
+/// @return true si un motif a été trouvé
+bool find_motif_end_index(Automate* line_automate,Ensemble* line_init,Ensemble* repos,const Classe* neutres,const Acceleration* acceleration,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* end)
+{
+    Ensemble* Q = s->Q;
+    Ensemble* next_Q = s->next_Q;
+    uint64_t* bits = s->bits_Q;
+    uint64_t* next_bits = s->bits_next_Q;
+    Ensemble_copy_into(Q,line_init);
+    Automate_compteurs_clear(line_automate,bits);
+
+    // motif vide : il finit avant la première lettre
+    if(Automate_is_final_ensemble(line_automate,Q))
+    {
+        *end = from;
+        return true;
+    }
+
+    // tant que l'automate de l'expression est mort (seul le préfixe (.)* est actif), 
+    // les lettres neutres ne changent rien et ne sont pas lues
+    bool au_repos = false;
+    size_t lus = 0;
+    for(size_t current_index=from;current_index<size;current_index++)
+    {
+        if(au_repos && Classe_mem(neutres,line[current_index]))
+        {
+            size_t debut = current_index;
+            if(acceleration->active)
+                current_index += Acceleration_sauter(acceleration,line+current_index,size-current_index);
+            else
+                while(current_index<size && Classe_mem(neutres,line[current_index]))
+                    current_index++;
+            s->octets_evites += current_index-debut;
+            if(current_index==size)
+                break;
+        }
+
+        Automate_step(line_automate,Q,bits,line[current_index],next_Q,next_bits);
+        lus++;
+
+        if(Automate_is_final_ensemble(line_automate,next_Q))
+        {
+            // current_index est donc le dernier carectère d'un motif reconnu
+            *end = current_index+1;
+            s->octets_lus += lus;
+            return true;
+        }
+
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+
+        au_repos = repos!=NULL && Ensemble_egal(Q,repos) && Automate_compteurs_inactifs(line_automate,bits);
+    }
+
+    s->octets_lus += lus;
+    return false;
+}
+
+/// @brief Retrouve l'index du début le plus à gauche des motifs reconnus par `a` qui finissent à `end`
+/// (obtenu précedemment avec `find_motif_end_index`)
+/// la lecture continue tant qu'un état de l'automate inversé est actif
+/// @param reverse_automate automate inverse de `a`
+/// @param reverse_init cloture des états initiaux de `reverse_automate`
+/// @param s brouillon dont les ensembles `R` et `next_R` sont de taille `reverse_automate->nb_etat`
+/// @param line 
+/// @param from index en deça duquel le motif ne peut pas commencer
+/// @param end index qui suit la dernière lettre du motif
+/// @return l'index de la première lettre du motif (`end` pour un motif vide)
+size_t find_motif_start_index(Automate* reverse_automate,Ensemble* reverse_init,Scratch* s,const unsigned char* line,size_t from,size_t end)
+{
+    Ensemble* Q = s->R;
+    Ensemble* next_Q = s->next_R;
+    uint64_t* bits = s->bits_R;
+    uint64_t* next_bits = s->bits_next_R;
+    Ensemble_copy_into(Q,reverse_init);
+    Automate_compteurs_clear(reverse_automate,bits);
+
+    // on relit la ligne de droite à gauche, le dernier état final atteint donne le début le plus à gauche
+    size_t start = end;
+    for(size_t current_index=end;current_index>from;current_index--)
+    {
+        Automate_step(reverse_automate,Q,bits,line[current_index-1],next_Q,next_bits);
+        s->octets_lus++;
+        if(Automate_is_final_ensemble(reverse_automate,next_Q))
+            start = current_index-1;
+        if(Automate_is_dead(reverse_automate,next_Q,next_bits))
+            break;
+
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+    }
+
+    return start;
+}
+
+/// @brief cherche la première fin d'un motif reconnu par l'automate `a` qui commence dans [from;limite[
+/// (les états initiaux sont ajoutés avant chaque lettre de [from;limite[)
+/// @param a automate de l'expression (sans le préfixe (.)*)
+/// @param init cloture des états initiaux de `a`
+/// @param s brouillon dont les ensembles `R` et `next_R` sont de taille `a->nb_etat`
+/// @param line 
+/// @param size 
+/// @param from 
+/// @param limite 
+/// @param end index qui suit la dernière lettre du motif
+/// @return true si un tel motif existe
+bool find_motif_avant(Automate* a,Ensemble* init,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t limite,size_t* end)
+{
+    Ensemble* Q = s->R;
+    Ensemble* next_Q = s->next_R;
+    uint64_t* bits = s->bits_R;
+    uint64_t* next_bits = s->bits_next_R;
+    Ensemble_clear(Q);
+    Automate_compteurs_clear(a,bits);
+
+    for(size_t current_index=from;current_index<size;current_index++)
+    {
+        if(current_index<limite)
+            for(size_t i=0;i<init->cardinal;i++)
+                Ensemble_add(Q,init->elements[i]);
+        Automate_step(a,Q,bits,line[current_index],next_Q,next_bits);
+        s->octets_lus++;
+        if(Automate_is_final_ensemble(a,next_Q))
+        {
+            *end = current_index+1;
+            return true;
+        }
+        if(current_index+1>=limite && Automate_is_dead(a,next_Q,next_bits))
+            return false;
+
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+    }
+
+    return false;
+}
+
+/// @brief cherche le plus long facteur de `line` commençant à `from` reconnu par l'automate `a`
+/// (le plus long préfixe pour un motif ancré en début de ligne)
+/// la lecture s'arrête dès qu'il n'y a plus d'état actif
+/// @param a automate de l'expression (sans le préfixe (.)*)
+/// @param init cloture des états initiaux de `a`
+/// @param s brouillon dont les ensembles `R` et `next_R` sont de taille `a->nb_etat`
+/// @param line 
+/// @param size 
+/// @param from index de la première lettre du facteur
+/// @param end index qui suit la dernière lettre du facteur
+/// @return true si un tel facteur existe
+bool find_motif_prefixe(Automate* a,Ensemble* init,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* end)
+{
+    Ensemble* Q = s->R;
+    Ensemble* next_Q = s->next_R;
+    uint64_t* bits = s->bits_R;
+    uint64_t* next_bits = s->bits_next_R;
+    Ensemble_copy_into(Q,init);
+    Automate_compteurs_clear(a,bits);
+
+    // le facteur vide est reconnu si les états initiaux sont finaux
+    bool trouve = Automate_is_final_ensemble(a,Q);
+    if(trouve)
+        *end = from;
+    for(size_t current_index=from;current_index<size;current_index++)
+    {
+        Automate_step(a,Q,bits,line[current_index],next_Q,next_bits);
+        s->octets_lus++;
+        if(Automate_is_final_ensemble(a,next_Q))
+        {
+            *end = current_index+1;
+            trouve = true;
+        }
+        if(Automate_is_dead(a,next_Q,next_bits))
+        {
+            s->octets_evites += size-current_index-1;
+            return trouve;
+        }
+
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+    }
+
+    return trouve;
+}
+
+/// @brief cherche le plus long suffixe de `line` (commençant au plus tôt à `from`) reconnu par l'automate (motif ancré en fin de ligne)
+/// en lisant la ligne de droite à gauche avec l'automate inverse, jusqu'à ce qu'il n'y ait plus d'état actif
+/// @param reverse_automate automate inverse de l'expression
+/// @param reverse_init cloture des états initiaux de `reverse_automate`
+/// @param s brouillon dont les ensembles `R` et `next_R` sont de taille `reverse_automate->nb_etat`
+/// @param line 
+/// @param size 
+/// @param from 
+/// @param start index de la première lettre du suffixe (`size` pour le suffixe vide)
+/// @return true si un tel suffixe existe
+bool find_motif_suffixe(Automate* reverse_automate,Ensemble* reverse_init,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* start)
+{
+    if(from>size)
+        return false;
+
+    Ensemble* Q = s->R;
+    Ensemble* next_Q = s->next_R;
+    uint64_t* bits = s->bits_R;
+    uint64_t* next_bits = s->bits_next_R;
+    Ensemble_copy_into(Q,reverse_init);
+    Automate_compteurs_clear(reverse_automate,bits);
+
+    bool trouve = Automate_is_final_ensemble(reverse_automate,Q);
+    if(trouve)
+        *start = size;
+
+    for(size_t current_index=size;current_index>from;current_index--)
+    {
+        Automate_step(reverse_automate,Q,bits,line[current_index-1],next_Q,next_bits);
+        s->octets_lus++;
+        if(Automate_is_final_ensemble(reverse_automate,next_Q))
+        {
+            *start = current_index-1;
+            trouve = true;
+        }
+        if(Automate_is_dead(reverse_automate,next_Q,next_bits))
+        {
+            s->octets_evites += current_index-1-from;
+            return trouve;
+        }
+
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+    }
+
+    return trouve;
+}
+
+/*
+    Interface publique de la bibliothèque (voir mygrep.h)
+*/
+
+// flux des messages d'erreur de la compilation, propre à chaque thread (NULL : stderr)
+THREAD_LOCAL FILE* motif_erreurs = NULL;
+
+void Motif_erreurs(FILE* flux)
+{
+    motif_erreurs = flux;
+}
+
+/// @brief flux sur lequel la compilation décrit ses erreurs (voir `Motif_erreurs`)
+FILE* Motif_flux_erreurs(void)
+{
+    return motif_erreurs!=NULL?motif_erreurs:stderr;
+}
+
+Motif* Motif_compile(const char* regular_expression,size_t alphabet_size)
+{
+    return Motif_compile_approche(regular_expression,alphabet_size,0);
+}
+
+Motif* Motif_compile_approche(const char* regular_expression,size_t alphabet_size,size_t erreurs)
+{
+    Motif* m = malloc(sizeof(Motif));
+    m->alphabet_size = alphabet_size;
+    m->erreurs = erreurs;
+    m->tree = NULL;
+    m->automate = NULL;
+    m->reverse_automate = NULL;
+    m->line_automate = NULL;
+    m->init = NULL;
+    m->reverse_init = NULL;
+    m->line_init = NULL;
+    m->line_repos = NULL;
+    Classe_clear(&m->line_neutres);
+    m->line_acceleration.active = false;
+    m->ancre_debut = false;
+    m->ancre_fin = false;
+    m->plan.litteral = NULL;
+    m->plan.bndm = NULL;
+    m->plan.teddy = NULL;
+    m->plan.sans_reduction = false;
+    m->plan.sans_glushkov = false;
+    m->plan.sans_prefiltre = false;
+    m->memoire_arbre = 0;
+    m->plan.glushkov = NULL;
+    m->plan.glushkov_inverse = NULL;
+
+    size_t size = strlen(regular_expression);
+    m->regular_expression = malloc(sizeof(Lettre)*(size+1));
+    for(size_t i=0;i<size+1;i++)
+        m->regular_expression[i] = (unsigned char)regular_expression[i];
+
+    m->tree = make_syntaxique_tree(m->regular_expression);
+    if(m->tree==NULL)
+    {
+        fprintf(Motif_flux_erreurs(),"Impossible de comprendre l'expression !\n");
+        Motif_free(m);
+        return NULL;
+    }
+    // l'arbre est compté dès son analyse, puis recompté après sa simplification
+    m->nb_noeuds_initial = Tree_nb_noeuds(m->tree);
+    m->memoire_arbre = m->nb_noeuds_initial*Memoire_bloc(sizeof(Tree));
+    Memoire_prendre(m->memoire_arbre);
+    m->tree = Tree_simplifier(m->tree,alphabet_size);
+    size_t memoire_simplifie = Tree_nb_noeuds(m->tree)*Memoire_bloc(sizeof(Tree));
+    if(memoire_simplifie>m->memoire_arbre)
+        Memoire_prendre(memoire_simplifie-m->memoire_arbre);
+    else
+        Memoire_rendre(m->memoire_arbre-memoire_simplifie);
+    m->memoire_arbre = memoire_simplifie;
+
+    // la recherche approchée ne lit pas les compteurs : ses répétitions sont dépliées
+    // (au plus GLUSHKOV_POSITIONS_MAX positions avec Glushkov, sinon Wu-Manber sur les ensembles d'états de l'automate)
+    m->automate = make_thomson_automate(m->tree,alphabet_size,m->erreurs==0);
+    if(m->automate==NULL)
+    {
+        fprintf(Motif_flux_erreurs(),"Impossible de construire l'automate associé à l'expression %s !\n",regular_expression);
+        Motif_free(m);
+        return NULL;
+    }
+
+    // l'automate inverse et l'automate (.)*e sont deux copies de l'automate, indispensables à la recherche
+    size_t octets = Automate_octets(m->automate->nb_etat+1,alphabet_size);
+    if(!Memoire_disponible((AUTOMATE_COPIES-1)*octets))
+    {
+        fprintf(Motif_flux_erreurs(),"Automate trop grand pour la limite de mémoire : %zu octets nécessaires\n",AUTOMATE_COPIES*octets);
+        Motif_free(m);
+        return NULL;
+    }
+
+    // automate réduit : mêmes mots reconnus, moins d'états à parcourir à chaque lettre
+    // (la réduction construit une copie : sans la place de cette copie et des deux autres, l'automate est gardé tel quel)
+    m->nb_etats_initial = m->automate->nb_etat;
+    m->plan.sans_reduction = !Memoire_disponible(AUTOMATE_COPIES*octets);
+    if(!m->plan.sans_reduction)
+    {
+        Automate* reduit = Automate_reduire(m->automate);
+#ifdef DEBUG
+        if(Automate_equivalents(m->automate,reduit,4096)==0)
+        {
+            fprintf(Motif_flux_erreurs(),"La réduction a changé le langage de l'automate, l'automate de Thomson est conservé !\n");
+            Automate_free(reduit);
+            reduit = Automate_copy(m->automate);
+        }
+#endif
+        Automate_free(m->automate);
+        m->automate = reduit;
+    }
+
+    for(Tree* t=m->tree;(t->etiquette==SYNTAXE_ANCRE_DEBUT || t->etiquette==SYNTAXE_ANCRE_FIN) && t->left_chilfren!=NULL;t=t->left_chilfren)
+    {
+        if(t->etiquette==SYNTAXE_ANCRE_DEBUT)
+            m->ancre_debut = true;
+        else
+            m->ancre_fin = true;
+    }
+
+    m->reverse_automate = Automate_reverse(m->automate);
+    Automate_indexer(m->automate);
+    Automate_indexer(m->reverse_automate);
+    m->init = Automate_initiaux_clos(m->automate);
+    m->reverse_init = Automate_initiaux_clos(m->reverse_automate);
+
+    // un motif ancré en début de ligne est lu directement par l'automate, sans le préfixe (.)*
+    if(!m->ancre_debut)
+    {
+        Automate* line = Automate_line(m->automate);
+        if(m->plan.sans_reduction)
+            m->line_automate = line;
+        else
+        {
+            m->line_automate = Automate_reduire(line);
+            Automate_free(line);
+        }
+        Automate_indexer(m->line_automate);
+        m->line_init = Automate_initiaux_clos(m->line_automate);
+        m->line_repos = Automate_repos(m->line_automate,m->line_init,&m->line_neutres);
+        if(m->line_repos!=NULL)
+            Acceleration_init(&m->line_acceleration,&m->line_neutres);
+    }
+
+    Motif_planifier(m);
+    if(m->erreurs>0 && m->plan.glushkov==NULL)
+    {
+        // chaque brouillon garde 2(K+1)+1 ensembles d'états (voir `Scratch_init`)
+        size_t n = m->automate->nb_etat;
+        if(m->line_automate!=NULL)
+            n = max(n,m->line_automate->nb_etat);
+        size_t octets = (2*(m->erreurs+1)+1)*Ensemble_octets(Ensemble_classe(n));
+        if(!Memoire_disponible(octets))
+        {
+            fprintf(Motif_flux_erreurs(),"Recherche approchée avec %zu erreurs trop grande pour la limite de mémoire : %zu octets nécessaires\n",m->erreurs,octets);
+            Motif_free(m);
+            return NULL;
+        }
+    }
+    return m;
+}
+
+void Motif_free(Motif* m)
+{
+    if(m==NULL)
+        return;
+
+    if(m->init!=NULL)Ensemble_free(m->init);
+    if(m->reverse_init!=NULL)Ensemble_free(m->reverse_init);
+    if(m->line_init!=NULL)Ensemble_free(m->line_init);
+    if(m->line_repos!=NULL)Ensemble_free(m->line_repos);
+    if(m->automate!=NULL)Automate_free(m->automate);
+    if(m->reverse_automate!=NULL)Automate_free(m->reverse_automate);
+    if(m->line_automate!=NULL)Automate_free(m->line_automate);
+    if(m->tree!=NULL)Tree_free(m->tree);
+    Memoire_rendre(m->memoire_arbre);
+    free(m->plan.litteral);
+    if(m->plan.bndm!=NULL)Bndm_free(m->plan.bndm);
+    if(m->plan.teddy!=NULL)Teddy_free(m->plan.teddy);
+    if(m->plan.glushkov!=NULL)Glushkov_free(m->plan.glushkov);
+    if(m->plan.glushkov_inverse!=NULL)Glushkov_free(m->plan.glushkov_inverse);
+    free(m->regular_expression);
+    free(m);
+}
+
+void Motif_print(const Motif* m)
+{
+    printf("arbre syntaxique : ");Tree_print(m->tree);
+    printf(" (%ld noeuds, %ld avant simplification)\n",m->plan.nb_noeuds,m->nb_noeuds_initial);
+    Automate_print(m->automate);
+}
+
+Scratch* Scratch_init(const Motif* m)
+{
+    Scratch* s = malloc(sizeof(Scratch));
+    Automate* line_automate = (m->line_automate!=NULL)?m->line_automate:m->automate;
+    s->Q = Ensemble_init(line_automate->nb_etat);
+    s->next_Q = Ensemble_init(line_automate->nb_etat);
+    s->R = Ensemble_init(m->automate->nb_etat);
+    s->next_R = Ensemble_init(m->automate->nb_etat);
+    // au moins un mot : le nombre de compteurs en cours (voir `Automate_mots_bits`)
+    s->bits_Q = calloc(Automate_mots_bits(line_automate),sizeof(uint64_t));
+    s->bits_next_Q = calloc(Automate_mots_bits(line_automate),sizeof(uint64_t));
+    s->bits_R = calloc(Automate_mots_bits(m->automate),sizeof(uint64_t));
+    s->bits_next_R = calloc(Automate_mots_bits(m->automate),sizeof(uint64_t));
+    // recherche approchée : K+1 lignes courantes et K+1 lignes suivantes
+    s->erreurs = m->erreurs;
+    s->rangs = NULL;
+    s->rangs_suivants = NULL;
+    s->ensembles = NULL;
+    s->ensembles_suivants = NULL;
+    s->tampon = NULL;
+    if(m->erreurs>0)
+    {
+        s->rangs = malloc(sizeof(uint64_t)*(m->erreurs+1));
+        s->rangs_suivants = malloc(sizeof(uint64_t)*(m->erreurs+1));
+        if(m->plan.glushkov==NULL)
+        {
+            size_t n = max(line_automate->nb_etat,m->automate->nb_etat);
+            s->ensembles = malloc(sizeof(Ensemble*)*(m->erreurs+1));
+            s->ensembles_suivants = malloc(sizeof(Ensemble*)*(m->erreurs+1));
+            for(size_t i=0;i<=m->erreurs;i++)
+            {
+                s->ensembles[i] = Ensemble_init(n);
+                s->ensembles_suivants[i] = Ensemble_init(n);
+            }
+            s->tampon = Ensemble_init(n);
+        }
+    }
+    s->memoire = Memoire_bloc(sizeof(Scratch))+2*Memoire_bloc(sizeof(uint64_t)*Automate_mots_bits(line_automate))
+        +2*Memoire_bloc(sizeof(uint64_t)*Automate_mots_bits(m->automate));
+    if(m->erreurs>0)
+        s->memoire += 2*Memoire_bloc(sizeof(uint64_t)*(m->erreurs+1));
+    Memoire_prendre(s->memoire);
+    s->octets_lus = 0;
+    s->octets_evites = 0;
+    return s;
+}
+
+void Scratch_free(Scratch* s)
+{
+    if(s==NULL)
+        return;
+
+    Ensemble_free(s->Q);
+    Ensemble_free(s->next_Q);
+    Ensemble_free(s->R);
+    Ensemble_free(s->next_R);
+    free(s->bits_Q);
+    free(s->bits_next_Q);
+    free(s->bits_R);
+    free(s->bits_next_R);
+    free(s->rangs);
+    free(s->rangs_suivants);
+    if(s->ensembles!=NULL)
+    {
+        for(size_t i=0;i<=s->erreurs;i++)
+        {
+            Ensemble_free(s->ensembles[i]);
+            Ensemble_free(s->ensembles_suivants[i]);
+        }
+        free(s->ensembles);
+        free(s->ensembles_suivants);
+        Ensemble_free(s->tampon);
+    }
+    Memoire_rendre(s->memoire);
+    free(s);
+}
+
+bool Motif_match(const Motif* m,Scratch* s,const char* line,size_t size)
+{
+    if(m->plan.strategie==STRATEGIE_APPROCHE)
+        return match_approche(m,s,(const unsigned char*)line,size);
+    if(m->plan.strategie==STRATEGIE_LITTERAL)
+        return size==m->plan.litteral_size && memcmp(line,m->plan.litteral,size)==0;
+    if(m->plan.strategie==STRATEGIE_BNDM)
+        return Bndm_egal(m->plan.bndm,(const unsigned char*)line,size);
+    size_t position;
+    if(m->plan.bndm!=NULL && !Bndm_chercher(m->plan.bndm,s,(const unsigned char*)line,size,&position))
+        return false;
+    if(m->plan.teddy!=NULL && !Teddy_chercher(m->plan.teddy,s,(const unsigned char*)line,size,&position))
+        return false;
+    return Automate_read_word(m->automate,m->init,s,(const unsigned char*)line,size);
+}
+
+bool Motif_find_next(const Motif* m,Scratch* s,const char* line,size_t size,size_t from,size_t* start,size_t* end)
+{
+    if(m->plan.strategie==STRATEGIE_APPROCHE)
+        return find_approche(m,s,(const unsigned char*)line,size,from,start,end);
+    if(m->plan.strategie==STRATEGIE_LITTERAL)
+        return find_litteral(m,s,(const unsigned char*)line,size,from,start,end);
+    if(from>size)
+        return false;
+    if(m->plan.strategie==STRATEGIE_BNDM)
+    {
+        size_t position;
+        if(!Bndm_chercher(m->plan.bndm,s,(const unsigned char*)line+from,size-from,&position))
+            return false;
+        *start = from+position;
+        *end = *start+m->plan.bndm->m;
+        return true;
+    }
+    // préfiltre : tout motif qui commence après `from` contient le facteur obligatoire
+    size_t position;
+    if(m->plan.bndm!=NULL && !Bndm_chercher(m->plan.bndm,s,(const unsigned char*)line+from,size-from,&position))
+        return false;
+    if(m->plan.teddy!=NULL)
+    {
+        if(!Teddy_chercher(m->plan.teddy,s,(const unsigned char*)line+from,size-from,&position))
+            return false;
+        // aucun motif ne commence avant la première occurrence
+        if(m->plan.teddy_debut)
+            from += position;
+    }
+
+    if(m->ancre_debut && m->ancre_fin)
+    {
+        // la ligne entière doit être reconnue
+        if(from>0 || !Automate_read_word(m->automate,m->init,s,(const unsigned char*)line,size))
+            return false;
+        *start = 0;
+        *end = size;
+        return true;
+    }else if(m->ancre_debut)
+    {
+        // un seul motif possible, qui commence au début de la ligne
+        if(from>0 || !find_motif_prefixe(m->automate,m->init,s,(const unsigned char*)line,size,0,end))
+            return false;
+        *start = 0;
+        return true;
+    }else if(m->ancre_fin)
+    {
+        // un seul motif possible, qui finit à la fin de la ligne
+        if(!find_motif_suffixe(m->reverse_automate,m->reverse_init,s,(const unsigned char*)line,size,from,start))
+            return false;
+        *end = size;
+        return true;
+    }
+
+    size_t fin;
+    if(!find_motif_end_index(m->line_automate,m->line_init,m->line_repos,&m->line_neutres,&m->line_acceleration,s,(const unsigned char*)line,size,from,&fin))
+        return false;
+
+    // motif le plus à gauche puis le plus long, comme grep : un motif qui commence plus tôt finit après `fin`
+    size_t debut = find_motif_start_index(m->reverse_automate,m->reverse_init,s,(const unsigned char*)line,from,fin);
+    while(debut>from && find_motif_avant(m->automate,m->init,s,(const unsigned char*)line,size,from,debut,&fin))
+        debut = find_motif_start_index(m->reverse_automate,m->reverse_init,s,(const unsigned char*)line,from,fin);
+    size_t plus_long;
+    if(find_motif_prefixe(m->automate,m->init,s,(const unsigned char*)line,size,debut,&plus_long))
+        fin = max(fin,plus_long);
+    *start = debut;
+    *end = fin;
+    return true;
+}
+
+MotifStats Scratch_stats(const Scratch* s)
+{
+    MotifStats stats = {s->octets_lus,s->octets_evites};
+    return stats;
+}
+
+void Scratch_thread_cleanup(void)
+{
+    Ensemble_pool_teardown();
+}
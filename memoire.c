@@ -0,0 +1,103 @@
+/*
+    By Adrien Couvidat
+    budget de mémoire (--max-memory) : compte commun à tout le processus des grandes allocations
+    (automates, ensembles d'états, tables des préfiltres, tampons de lecture, caches du serveur) ;
+    ce qui ne tient pas dans la limite est construit dans une version plus économe, ou pas du tout
+*/
+
+#include "mygrep_interne.h"
+
+size_t memoire_limite = 0;      // 0 : aucune limite
+size_t memoire_utilisee = 0;
+size_t memoire_pic = 0;
+
+// les compteurs sont partagés entre threads (lecture anticipée, serveur)
+#ifdef __GNUC__
+#define MEMOIRE_LIRE(x) __atomic_load_n(&(x),__ATOMIC_RELAXED)
+#define MEMOIRE_AJOUTER(x,n) __atomic_add_fetch(&(x),(n),__ATOMIC_RELAXED)
+#define MEMOIRE_RETIRER(x,n) __atomic_sub_fetch(&(x),(n),__ATOMIC_RELAXED)
+#define MEMOIRE_REMPLACER(x,attendu,valeur) __atomic_compare_exchange_n(&(x),&(attendu),(valeur),true,__ATOMIC_RELAXED,__ATOMIC_RELAXED)
+#else
+#define MEMOIRE_LIRE(x) (x)
+#define MEMOIRE_AJOUTER(x,n) ((x) += (n))
+#define MEMOIRE_RETIRER(x,n) ((x) -= (n))
+#define MEMOIRE_REMPLACER(x,attendu,valeur) ((x)==(attendu)?((x) = (valeur),true):((attendu) = (x),false))
+#endif
+
+void Memoire_limiter(size_t octets)
+{
+    memoire_limite = octets;
+}
+
+size_t Memoire_limite(void)
+{
+    return memoire_limite;
+}
+
+size_t Memoire_utilisee(void)
+{
+    return MEMOIRE_LIRE(memoire_utilisee);
+}
+
+size_t Memoire_pic(void)
+{
+    return MEMOIRE_LIRE(memoire_pic);
+}
+
+/// @brief met à jour le pic après une augmentation de la mémoire utilisée
+/// @param utilisee
+void Memoire_noter_pic(size_t utilisee)
+{
+    size_t pic = MEMOIRE_LIRE(memoire_pic);
+    while(utilisee>pic && !MEMOIRE_REMPLACER(memoire_pic,pic,utilisee));
+}
+
+/// @brief détermine si `octets` de plus tiennent dans la limite, sans les compter
+/// @param octets
+/// @return
+bool Memoire_disponible(size_t octets)
+{
+    return memoire_limite==0 || MEMOIRE_LIRE(memoire_utilisee)+octets<=memoire_limite;
+}
+
+bool Memoire_depassee(void)
+{
+    return memoire_limite!=0 && MEMOIRE_LIRE(memoire_utilisee)>memoire_limite;
+}
+
+/// @brief compte `octets` de plus si ils tiennent dans la limite
+/// @param octets
+/// @return false si la limite serait dépassée (rien n'est alors compté)
+bool Memoire_reserver(size_t octets)
+{
+    size_t utilisee = MEMOIRE_LIRE(memoire_utilisee);
+    do
+    {
+        if(memoire_limite!=0 && utilisee+octets>memoire_limite)
+            return false;
+    }while(!MEMOIRE_REMPLACER(memoire_utilisee,utilisee,utilisee+octets));
+    Memoire_noter_pic(utilisee+octets);
+    return true;
+}
+
+/// @brief compte `octets` de plus, même au-delà de la limite (allocation indispensable)
+/// @param octets
+void Memoire_prendre(size_t octets)
+{
+    Memoire_noter_pic(MEMOIRE_AJOUTER(memoire_utilisee,octets));
+}
+
+void Memoire_rendre(size_t octets)
+{
+    MEMOIRE_RETIRER(memoire_utilisee,octets);
+}
+
+/// @brief place occupée par un bloc de `octets` alloué par malloc : un en-tête de 8 octets,
+/// arrondi à 16 octets, au moins 32 octets (glibc), négligeable sauf pour les nombreux petits blocs des automates
+/// @param octets
+/// @return
+size_t Memoire_bloc(size_t octets)
+{
+    size_t bloc = (octets+8+15)&~(size_t)15;
+    return max(32,bloc);
+}
@@ -0,0 +1,22 @@
+/*
+    By Adrien Couvidat
+    budget de mémoire (--max-memory) : primitives de comptage partagées par la bibliothèque et par mygrep
+    (tampons de lecture, de sortie et caches du serveur) ; seuls `Memoire_limiter`, `Memoire_limite` et `Memoire_pic`
+    font partie de l'interface publique (mygrep.h)
+*/
+
+#ifndef MEMOIRE_H
+#define MEMOIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+size_t Memoire_utilisee(void);
+bool Memoire_disponible(size_t octets);
+bool Memoire_depassee(void);
+bool Memoire_reserver(size_t octets);
+void Memoire_prendre(size_t octets);
+void Memoire_rendre(size_t octets);
+size_t Memoire_bloc(size_t octets);
+
+#endif // MEMOIRE_H
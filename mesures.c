@@ -0,0 +1,216 @@
+/*
+    By Adrien Couvidat
+    compteurs matériels par phase de la recherche (voir mesures.h)
+*/
+
+#define _CRT_SECURE_NO_WARNINGS // pour éviter des alerte de compilation avec msvc sous Windows
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "mesures.h"
+
+#ifdef MESURES_PERF
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char* noms_phases[PHASES_NB] = {"compilation","recherche","sortie"};
+static const char* noms_compteurs[COMPTEURS_NB] = {"cycles","instructions","défauts L1D","défauts LLC","branches manquées"};
+
+double Mesures_maintenant_ns(void)
+{
+    struct timespec t;
+#ifdef _WIN32
+    timespec_get(&t,TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC,&t);
+#endif
+    return (double)t.tv_sec*1e9+(double)t.tv_nsec;
+}
+
+#ifdef MESURES_PERF
+/// @brief ouvre un compteur pour le thread appelant, sur tous les processeurs
+/// @param type
+/// @param config
+/// @param noyau compter aussi ce qu'exécute le noyau pour le thread
+/// @return le descripteur du compteur, -1 si il est indisponible (errno indique pourquoi)
+int Mesures_ouvrir(uint32_t type,uint64_t config,bool noyau)
+{
+    struct perf_event_attr attr;
+    memset(&attr,0,sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = !noyau;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED|PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open,&attr,0,-1,-1,PERF_FLAG_FD_CLOEXEC);
+}
+
+/// @brief valeur d'un compteur depuis son ouverture
+/// @note quand il y a plus de compteurs que de registres, le noyau les fait tourner :
+/// la valeur est extrapolée au temps pendant lequel le compteur était activé
+/// @param fd
+/// @return
+double Mesures_lire(int fd)
+{
+    uint64_t valeurs[3]; // valeur, temps activé, temps compté
+    if(read(fd,valeurs,sizeof(valeurs))!=(ssize_t)sizeof(valeurs) || valeurs[2]==0)
+        return 0;
+    return (double)valeurs[0]*((double)valeurs[1]/(double)valeurs[2]);
+}
+#endif
+
+/// @brief ouvre les compteurs du thread appelant et commence la phase `phase`
+/// @note ne manque jamais : sans perf_event_open (conteneurs, autres systèmes), seuls les temps sont mesurés
+/// @param phase
+/// @return
+Mesures* Mesures_init(enum PHASE phase)
+{
+    Mesures* m = calloc(1,sizeof(Mesures));
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+        m->fd[k] = -1;
+    m->erreur = ENOSYS;
+#ifdef MESURES_PERF
+    const uint32_t types[COMPTEURS_NB] = {PERF_TYPE_HARDWARE,PERF_TYPE_HARDWARE,PERF_TYPE_HW_CACHE,PERF_TYPE_HARDWARE,PERF_TYPE_HARDWARE};
+    const uint64_t configs[COMPTEURS_NB] = {PERF_COUNT_HW_CPU_CYCLES,PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D|(PERF_COUNT_HW_CACHE_OP_READ<<8)|(PERF_COUNT_HW_CACHE_RESULT_MISS<<16),
+        PERF_COUNT_HW_CACHE_MISSES,PERF_COUNT_HW_BRANCH_MISSES};
+
+    // le noyau n'est compté que si perf_event_paranoid le permet
+    m->noyau = true;
+    m->erreur = 0;
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+    {
+        m->fd[k] = Mesures_ouvrir(types[k],configs[k],m->noyau);
+        if(m->fd[k]<0 && m->noyau && (errno==EACCES || errno==EPERM))
+        {
+            m->noyau = false;
+            for(size_t j=0;j<k;j++)
+            {
+                close(m->fd[j]);
+                m->fd[j] = Mesures_ouvrir(types[j],configs[j],false);
+            }
+            m->fd[k] = Mesures_ouvrir(types[k],configs[k],false);
+        }
+        if(m->fd[k]<0 && m->erreur==0)
+            m->erreur = errno;
+    }
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+        if(m->fd[k]>=0)
+            m->debut[k] = Mesures_lire(m->fd[k]);
+#endif
+    m->phase = phase;
+    m->debut_ns = Mesures_maintenant_ns();
+    return m;
+}
+
+void Mesures_free(Mesures* m)
+{
+    if(m==NULL)
+        return;
+#ifdef MESURES_PERF
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+        if(m->fd[k]>=0)
+            close(m->fd[k]);
+#endif
+    free(m);
+}
+
+/// @brief termine la phase en cours, dont les compteurs s'ajoutent à ses totaux, et commence la phase `phase`
+/// @param m
+/// @param phase
+/// @return la phase terminée, pour la reprendre ensuite
+enum PHASE Mesures_phase(Mesures* m,enum PHASE phase)
+{
+    enum PHASE precedente = m->phase;
+#ifdef MESURES_PERF
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+    {
+        if(m->fd[k]<0)
+            continue;
+        double valeur = Mesures_lire(m->fd[k]);
+        m->totaux[precedente][k] += valeur-m->debut[k];
+        m->debut[k] = valeur;
+    }
+#endif
+    double maintenant = Mesures_maintenant_ns();
+    m->temps_ns[precedente] += maintenant-m->debut_ns;
+    m->debut_ns = maintenant;
+    m->phase = phase;
+    return precedente;
+}
+
+/// @brief affiche une ligne du tableau : temps et compteurs, éventuellement divisés par `diviseur`
+/// @param m
+/// @param flux
+/// @param nom
+/// @param temps_ns
+/// @param totaux
+/// @param diviseur 1 pour les valeurs brutes
+void Mesures_afficher_ligne(Mesures* m,FILE* flux,const char* nom,double temps_ns,const double* totaux,double diviseur)
+{
+    fprintf(flux,"%-12s",nom);
+    if(diviseur==1)
+        fprintf(flux," %12.3f",temps_ns/1e6);
+    else
+        fprintf(flux," %12.3f",temps_ns/diviseur);
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+    {
+        if(m->fd[k]<0)
+            fprintf(flux," %18s","-");
+        else if(diviseur==1)
+            fprintf(flux," %18.0f",totaux[k]);
+        else
+            fprintf(flux," %18.4f",totaux[k]/diviseur);
+    }
+    if(m->fd[COMPTEUR_CYCLES]>=0 && m->fd[COMPTEUR_INSTRUCTIONS]>=0 && totaux[COMPTEUR_CYCLES]>0)
+        fprintf(flux," %6.2f",totaux[COMPTEUR_INSTRUCTIONS]/totaux[COMPTEUR_CYCLES]);
+    fprintf(flux,"\n");
+}
+
+/// @brief termine la phase en cours et affiche les totaux de chaque phase, puis ramenés à chaque octet lu
+/// @param m
+/// @param flux
+/// @param octets octets lus dans l'entrée
+void Mesures_afficher(Mesures* m,FILE* flux,size_t octets)
+{
+    Mesures_phase(m,m->phase);
+
+    size_t disponibles = 0;
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+        disponibles += m->fd[k]>=0;
+    if(disponibles==0)
+        fprintf(flux,"compteurs matériels indisponibles (perf_event_open : %s), seuls les temps sont mesurés\n",strerror(m->erreur));
+    else
+        fprintf(flux,"compteurs matériels du thread principal (%s)%s\n",m->noyau?"noyau compris":"espace utilisateur seulement",
+            disponibles<COMPTEURS_NB?", - : compteur indisponible":"");
+
+    double total_ns = 0;
+    double total[COMPTEURS_NB] = {0};
+    for(size_t p=0;p<PHASES_NB;p++)
+    {
+        total_ns += m->temps_ns[p];
+        for(size_t k=0;k<COMPTEURS_NB;k++)
+            total[k] += m->totaux[p][k];
+    }
+
+    fprintf(flux,"%-12s %12s","phase","temps (ms)");
+    for(size_t k=0;k<COMPTEURS_NB;k++)
+        fprintf(flux," %18s",noms_compteurs[k]);
+    fprintf(flux," %6s\n","IPC");
+    for(size_t p=0;p<PHASES_NB;p++)
+        Mesures_afficher_ligne(m,flux,noms_phases[p],m->temps_ns[p],m->totaux[p],1);
+    Mesures_afficher_ligne(m,flux,"total",total_ns,total,1);
+
+    if(octets>0)
+    {
+        fprintf(flux,"par octet lu (%zu octets), temps en ns :\n",octets);
+        Mesures_afficher_ligne(m,flux,noms_phases[PHASE_RECHERCHE],m->temps_ns[PHASE_RECHERCHE],m->totaux[PHASE_RECHERCHE],(double)octets);
+        Mesures_afficher_ligne(m,flux,"total",total_ns,total,(double)octets);
+    }
+}
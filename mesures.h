@@ -0,0 +1,57 @@
+/*
+    By Adrien Couvidat
+    compteurs matériels du processeur par phase de la recherche (--perf-counters) :
+    cycles, instructions, défauts de cache L1D et LLC et branches mal prédites, lus avec perf_event_open sous Linux
+*/
+
+#ifndef MESURES_H
+#define MESURES_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#define MESURES_PERF // perf_event_open est disponible
+#endif
+
+enum PHASE
+{
+    PHASE_COMPILATION,
+    PHASE_RECHERCHE,
+    PHASE_SORTIE,
+    PHASES_NB
+};
+
+enum COMPTEUR_MATERIEL
+{
+    COMPTEUR_CYCLES,
+    COMPTEUR_INSTRUCTIONS,
+    COMPTEUR_L1D,
+    COMPTEUR_LLC,
+    COMPTEUR_BRANCHES,
+    COMPTEURS_NB
+};
+
+/// @brief compteurs ouverts pour le thread qui appelle `Mesures_init`, et leurs totaux par phase
+/// (un compteur indisponible garde son descripteur à -1, seuls les temps sont alors mesurés)
+struct Mesures
+{
+    int fd[COMPTEURS_NB];
+    bool noyau;                 // les compteurs comptent aussi ce qu'exécute le noyau pour le thread (écritures, lectures)
+    int erreur;                 // errno de la première ouverture impossible, 0 si aucune
+    enum PHASE phase;           // phase en cours
+    double debut[COMPTEURS_NB]; // valeurs des compteurs au début de la phase en cours
+    double debut_ns;
+    double totaux[PHASES_NB][COMPTEURS_NB];
+    double temps_ns[PHASES_NB];
+};
+typedef struct Mesures Mesures;
+
+Mesures* Mesures_init(enum PHASE phase);
+void Mesures_free(Mesures* m);
+enum PHASE Mesures_phase(Mesures* m,enum PHASE phase);
+void Mesures_afficher(Mesures* m,FILE* flux,size_t octets);
+
+#endif // MESURES_H
@@ -0,0 +1,462 @@
+/*
+    By Adrien Couvidat
+    micro-benchmarks des briques de libmygrep (make microbench) : analyse de l'expression, construction de l'automate
+    de Thomson et de son inverse, clotures instantanées, lecture d'une lettre et ensembles d'états.
+    Chaque noyau est mesuré pour des tailles croissantes : la colonne `pente` donne l'exposant de la croissance
+    entre deux tailles (1 pour un coût linéaire, 2 pour un coût quadratique)
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <time.h>
+
+#include "mygrep_interne.h"
+
+#define MICROBENCH_REPETITIONS 7        // mesures gardées pour chaque taille (-r)
+#define MICROBENCH_CIBLE_NS 2000000.0   // durée visée d'une mesure : le noyau est répété jusqu'à l'atteindre
+#define MICROBENCH_TEXTE 4096           // lettres lues par les noyaux de lecture
+#define MICROBENCH_ALPHABET 255
+
+/*
+    Mesure
+*/
+
+/// @brief une exécution du noyau mesuré, qui compte `ops` opérations
+typedef void (*Noyau)(void* contexte);
+
+/// @brief durées d'une opération, en nanosecondes
+struct Mesure
+{
+    double moyenne;
+    double ecart_type;
+    double min;
+};
+typedef struct Mesure Mesure;
+
+size_t repetitions = MICROBENCH_REPETITIONS;
+volatile size_t puits; // résultats des noyaux sans effet, pour que le compilateur ne les supprime pas
+
+double maintenant_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return (double)t.tv_sec*1e9+(double)t.tv_nsec;
+}
+
+/// @brief durée de `iterations` exécutions du noyau
+/// @param noyau
+/// @param contexte
+/// @param iterations
+/// @return en nanosecondes
+double chronometrer(Noyau noyau,void* contexte,size_t iterations)
+{
+    double debut = maintenant_ns();
+    for(size_t i=0;i<iterations;i++)
+        noyau(contexte);
+    return maintenant_ns()-debut;
+}
+
+/// @brief mesure le coût d'une opération du noyau : une exécution d'étalonnage fixe le nombre d'itérations
+/// d'une mesure (au moins MICROBENCH_CIBLE_NS), une mesure de chauffe est ignorée, puis `repetitions` mesures sont gardées
+/// @param noyau
+/// @param contexte
+/// @param ops opérations par exécution du noyau
+/// @return
+Mesure mesurer(Noyau noyau,void* contexte,size_t ops)
+{
+    double duree = chronometrer(noyau,contexte,1);
+    size_t iterations = 1;
+    if(duree<MICROBENCH_CIBLE_NS)
+        iterations = (size_t)(MICROBENCH_CIBLE_NS/max(duree,1.0))+1;
+    chronometrer(noyau,contexte,iterations);
+
+    double* durees = malloc(sizeof(double)*repetitions);
+    Mesure m = {0,0,INFINITY};
+    for(size_t r=0;r<repetitions;r++)
+    {
+        durees[r] = chronometrer(noyau,contexte,iterations)/((double)iterations*(double)max(ops,(size_t)1));
+        m.moyenne += durees[r];
+        m.min = min(m.min,durees[r]);
+    }
+    m.moyenne /= (double)repetitions;
+    for(size_t r=0;r<repetitions;r++)
+        m.ecart_type += (durees[r]-m.moyenne)*(durees[r]-m.moyenne);
+    m.ecart_type = repetitions>1?sqrt(m.ecart_type/(double)(repetitions-1)):0;
+    free(durees);
+    return m;
+}
+
+/// @brief affiche une ligne de la courbe d'un noyau
+/// @param nom
+/// @param taille
+/// @param m
+/// @param precedente mesure de la taille précédente (`taille_precedente` vaut 0 pour la première)
+/// @param taille_precedente
+void afficher(const char* nom,size_t taille,Mesure m,Mesure precedente,size_t taille_precedente)
+{
+    printf("%-16s %8zu %12.1f %7.1f%% %12.1f",nom,taille,m.moyenne,m.moyenne>0?100*m.ecart_type/m.moyenne:0,m.min);
+    if(taille_precedente>0 && precedente.min>0 && taille>taille_precedente)
+        printf(" %7.2f",log(m.min/precedente.min)/log((double)taille/(double)taille_precedente));
+    printf("\n");
+}
+
+/*
+    Données générées
+*/
+
+/// @brief expression d'environ `taille` lettres, suite de motifs élémentaires variés (lettres, unions, étoiles, classes)
+/// @param taille
+/// @return à libérer avec free
+char* generer_expression(size_t taille)
+{
+    static const char* motifs[] = {"a","(b|c)","d*","[e-h]","(ij|k)?","l","(m|no)*","p"};
+    size_t nb_motifs = sizeof(motifs)/sizeof(motifs[0]);
+    char* er = malloc(taille+1);
+    size_t size = 0;
+    for(size_t i=0;;i++)
+    {
+        const char* motif = motifs[i%nb_motifs];
+        size_t n = strlen(motif);
+        if(size>0 && size+n>taille)
+            break;
+        memcpy(er+size,motif,n);
+        size += n;
+    }
+    er[size] = '\0';
+    return er;
+}
+
+/// @brief lettres de l'expression, terminées par 0 (voir `Motif_compile_approche`)
+/// @param er
+/// @return à libérer avec free
+Lettre* lettres_expression(const char* er)
+{
+    size_t size = strlen(er);
+    Lettre* lettres = malloc(sizeof(Lettre)*(size+1));
+    for(size_t i=0;i<size+1;i++)
+        lettres[i] = (unsigned char)er[i];
+    return lettres;
+}
+
+/// @brief texte pseudo-aléatoire sur les lettres des expressions générées, pour garder des états actifs
+/// @param texte
+/// @param size
+void generer_texte(unsigned char* texte,size_t size)
+{
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for(size_t i=0;i<size;i++)
+    {
+        x ^= x<<13;
+        x ^= x>>7;
+        x ^= x<<17;
+        texte[i] = (unsigned char)('a'+x%16);
+    }
+}
+
+/*
+    Noyaux
+*/
+
+struct Contexte
+{
+    Lettre* expression;
+    Tree* tree;
+    Automate* automate;
+    Motif* motif;
+    Ensemble* e;
+    Ensemble* f;
+    uint64_t* bits;
+    uint64_t* next_bits;
+    unsigned char texte[MICROBENCH_TEXTE];
+    size_t n;
+};
+typedef struct Contexte Contexte;
+
+void noyau_analyse(void* contexte)
+{
+    Contexte* c = contexte;
+    Tree_free(make_syntaxique_tree(c->expression));
+}
+
+void noyau_thomson(void* contexte)
+{
+    Contexte* c = contexte;
+    Automate_free(make_thomson_automate(c->tree,MICROBENCH_ALPHABET,true));
+}
+
+void noyau_inverse(void* contexte)
+{
+    Contexte* c = contexte;
+    Automate_free(Automate_reverse(c->automate));
+}
+
+/// @brief cloture instantanée de chacun des états de l'automate
+void noyau_cloture(void* contexte)
+{
+    Contexte* c = contexte;
+    for(Sommet q=0;q<c->automate->nb_etat;q++)
+    {
+        Ensemble_clear(c->e);
+        Ensemble_add(c->e,q);
+        Automate_cloture_instantanee_into(c->automate,c->e);
+    }
+}
+
+/// @brief lecture du texte lettre par lettre avec `Automate_read_letter` (un nouvel ensemble par lettre)
+void noyau_lecture(void* contexte)
+{
+    Contexte* c = contexte;
+    Automate* a = c->motif->line_automate;
+    Ensemble* Q = Ensemble_copy(c->motif->line_init);
+    for(size_t i=0;i<MICROBENCH_TEXTE;i++)
+    {
+        Ensemble* suivant = Automate_read_letter(a,Q,c->texte[i]);
+        Automate_cloture_instantanee_into(a,suivant);
+        Ensemble_free(Q);
+        Q = suivant;
+    }
+    Ensemble_free(Q);
+}
+
+/// @brief lecture du texte avec `Automate_step`, le pas du moteur de recherche (ensembles et compteurs réutilisés)
+void noyau_pas(void* contexte)
+{
+    Contexte* c = contexte;
+    Automate* a = c->motif->line_automate;
+    Ensemble* Q = c->e;
+    Ensemble* next_Q = c->f;
+    uint64_t* bits = c->bits;
+    uint64_t* next_bits = c->next_bits;
+    Ensemble_copy_into(Q,c->motif->line_init);
+    Automate_compteurs_clear(a,bits);
+    for(size_t i=0;i<MICROBENCH_TEXTE;i++)
+    {
+        Automate_step(a,Q,bits,c->texte[i],next_Q,next_bits);
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+    }
+}
+
+void noyau_ensemble_init(void* contexte)
+{
+    Contexte* c = contexte;
+    Ensemble_free(Ensemble_init(c->n));
+}
+
+/// @brief vide l'ensemble puis y ajoute un élément sur quatre
+void noyau_ensemble_ajout(void* contexte)
+{
+    Contexte* c = contexte;
+    Ensemble_clear(c->e);
+    for(Sommet s=0;s<c->n;s+=4)
+        Ensemble_add(c->e,s);
+}
+
+void noyau_ensemble_mem(void* contexte)
+{
+    Contexte* c = contexte;
+    size_t trouves = 0;
+    for(Sommet s=0;s<c->n;s++)
+        trouves += Ensemble_mem(c->e,s);
+    puits = trouves;
+}
+
+void noyau_ensemble_copie(void* contexte)
+{
+    Contexte* c = contexte;
+    Ensemble_copy_into(c->f,c->e);
+}
+
+void noyau_ensemble_egal(void* contexte)
+{
+    Contexte* c = contexte;
+    puits = Ensemble_egal(c->e,c->f);
+}
+
+/*
+    Courbes
+*/
+
+// la construction de l'automate de Thomson est quadratique : au-delà de 512 lettres, une mesure prend des secondes
+static const size_t tailles_expression[] = {16,32,64,128,256,512};
+static const size_t tailles_ensemble[] = {64,512,4096,32768,262144};
+#define NB_TAILLES(tailles) (sizeof(tailles)/sizeof(tailles[0]))
+
+/// @brief mesure les noyaux de l'analyse, de la construction et de la lecture pour chaque taille d'expression
+/// @param nom noyau à mesurer
+void courbe_automate(const char* nom)
+{
+    Mesure precedente = {0,0,0};
+    size_t taille_precedente = 0;
+    for(size_t t=0;t<NB_TAILLES(tailles_expression);t++)
+    {
+        char* er = generer_expression(tailles_expression[t]);
+        size_t taille = strlen(er);
+        Contexte* c = malloc(sizeof(Contexte));
+        c->expression = lettres_expression(er);
+        c->tree = Tree_simplifier(make_syntaxique_tree(c->expression),MICROBENCH_ALPHABET);
+        c->automate = make_thomson_automate(c->tree,MICROBENCH_ALPHABET,true);
+        c->motif = NULL;
+        c->e = NULL;
+        c->f = NULL;
+        c->bits = NULL;
+        c->next_bits = NULL;
+        generer_texte(c->texte,MICROBENCH_TEXTE);
+
+        Mesure m;
+        if(strcmp(nom,"analyse")==0)
+            m = mesurer(noyau_analyse,c,1);
+        else if(strcmp(nom,"thomson")==0)
+            m = mesurer(noyau_thomson,c,1);
+        else if(strcmp(nom,"inverse")==0)
+            m = mesurer(noyau_inverse,c,1);
+        else if(strcmp(nom,"cloture")==0)
+        {
+            c->e = Ensemble_init(c->automate->nb_etat);
+            m = mesurer(noyau_cloture,c,c->automate->nb_etat);
+        }else
+        {
+            // automate (.)*e réduit, celui que lit la recherche
+            c->motif = Motif_compile(er,MICROBENCH_ALPHABET);
+            Automate* a = c->motif->line_automate;
+            c->e = Ensemble_init(a->nb_etat);
+            c->f = Ensemble_init(a->nb_etat);
+            c->bits = calloc(Automate_mots_bits(a),sizeof(uint64_t));
+            c->next_bits = calloc(Automate_mots_bits(a),sizeof(uint64_t));
+            m = mesurer(strcmp(nom,"lecture")==0?noyau_lecture:noyau_pas,c,MICROBENCH_TEXTE);
+        }
+        afficher(nom,taille,m,precedente,taille_precedente);
+        precedente = m;
+        taille_precedente = taille;
+
+        if(c->e!=NULL)Ensemble_free(c->e);
+        if(c->f!=NULL)Ensemble_free(c->f);
+        free(c->bits);
+        free(c->next_bits);
+        Motif_free(c->motif);
+        Automate_free(c->automate);
+        Tree_free(c->tree);
+        free(c->expression);
+        free(c);
+        free(er);
+    }
+}
+
+/// @brief mesure un noyau des ensembles d'états pour chaque taille d'ensemble
+/// @param nom noyau à mesurer
+void courbe_ensemble(const char* nom)
+{
+    Mesure precedente = {0,0,0};
+    size_t taille_precedente = 0;
+    for(size_t t=0;t<NB_TAILLES(tailles_ensemble);t++)
+    {
+        Contexte* c = malloc(sizeof(Contexte));
+        c->n = tailles_ensemble[t];
+        c->e = Ensemble_init(c->n);
+        c->f = Ensemble_init(c->n);
+        for(Sommet s=0;s<c->n;s+=4)
+        {
+            Ensemble_add(c->e,s);
+            Ensemble_add(c->f,s);
+        }
+
+        Mesure m;
+        if(strcmp(nom,"ensemble_init")==0)
+            m = mesurer(noyau_ensemble_init,c,1);
+        else if(strcmp(nom,"ensemble_ajout")==0)
+            m = mesurer(noyau_ensemble_ajout,c,(c->n+3)/4);
+        else if(strcmp(nom,"ensemble_mem")==0)
+            m = mesurer(noyau_ensemble_mem,c,c->n);
+        else if(strcmp(nom,"ensemble_copie")==0)
+            m = mesurer(noyau_ensemble_copie,c,1);
+        else
+            m = mesurer(noyau_ensemble_egal,c,1);
+        afficher(nom,c->n,m,precedente,taille_precedente);
+        precedente = m;
+        taille_precedente = c->n;
+
+        Ensemble_free(c->e);
+        Ensemble_free(c->f);
+        free(c);
+    }
+}
+
+struct Courbe
+{
+    const char* nom;
+    void (*mesurer)(const char* nom);
+    const char* description;
+};
+typedef struct Courbe Courbe;
+
+static const Courbe courbes[] = {
+    {"analyse",courbe_automate,"make_syntaxique_tree, ns par expression (taille : lettres de l'expression)"},
+    {"thomson",courbe_automate,"make_thomson_automate, ns par automate"},
+    {"inverse",courbe_automate,"Automate_reverse, ns par automate"},
+    {"cloture",courbe_automate,"Automate_cloture_instantanee_into d'un état, ns par état"},
+    {"lecture",courbe_automate,"Automate_read_letter et cloture, ns par lettre lue"},
+    {"pas",courbe_automate,"Automate_step sur l'automate (.)*e réduit, ns par lettre lue"},
+    {"ensemble_init",courbe_ensemble,"Ensemble_init et Ensemble_free, ns par ensemble (taille : états)"},
+    {"ensemble_ajout",courbe_ensemble,"Ensemble_clear puis Ensemble_add, ns par ajout"},
+    {"ensemble_mem",courbe_ensemble,"Ensemble_mem, ns par test"},
+    {"ensemble_copie",courbe_ensemble,"Ensemble_copy_into d'un ensemble plein au quart, ns par copie"},
+    {"ensemble_egal",courbe_ensemble,"Ensemble_egal de deux ensembles égaux, ns par comparaison"},
+};
+#define NB_COURBES (sizeof(courbes)/sizeof(courbes[0]))
+
+void usage(FILE* flux)
+{
+    fprintf(flux,"usage : microbench [-r repetitions] [noyau ...]\nnoyaux :\n");
+    for(size_t i=0;i<NB_COURBES;i++)
+        fprintf(flux,"    %-16s %s\n",courbes[i].nom,courbes[i].description);
+}
+
+int main(int argc,char** argv)
+{
+    bool choisis[NB_COURBES] = {false};
+    bool tous = true;
+    for(int i=1;i<argc;i++)
+    {
+        if(strcmp(argv[i],"-h")==0 || strcmp(argv[i],"--help")==0)
+        {
+            usage(stdout);
+            return 0;
+        }else if(strcmp(argv[i],"-r")==0 && i+1<argc)
+        {
+            repetitions = (size_t)atoll(argv[++i]);
+            if(repetitions==0)
+            {
+                fprintf(stderr,"Nombre de répétitions incorrect : %s !\n",argv[i]);
+                return 1;
+            }
+            continue;
+        }
+        size_t k = 0;
+        while(k<NB_COURBES && strcmp(courbes[k].nom,argv[i])!=0)
+            k++;
+        if(k==NB_COURBES)
+        {
+            fprintf(stderr,"Noyau inconnu : %s !\n",argv[i]);
+            usage(stderr);
+            return 1;
+        }
+        choisis[k] = true;
+        tous = false;
+    }
+
+    printf("%-16s %8s %12s %8s %12s %7s\n","noyau","taille","ns/op","écart","min ns/op","pente");
+    for(size_t i=0;i<NB_COURBES;i++)
+    {
+        if(!tous && !choisis[i])
+            continue;
+        courbes[i].mesurer(courbes[i].nom);
+        fflush(stdout);
+    }
+    Scratch_thread_cleanup();
+    return 0;
+}
@@ -1,7 +1,10 @@
 /*
     By Adrien Couvidat
     compilation :
-    gcc -Wall -Werror -Ofast mygrep.c -o mygrep 
+    make release
+    (ou gcc -Wall -Werror -Ofast libmygrep.c mygrep.c -o mygrep)
+
+    mygrep n'est qu'un client de libmygrep (voir mygrep.h)
 */
 
 #define _CRT_SECURE_NO_WARNINGS // pour éviter des alerte de compilation avec msvc sous Windows
@@ -14,1513 +17,119 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
+
+#include "mygrep.h"
+#include "entree.h"
+#include "lecture.h"
+#include "sortie.h"
+#include "mesures.h"
+#include "trace.h"
+#include "serveur.h"
+
+#ifdef LECTURE_DISPONIBLE
+#include <sys/stat.h>
+#endif
 
-#define max(a,b) ((a>b)?a:b)
-#define min(a,b) ((a>b)?b:a)
-
-typedef size_t Sommet;
-typedef size_t Lettre;
-
-/*
-    Première Partie
-    Creation d'un arbre syntaxique depuis une expression rationnelle sous forme de chaîne de caractère
-*/
-
-#define SYNTAXE_OPERATOR_CONCATENATION '@' // priorité 2
-#define SYNTAXE_OPERATOR_ETOILE '*' // priorité 1
-#define SYNTAXE_OPERATOR_UNION '|'  // priorité 3
-#define SYNTAXE_OPERATOR_SIGMA '.'
-#define SYNTAXE_OPERATOR_JOKER '?' // priorité 0
-
-Lettre OPERATORS[] = {SYNTAXE_OPERATOR_ETOILE,SYNTAXE_OPERATOR_CONCATENATION,SYNTAXE_OPERATOR_UNION};
-
-bool is_operator(Lettre l)
-{
-    return  l==SYNTAXE_OPERATOR_CONCATENATION ||
-            l==SYNTAXE_OPERATOR_ETOILE ||
-            l==SYNTAXE_OPERATOR_JOKER ||
-            l==SYNTAXE_OPERATOR_UNION;
-}
-
-bool is_operator_binaire(Lettre l)
-{
-    return  l==SYNTAXE_OPERATOR_CONCATENATION ||
-            l==SYNTAXE_OPERATOR_UNION;
-}
-
-bool is_operator_unaire(Lettre l)
-{
-    return  l==SYNTAXE_OPERATOR_ETOILE ||
-            l==SYNTAXE_OPERATOR_JOKER ;
-}
-
-struct Tree
-{
-    Lettre etiquette;
-
-    struct Tree* left_chilfren;
-    struct Tree* right_children;
-
-};
-
-/// @brief Structure représentant un arbre syntaxique 
-/// l'étiquette est un opérateur autorisé ou une lettre
-/// `left_children` et `right_children` sont les enfants du noeud
-/// @note le noeud n'a pas d'enfant si et seulement si `left_children=NULL`
-/// @note le noeud n'a qu'un seul enfant si et seulement si  `right_children=NULL`
-typedef struct Tree Tree;
-
-Tree* Tree_init(Lettre etiquette,Tree* left,Tree* right)
-{
-    Tree* t = malloc(sizeof(Tree));
-    t->etiquette = etiquette;
-    t->left_chilfren = left;
-    t->right_children = right;
-    return t;
-}
-
-void Tree_free(Tree* tree)
-{
-    if(tree==NULL)
-        return;
-
-    if(tree->right_children!=NULL)
-    {
-        Tree_free(tree->right_children);
-    }
-    if(tree->left_chilfren!=NULL)
-    {
-        Tree_free(tree->left_chilfren);
-    }
-    free(tree);
-}
-
-/// @brief affiche l'arbre dans le terminal
-/// @param tree arbre à afficher (peut-être NULL)
-/// @return 
-void Tree_print(Tree* tree)
-{
-    if(tree==NULL)
-        return;
-
-    if(tree->left_chilfren!=NULL)
-    {
-        printf("(");
-        Tree_print(tree->left_chilfren);
-        printf(")");
-    }
-    //printf("%c[%ld]",(char)tree->etiquette,tree->etiquette);
-    printf("%c",(char)tree->etiquette);
-    if(tree->right_children!=NULL)
-    {
-        printf("(");
-        Tree_print(tree->right_children);
-        printf(")");
-    }
-
-    fflush(stdout);
-}
-
-/// @brief retourne si un arbre est réduit à sa racine
-/// @param tree 
-/// @return 
-bool is_racine(Tree* tree)
-{
-    return tree->left_chilfren==NULL && tree->right_children==NULL;
-}
-
-
-/// @brief retourne le premier Tree* non NULL dans `er` et le remplace par NULL
-Tree* get_next_tree(Tree** er,size_t er_size)
-{
-    for(size_t i=0;i<er_size;i++)
-    {
-        if(er[i]!=NULL)
-        {
-            Tree* temp = er[i];
-            er[i] = NULL;
-            return temp;
-        }
-    }
-    return NULL;
-}
-
-int operator_unaire_merge(Tree** er,size_t er_size,Lettre operator)
-{
-    int count = 0;
-    Tree* last_tree = NULL;
-    size_t last_tree_index = 0;
-    for(size_t index=0;index<er_size;index++)
-    {
-        if(er[index] == NULL)
-        {
-            continue;
-        }
-        if(er[index]->etiquette == operator && is_racine(er[index]))
-        {
-            if(last_tree==NULL)
-            {
-                fprintf(stderr,"Mauvaise syntaxe dans l'utilisation de l'opérateur : %c\n",(char)operator);
-                return -1;
-            }
-
-            er[index]->left_chilfren = last_tree;
-            er[last_tree_index] = NULL;
-            count++;
-
-            last_tree_index = index;
-            last_tree = er[index];
-        }else
-        {
-            last_tree = er[index];
-            last_tree_index = index;
-        }
-    }
-
-    return count;
-}
-
-int operator_binaire_merge(Tree** er,size_t er_size,Lettre operator)
-{
-    int count = 0;
-    Tree* last_tree = NULL;
-    size_t last_tree_index = 0;
-    for(size_t index=0;index<er_size;index++)
-    {
-        if(er[index] == NULL)
-        {
-            continue;
-        }
-        if(er[index]->etiquette == operator && is_racine(er[index]))
-        {
-            Tree* next_tree = get_next_tree(&er[index+1],er_size-index-1);
-            if(last_tree==NULL || next_tree==NULL)
-            {
-                fprintf(stderr,"Mauvaise syntaxe dans l'utilisation de l'opérateur : %c\n",(char)operator);
-                return -1;
-            }
-
-            er[index]->left_chilfren = last_tree;
-            er[index]->right_children = next_tree;
-            er[last_tree_index] = NULL;
-            count++;
-
-            last_tree_index = index;
-            last_tree = er[index];
-        }else
-        {
-            last_tree = er[index];
-            last_tree_index = index;
-        }
-    }
-
-    return count;
-}
-
-Tree* merge_forest(Tree** forest,size_t forest_size);
-
-/// @brief fusionne les arbres entre la parenthèse ouvrante à l'index 0 et sa parenthèse fermante associée
-/// @param regular_trees un tableau d'arbre dont le premier est réduit à une racine dont l'étiquette est '('
-/// @param size la taille du tableau dans lequel la parenthèse fermante doit-être cherchée
-/// @return le nombre d'arbre fusionné (et donc le nombre d'index utilisé)
-size_t parentheses_merge(Tree** regular_trees,size_t size)
-{
-    if(regular_trees[0] == NULL || regular_trees[0]->etiquette!='(')
-    {
-        fprintf(stderr,"mauvaise utilisation de parentheses_merge");
-        return 0;
-    }
-
-    // printf("parenthèse_merge de [");
-    // for(size_t i=0;i<size;i++)
-    //     if(regular_trees[i]!=NULL)
-    //         printf("%c;",regular_trees[i]->etiquette);
-    //     else
-    //         printf("NULL;");
-    // printf("]\n");
-
-    for(size_t index = 1; index<size;index++)
-    {
-        if(regular_trees[index]==NULL)
-            continue;
-
-        if(regular_trees[index]->etiquette == ')')
-        {
-            // on a trouvé la parenthèse fermante, on libère les arbres associés a '(' ')'
-            Tree_free(regular_trees[0]);
-            Tree_free(regular_trees[index]);
-
-            // reste à fusionner les arbres des index 1 à index-1 à l'aide de l'analyse des opérateur
-            Tree* t = merge_forest(&regular_trees[1],index-1);
-            
-            // on met à NULL les arbres utilisés
-            regular_trees[0]=NULL;
-            regular_trees[index]=NULL;
-                
-            // on met l'abre issu de la fusion dans la première case de notre tableau
-            regular_trees[0] = t;
-
-            // on retourne le nombre de case utilisées
-            return index;
-        }
-        else if(regular_trees[index]->etiquette == '(')
-        {
-            // on trouvé une autre parenthèse ouvrante imbiqué
-            // on utilise un appel récursif pour s'occuper de celle-ci
-            // on saute la zone de cette parenthèse pour continuer notre recherche après
-            size_t saut = parentheses_merge(&regular_trees[index],size-index-1);
-            if(saut==0)
-            {
-                // problème de parenthèsage
-                return 0;
-            }
-
-            index+= saut;
-        }else
-        {
-            // autres caractère on ne fait rien
-        }
-    }
-
-    // aucune parenthèse fermante trouvée
-    // problème
-    fprintf(stderr,"Aucune parenthèse fermante trouvée, vérifiez votre usage de parenthèse_merge ou votre parenthèsage !\n");
-    return 0;    
-}
-
-size_t str_len(Lettre* str)
-{
-    size_t size = 0;
-    while (str[size]!=0)
-    {
-        size++;
-    }
-    return size;
-}
-
-Tree** make_forest(Lettre* er,size_t* forest_size)
-{
-    size_t er_size = str_len(er);
-
-    // on fait une concaténation implicite entre deux lettres ou entre un opérateur unaire et une lettre à sa droite (ex :  a?a ou a*b)
-    // cas des parenthèses : '(' peut-être implicitement concatener à gauche et ')' peut l'être à droite
-    // si on a )( on doit faire la concaténation
-    size_t nb_concatenation_implicite = 0;
-    
-
-    for(size_t i=1;i<er_size;i++)
-    {
-        if(er[i]=='(')
-        {
-            if(er[i-1]!='(' && !is_operator_binaire(er[i-1]))
-                nb_concatenation_implicite++;
-        }else if(!is_operator(er[i]) && er[i]!=')')
-        {
-            if(er[i-1]!='(' && (is_operator_unaire(er[i-1]) || !is_operator(er[i-1])))
-                nb_concatenation_implicite++;
-        }
-    }
-
-    *forest_size = er_size+nb_concatenation_implicite;
-
-    Tree** forest = malloc(sizeof(Tree*)*(*forest_size));
-
-    
-    size_t current_nb_concatenation = 0;
-    for(size_t i=1;i<er_size;i++)
-    {
-        if(er[i]=='(')
-        {
-            if(er[i-1]!='(' && !is_operator_binaire(er[i-1]))
-            {
-                forest[i+current_nb_concatenation] = Tree_init(SYNTAXE_OPERATOR_CONCATENATION,NULL,NULL);
-                current_nb_concatenation++;
-            }
-        }else if(!is_operator(er[i]) && er[i]!=')')
-        {
-            if(er[i-1]!='(' && (is_operator_unaire(er[i-1]) || !is_operator(er[i-1])))
-            {
-                forest[i+current_nb_concatenation] = Tree_init(SYNTAXE_OPERATOR_CONCATENATION,NULL,NULL);
-                current_nb_concatenation++;
-            }
-        }
-
-        forest[i+current_nb_concatenation] = Tree_init(er[i],NULL,NULL);
-    }
-    if(er_size>0)
-    forest[0] = Tree_init(er[0],NULL,NULL);
-
-    return forest;
-}
-
-int merge_parentheses(Tree** forest,size_t forest_size)
-{
-    int count = 0;
-    for(size_t i=0;i<forest_size;i++)
-    {
-       if(forest[i]!=NULL)
-        {
-            if(forest[i]->etiquette=='(')
-            {
-                if(parentheses_merge(&forest[i],forest_size-i)==0)
-                {
-                    return -1;
-                }else
-                {
-                    count++;
-                }
-            }
-        }
-    }
-    return count;
-}
-
-Tree* merge_forest(Tree** forest,size_t forest_size)
-{
-#ifdef DEBUG
-    printf("etat initial : [");
-    for(size_t i=0;i<forest_size;i++)
-    {
-        Tree_print(forest[i]);
-        printf(";");
-    }
-    printf("]\n");
-#endif
-    // fusion par parenthèse
-    int error = merge_parentheses(forest,forest_size);
-    if(error==-1)
-        return NULL;
-
-#ifdef DEBUG
-    printf("après fusion des parenthèses : [");
-    for(size_t i=0;i<forest_size;i++)
-    {
-        Tree_print(forest[i]);
-        printf(";");
-    }
-    printf("]\n");
-#endif
-
-    // gestion des ?
-    error = operator_unaire_merge(forest,forest_size,SYNTAXE_OPERATOR_JOKER);
-    if(error==-1)
-        return NULL;
-
-#ifdef DEBUG
-    printf("après gestion des ? : [");
-    for(size_t i=0;i<forest_size;i++)
-    {
-        Tree_print(forest[i]);
-        printf(";");
-    }
-    printf("]\n");
-#endif
-
-    // gestion des *
-    error = operator_unaire_merge(forest,forest_size,SYNTAXE_OPERATOR_ETOILE);
-    if(error==-1)
-        return NULL;
-
-#ifdef DEBUG
-    printf("après gestion des * : [");
-    for(size_t i=0;i<forest_size;i++)
-    {
-        Tree_print(forest[i]);
-        printf(";");
-    }
-    printf("]\n");
-#endif   
-
-    // gestion des @
-    error = operator_binaire_merge(forest,forest_size,SYNTAXE_OPERATOR_CONCATENATION);
-    if(error==-1)
-        return NULL;
-
-#ifdef DEBUG
-    printf("après gestion des @ : [");
-    for(size_t i=0;i<forest_size;i++)
-    {
-        Tree_print(forest[i]);
-        printf(";");
-    }
-    printf("]\n");
-#endif
-
-    // gestion des |
-    error = operator_binaire_merge(forest,forest_size,SYNTAXE_OPERATOR_UNION);
-    if(error==-1)
-        return NULL;
-
-#ifdef DEBUG
-    printf("après gestion des | : [");
-    for(size_t i=0;i<forest_size;i++)
-    {
-        Tree_print(forest[i]);
-        printf(";");
-    }
-    printf("]\n");
-#endif
-
-    Tree* t = NULL;
-    for(size_t i=0;i<forest_size;i++)
-    {
-        if(forest[i]!=NULL)
-        {
-            if(t==NULL)
-            {
-                t=forest[i];
-                forest[i]=NULL;
-            }
-            else
-            {
-                fprintf(stderr,"Erreur lors de la lecture de l'expression régulière !\n");
-                return NULL;
-            }
-        }
-    }
-    
-    return t;
-}
-
-
-Tree* make_syntaxique_tree(Lettre* er)
-{    
-    size_t er_size;
-    Tree** trees = make_forest(er,&er_size);
-
-    Tree* syntaxique_tree = merge_forest(trees,er_size);
-    free(trees);
-    return syntaxique_tree;
-}
-
-
-/*
-    Création d'un automate à partir d'un arbre syntaxique
-    Algorithme de Thomson
-
-        le a? est équivalent à a|epsilon : automate équivalent ->()-epsilon,a->()->
-        le . est équivalent à SIGMA : automate équivalent ->()-a,b,....->()->
-*/
-
-#define MIN_LISTARRAY_CAPACITY 1000
-#define LISTARRAY_EXPANSION_COEF 2
-struct ListArray
-{
-    size_t capacity;
-    size_t size;
-    Sommet* data;
-};
-
-/// @brief Structure de liste implémentée par tableau redimensionnable
-/// @brief possibilité de faire for(size_t index=0;index<list->size;index++) list->data[index] ;;; pour parcourir la liste
-/// @brief ou de faire list->data[index] pour accéder à une valeur précise en temps constant tant que index<list->size
-typedef struct ListArray ListArray;
-
-/// @brief 
-/// @param  
-/// @return 
-ListArray* ListArray_init(void)
-{
-    ListArray* list = malloc(sizeof(ListArray));
-    list->size = 0;
-    list->capacity = MIN_LISTARRAY_CAPACITY;
-    list->data = malloc(sizeof(Sommet)*list->capacity);
-
-    return list;
-}
-
-/// @brief 
-/// @param list 
-void ListArray_free(ListArray* list)
-{
-    free(list->data);
-    free(list);
-}
-
-/// @brief 
-/// @param list 
-/// @param s 
-void ListArray_push(ListArray* list,Sommet s)
-{
-    if(list->size==list->capacity)
-    {
-#ifdef _DEBUG
-        fprintf(stderr,"expansion de la liste %ld -> %ld\n",list->capacity,list->capacity*LISTARRAY_EXPANSION_COEF);
-#endif
-        size_t new_capacity = list->capacity * LISTARRAY_EXPANSION_COEF;
-        Sommet* temp = malloc(sizeof(Sommet)*new_capacity);
-
-        for(size_t i=0;i<list->capacity;i++)
-            temp[i] = list->data[i];
-        
-        free(list->data);
-        list->data = temp;
-        list->capacity = new_capacity;
-
-        ListArray_push(list,s);
-    }else if(list->size < list->capacity)
-    {
-        list->data[list->size++] = s;
-    }else
-    {
-        fprintf(stderr,"Index out of range dans une ListArray !\n");
-    }
-}
-
-/// @brief 
-/// @param list 
-/// @return 
-Sommet ListArray_pop(ListArray* list)
-{
-    if(list->size==0)
-    {
-        // problème
-        fprintf(stderr,"tentative de pop sur une ListArray vide");
-        return -1;
-    }else
-    {
-        return list->data[--list->size];
-    }
-}
-
-/// @brief supprime l'élément d'index `index` et le renvoie
-/// @param list 
-/// @param index 
-/// @return 
-Sommet ListArray_remove(ListArray* list,size_t index)
-{
-    if(index==list->size-1)
-    {
-        return ListArray_pop(list);
-    }else
-    {
-        Sommet temp = list->data[index];
-        list->data[index] = list->data[list->size-1];
-        list->size = list->size-1;
-        return temp;
-    }
-    
-
-}
-
-/// @brief 
-/// @param list 
-/// @return 
-bool ListArray_empty(ListArray* list)
-{
-    return list->size==0;
-}
-
-void ListArray_print(ListArray* list)
-{
-    printf("[");
-    for(size_t i=0;i<list->size;i++)
-        printf("%ld;",list->data[i]);
-    printf("]\n");
-}
-
-/// @brief instancie une copie d'une liste
-/// @param list 
-/// @return 
-ListArray* ListArray_copy(ListArray* list)
-{
-    ListArray* copy = ListArray_init();
-    for(size_t i=0;i<list->size;i++)
-        ListArray_push(copy,list->data[i]);
-    return copy;
-}
-
-/// @brief Applique une fonction à chaque valeur d'une liste
-/// @param list 
-/// @param f 
-void ListArray_iter(ListArray* list,void (*f)(Sommet))
-{
-    for(size_t i=0;i<list->size;i++)
-        f(list->data[i]);
-}
-
-/// @brief Applique une fonction à chaque valeur d'une liste et remplace cette valeur par le retour de la fonction
-/// @param list 
-/// @param f 
-void ListArray_map(ListArray* list,Sommet (*f)(Sommet))
-{
-        for(size_t i=0;i<list->size;i++)
-            list->data[i] = f(list->data[i]);
-}
-
-/// @brief concatène deux listes en une nouvelle liste
-/// @param list1 
-/// @param list2 
-/// @return 
-ListArray* ListArray_concatenation(ListArray* list1,ListArray* list2)
-{
-    ListArray* l = ListArray_init();
-    for(size_t i=0;i<list1->size;i++)
-        ListArray_push(l,list1->data[i]);
-    for(size_t i=0;i<list2->size;i++)
-        ListArray_push(l,list2->data[i]);
-
-    return l;
-}
-
-/// @brief ajoute tous les éléments de `source` dans `dest`
-/// @param dest liste dans laquelle les éléments vont-être ajouté (modifiée)
-/// @param source liste d'ou les éléments seront récupérés (const)
-void ListArray_extend(ListArray* dest,ListArray* source)
-{
-    for(size_t i=0;i<source->size;i++)
-        ListArray_push(dest,source->data[i]);
-}
-
-#define EPSILON_TRANSITION_INDEX 0
-struct Automate
-{
-    size_t alphabet_size;
-    size_t nb_etat; // nombre d'état de l'automate
-    ListArray* initiaux; // liste des états initiaux de l'automate
-    ListArray* finaux; // liste des états finaux de l'automate
-    ListArray*** transitions; // tableau des transitions de l'automate (une liste par état) : 
-                              //j est accessible depuis i par la lettre a ssi j est dans transitions[i][a]
-                              // les lettres possibles sont 1 à 255
-                              // le 0 étant réservé pour les epsilon transitions
-};
-typedef struct Automate Automate;
-
-Automate* Automate_init(size_t nb_etat,size_t alphabet_size)
-{
-    Automate* a = malloc(sizeof(Automate));
-    a->alphabet_size = alphabet_size;
-    a->nb_etat = nb_etat;
-    a->initiaux = ListArray_init();
-    a->finaux = ListArray_init();
-    a->transitions = malloc(sizeof(ListArray**)*nb_etat);
-    for(size_t i=0;i<nb_etat;i++)
-    {
-        a->transitions[i] = malloc(sizeof(ListArray*)*alphabet_size);
-        for(size_t l=0;l<alphabet_size;l++)
-        {
-            a->transitions[i][l] = ListArray_init();
-        }
-    }
-        
-
-    return a;
-}
-
-void Automate_free(Automate* a)
-{
-    ListArray_free(a->initiaux);
-    ListArray_free(a->finaux);
-    for(size_t i=0;i<a->nb_etat;i++)
-    {
-        for(size_t l=0;l<a->alphabet_size;l++)
-            ListArray_free(a->transitions[i][l]);
-        free(a->transitions[i]);
-    }
-        
-
-    free(a->transitions);
-    free(a);
-}
-
-void Automate_print(Automate* a)
-{
-    if(a==NULL)return;
-    printf("taille de l'aphabet : %ld\n",a->alphabet_size);
-    printf("nombre d'état : %ld\n",a->nb_etat);
-    printf("Etats initiaux : "); ListArray_print(a->initiaux);
-    printf("Etats finaux : ");ListArray_print(a->finaux);
-    for (size_t i = 0; i < a->nb_etat; i++)
-    {
-        printf("Depuis le sommet %ld : [",i);
-        for(size_t lettre =0;lettre<a->alphabet_size;lettre++)
-            for(size_t j=0;j<a->transitions[i][lettre]->size;j++)
-                printf("(%c,%ld);",(char)lettre,a->transitions[i][lettre]->data[j]);
-        printf("]\n");
-    }
-    
-}
-
-Automate* Automate_copy(Automate* a)
-{
-    Automate* b = Automate_init(a->nb_etat,a->alphabet_size);
-    ListArray_extend(b->initiaux,a->initiaux);
-    ListArray_extend(b->finaux,a->finaux);
-
-    for(Sommet source=0;source<a->nb_etat;source++)
-    {
-        for(Lettre l=0;l<a->alphabet_size;l++)
-        {
-            ListArray_extend(b->transitions[source][l],a->transitions[source][l]);
-        }
-    }
-
-    return b;
-}
-
-Sommet delta_index_to_reindexationn_fun = 0;
-Sommet reindexation(Sommet s)
-{
-    return s + delta_index_to_reindexationn_fun;
-}
-
-
-void ListArray_reindexation(ListArray* list,size_t delta_index)
-{
-    delta_index_to_reindexationn_fun = delta_index;
-    ListArray_map(list,reindexation);
-    delta_index_to_reindexationn_fun = 0;
-}
-
-/// @brief réindexe les sommets d'un automate en incrémentant chacune des référence de `delta_index`
-/// @param a 
-/// @param delta_index 
-/// @warning après l'usage de cette fonction un automate n'est plus utilisable en l'état sous peine de lecture hors mémoire
-void Automate_reindexation(Automate* a,long long delta_index)
-{
-    delta_index_to_reindexationn_fun = delta_index;
-
-    ListArray_map(a->initiaux,reindexation);
-    ListArray_map(a->finaux,reindexation);
-    for(size_t i=0;i<a->nb_etat;i++)
-        for(size_t l=0;l<a->alphabet_size;l++)
-            ListArray_map(a->transitions[i][l],reindexation);
-
-    delta_index_to_reindexationn_fun = 0;
-}
-
-void Automate_add_etat_initial(Automate* a,size_t q)
-{
-    ListArray_push(a->initiaux,q);
-}
-
-void Automate_add_etat_final(Automate* a,size_t q)
-{
-    ListArray_push(a->finaux,q);
-}
-
-void Automate_add_transition(Automate* a,size_t source,size_t lettre,size_t dest)
-{
-    ListArray_push(a->transitions[source][lettre],dest);
-}
-
-
-
-/// @brief instancie un nouvel automate qui possède les états et transitions
-/// des deux automates passés en argument (avec une réindexation de +a1->nb_etat sur a2)
-/// mais ni les états finaux ni les états initiaux
-/// @param a1 
-/// @param a2 
-/// @return 
-Automate* Automate_merge(Automate* a1,Automate* a2)
-{
-    Automate* b = Automate_init(a1->nb_etat+a2->nb_etat,max(a1->alphabet_size,a2->alphabet_size));
-    size_t delta_index = a1->nb_etat;
-    // on réindexe temporairement a2
-    Automate_reindexation(a2,delta_index);
-
-    // on copie maintenant les transitions
-    for(size_t etat_source=0;etat_source<a1->nb_etat;etat_source++)
-    {
-        for(Lettre l=0;l<a1->alphabet_size;l++)
-        {
-            ListArray_extend(b->transitions[etat_source][l],a1->transitions[etat_source][l]);
-        }
-    }
-
-    for(size_t etat_source=0;etat_source<a2->nb_etat;etat_source++)
-    {
-        for(Lettre l=0;l<a2->alphabet_size;l++)
-        {
-            ListArray_extend(b->transitions[etat_source+delta_index][l],a2->transitions[etat_source][l]);
-        }
-    }
-    
-    
-    // on répare a2
-    Automate_reindexation(a2,-(long long)a1->nb_etat);
-
-    return b;
-}
-
-/// @brief Retourne un automate reconnaissant une lettre de l'alphabet
-/// @param lettre 
-/// @return 
-Automate* Automate_lettre(Lettre lettre,size_t alphabet_size)
-{
-    // ->()--lettre-->()->
-    Automate* a = Automate_init(2,alphabet_size);
-    Automate_add_etat_initial(a,0);
-    Automate_add_etat_final(a,1);
-
-    Automate_add_transition(a,0,lettre,1);
-    return a;
-}
-
-Automate* Automate_union(Automate* a1,Automate* a2)
-{
-    
-    Automate* b = Automate_merge(a1,a2);
-    size_t delta = a1->nb_etat;
-
-    // on copie les états finaux de a1 et de a2 vers b
-    ListArray_extend(b->initiaux,a1->initiaux);
-    for(size_t i=0;i<(a2->initiaux->size);i++)
-        ListArray_push(b->initiaux,a2->initiaux->data[i]+delta);
-
-    // on fait de même pour les états finaux
-    ListArray_extend(b->finaux,a1->finaux);
-    for(size_t i=0;i<(a2->initiaux->size);i++)
-        ListArray_push(b->finaux,a2->finaux->data[i]+delta);
-
-    //on retourne l'automate nouvellement créer
-    return b;
-};
-
-Automate* Automate_concatenation(Automate* a1,Automate* a2)
-{
-    Automate* b = Automate_merge(a1,a2);
-    // printf("Concaténation : \n");
-    // Automate_print(a1);
-    // Automate_print(a2);
-    // printf("Après merge : \n");
-    // Automate_print(b);
-    size_t delta = a1->nb_etat;
-
-    // on ajoute une epsilon transition des états finaux de a1 vers les états initiaux de a2
-    for(size_t i=0;i<a1->finaux->size;i++)
-    {
-        Sommet source = a1->finaux->data[i];
-        for(size_t j=0;j<a2->initiaux->size;j++)
-        {
-            Sommet dest = a2->initiaux->data[j];
-            Automate_add_transition(b,source,EPSILON_TRANSITION_INDEX,dest+delta);
-        }
-    }
-
-    // on met les états initiaux de a1 en tant qu'états initiaux 
-    ListArray_extend(b->initiaux,a1->initiaux);
-    // et les états finaux de a2 en état finaux
-    ListArray_extend(b->finaux,a2->finaux);
-    ListArray_reindexation(b->finaux,delta);
-
-    // printf("fin de la concaténation : \n");
-    // Automate_print(b);
-    return b;
-}
-
-Automate* Automate_etoile(Automate* a)
-{
-    // on ajoute un état qui sera l'unique état initial et final (on va le noter q)
-    // on relie tous les états initiaux de a depuis cet état
-    // on relie tous les états finaux de a vers cet état
-
-    // printf("automate etoile : entrée : ");
-    // Automate_print(a);
-
-    Automate* b = Automate_init(a->nb_etat+1,a->alphabet_size);
-    Sommet q = a->nb_etat;
-    ListArray_push(b->initiaux,q);
-    ListArray_push(b->finaux,q);
-
-    // on copie les transitions
-    for(Sommet source =0;source<a->nb_etat;source++)
-    {
-        for(size_t lettre = 0;lettre<a->alphabet_size;lettre++)
-        {
-            ListArray_extend(b->transitions[source][lettre],a->transitions[source][lettre]);
-        }
-    }
-
-    // on relie q vers les états initiaux de a
-    for(size_t i=0;i<a->initiaux->size;i++)
-    {
-        Automate_add_transition(b,q,EPSILON_TRANSITION_INDEX,a->initiaux->data[i]);
-    }
-
-    // on relie les états finaux de a vers q
-    for(size_t i=0;i<a->finaux->size;i++)
-    {
-        Automate_add_transition(b,a->finaux->data[i],EPSILON_TRANSITION_INDEX,q);
-    }
-    // printf("sortie : ");
-    // Automate_print(b);
-    return b;
-}
-
-
-Automate* Automate_joker(Automate* a)
-{
-    // automate reconnaissant une fois a ou rien
-    // on copie a, on ajoute un état, on met cet état comme final et initial
-
-    Automate* b = Automate_init(a->nb_etat+1,a->alphabet_size);
-    ListArray_extend(b->initiaux,a->initiaux);
-    ListArray_extend(b->finaux,a->finaux);
-    for(Sommet s=0;s<a->nb_etat;s++)
-    {
-        for(Lettre l=0;l<a->alphabet_size;l++)
-        {
-            ListArray_extend(b->transitions[s][l],a->transitions[s][l]);
-        }
-    }
-
-    ListArray_push(b->initiaux,a->nb_etat);
-    ListArray_push(b->finaux,a->nb_etat);
-    return b;
-}
-
-Automate* Automate_sigma(size_t alphabet_size)
-{
-    // automate reconnaissant tous caractère de l'alphabet et aucun
-    Automate* a = Automate_init(2,alphabet_size);
-    Automate_add_etat_initial(a,0);
-    Automate_add_etat_final(a,1);
-    for(size_t l=0;l<alphabet_size;l++)
-    {
-         Automate_add_transition(a,0,l,1);
-    }
-    return a;
-}
-
-Automate* make_thomson_automate(Tree* syntaxique_tree,size_t alphabet_size)
-{
-    if(syntaxique_tree==NULL)
-        return NULL;
-
-    Automate* a = NULL;
-    Automate* b = NULL;
-    Automate* c = NULL;
-    //printf("lecture de l'abre syntaxique : "); 
-    //Tree_print(syntaxique_tree);
-    //printf("\n");
-    switch (syntaxique_tree->etiquette)
-    {
-        
-        case SYNTAXE_OPERATOR_CONCATENATION:
-            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size);
-            b = make_thomson_automate(syntaxique_tree->right_children,alphabet_size);
-
-            if(a==NULL)
-            {
-                if(b!=NULL)
-                    Automate_free(b);
-                return NULL;
-            }else if(b==NULL)
-            {
-                if(a!=NULL)
-                    Automate_free(a);
-                return NULL;
-            }
-
-            c = Automate_concatenation(a,b);
-            Automate_free(a);
-            Automate_free(b);
-
-            return c;
-            break;
-        case SYNTAXE_OPERATOR_UNION:
-            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size);
-            b = make_thomson_automate(syntaxique_tree->right_children,alphabet_size);
-
-            if(a!=NULL && b!=NULL)
-            {
-                c = Automate_union(a,b);
-                Automate_free(a);
-                Automate_free(b);
-                return c;
-            }else if(a==NULL)
-            {
-                return b;
-            }
-            if(b==NULL)
-            {
-                return a;
-            }
-
-            break;
-        case SYNTAXE_OPERATOR_ETOILE:
-            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size);
-            if(a==NULL) return NULL;
-
-            b = Automate_etoile(a);
-            Automate_free(a);
-            return b;    
-            break;
-        case SYNTAXE_OPERATOR_JOKER:
-            a = make_thomson_automate(syntaxique_tree->left_chilfren,alphabet_size);
-            b = Automate_joker(a);
-            Automate_free(a);
-            return b;
-            break;
-        case SYNTAXE_OPERATOR_SIGMA:
-            return Automate_sigma(alphabet_size);
-            break;
-
-        default:
-            // lettre "normal"
-            return Automate_lettre(syntaxique_tree->etiquette,alphabet_size);
-            break;
-    }
-
-    return NULL;
-}
-
-
-/// @brief Implémentation des ensembles finies
-/// Interface : initialisation O(n); libération; ajout O(1);
-/// test d'appartenance O(1); fusion O(n)
-struct Ensemble
-{
-    bool* data;
-    size_t size;
-};
-typedef struct Ensemble Ensemble;
-
-
-ListArray* ensemble_pool = NULL;
-void Ensemble_init_pool(void)
-{
-    if(ensemble_pool==NULL)
-    {
-        ensemble_pool = ListArray_init();
-    }
-}
-
-void Ensemble_free_pool(void)
-{
-    if(ensemble_pool!=NULL)
-    {
-        for(size_t i=0;i<ensemble_pool->size;i++)
-        {
-            Ensemble* e = (Ensemble*)ensemble_pool->data[i];
-            free(e->data);
-            free(e);
-        }
-        ListArray_free(ensemble_pool);
-    }
-}
-
-/// @brief Instancie un ensemble dont le nombre d'élément ne dépassera pas `n`
-/// l'ensemble est initialement vide
-/// @param n 
-/// @return un pointeur vers un ensemble
-Ensemble* Ensemble_init(size_t n)
-{   
-    if(ensemble_pool==NULL)
-    {
-       Ensemble_init_pool();
-    }
-
-    {
-        Ensemble* e = NULL;
-        for(size_t i=0;i<ensemble_pool->size;i++)
-        {
-            Ensemble* current = (Ensemble*)ensemble_pool->data[i];// on utilise l'abut sizeof(Ensemble*)=sizeof(size_t)=sizeof(Sommet) (c'est à dire 64 bits)
-            if(current->size==n)
-            {
-                e = (Ensemble*)ListArray_remove(ensemble_pool,i);
-                break;
-            }
-        }
-        if(e==NULL) // pas d'ensemble à la bonne taille
-        {
-            e = malloc(sizeof(Ensemble));
-            e->size = n;
-            e->data = malloc(sizeof(bool)*n);
-        }
-        
-        for(size_t i=0;i<n;i++)
-            e->data[i]=false;
-        return e;
-        
-    }
-
-
-}
-
-void Ensemble_free(Ensemble* e)
-{
-    if(ensemble_pool==NULL)
-    {
-        Ensemble_init_pool();
-    }
-
-    ListArray_push(ensemble_pool,(Sommet)e);
-}
-
-void Ensemble_print(Ensemble* e)
-{
-    printf("{");
-    for(size_t i=0;i<e->size;i++)
-        if(e->data[i])
-            printf("%ld;",i);
-    printf("}\n");
-}
-
-/// @brief Ajoute un élément à un ensemble
-/// @param e 
-/// @param s 
-void Ensemble_add(Ensemble* e,Sommet s)
-{
-    e->data[s] = true;
-}
-
-/// @brief teste si un élément est dans un ensemble
-/// @param e 
-/// @param s 
-/// @return true si `s` est dans `e`
-bool Ensemble_mem(Ensemble* e,Sommet s)
-{
-    return e->data[s];
-}
-
-/// @brief Instancie une copie d'un ensemble
-/// @param e 
-/// @return 
-Ensemble* Ensemble_copy(Ensemble* e)
-{
-    Ensemble* new_e = Ensemble_init(e->size);
-    memcpy(new_e->data,e->data,e->size*sizeof(bool));
-    return new_e;
-}
-
-/// @brief Instancie un nouvel enemble contenant tous les éléments de a et de b
-/// @param a 
-/// @param b 
-/// @return 
-Ensemble* Ensemble_merge(Ensemble* a,Ensemble* b)
-{
-    Ensemble* c = Ensemble_init(a->size);
-    for(size_t i=0;i<c->size;i++)
-    {
-        c->data[i] = (Ensemble_mem(a,i))||(Ensemble_mem(b,i));
-    }
-    return c;
-}
-
-/// @brief retourne si un ensemble est vide
-/// @param e
-/// @return true si l'ensemble est vide, false sinon
-bool Ensemble_vide(Ensemble* e)
-{
-    for(size_t i=0;i<e->size;i++)
-        if(e->data[i])
-            return false;
-    return true;
-}
-
-/// @brief insère tous les éléments d'une liste dans un ensemble
-/// @param e 
-/// @param list 
-void Ensemble_eat_list(Ensemble* e,ListArray* list)
-{
-    for(size_t i=0;i<list->size;i++)
-        Ensemble_add(e,list->data[i]);
-}
-
-void _rec_cloture_etat_depth_search(Automate* a,Sommet q,Ensemble* vus)
-{
-    if(Ensemble_mem(vus,q))
-    {
-        return;
-    }else
-    {
-        Ensemble_add(vus,q);
-        for(size_t i=0;i<a->transitions[q][EPSILON_TRANSITION_INDEX]->size;i++)
-            _rec_cloture_etat_depth_search(a,a->transitions[q][EPSILON_TRANSITION_INDEX]->data[i],vus);
-    }
-}
-
-/// @brief retoune la cloture instantanée d'un état dans un automate à epsilon transition
-/// @param a 
-/// @param q 
-/// @return 
-Ensemble* Automate_cloture_instantanee_etat(Automate* a,Sommet q)
-{
-    Ensemble* cloture = Ensemble_init(a->nb_etat);
-    _rec_cloture_etat_depth_search(a,q,cloture);
-    return cloture;
-}
-
-/// @brief Calcule l'union des clotures instantannées des états de `e`
-/// @param a 
-/// @param e 
-/// @return 
-Ensemble* Automate_cloture_instantanee(Automate* a,Ensemble* e)
-{
-    Ensemble* Q = Ensemble_copy(e);
-    for(size_t i=0;i<a->nb_etat;i++)
-    {
-        if(Ensemble_mem(e,i))
-        {
-            for(size_t j=0;j<a->transitions[i][EPSILON_TRANSITION_INDEX]->size;j++)
-            {
-                _rec_cloture_etat_depth_search(a,a->transitions[i][EPSILON_TRANSITION_INDEX]->data[j],Q);
-            }
-        }
-    }
-
-    return Q;
-}
-
-/// @brief même chose que `Automate_cloture_instantanee` mais avec liberation/consommation de `e`
-/// @param a 
-/// @param e 
-/// @return 
-Ensemble* Automate_cloture_instantanee_inplace(Automate* a,Ensemble* e)
-{
-    Ensemble* temp = Automate_cloture_instantanee(a,e);
-    Ensemble_free(e);
-    return temp;
-}
-
-
-/// @brief retourne l'ensemble des états accessibles dans l'automate `a`
-/// depuis les états de `e` en lisant la lettre l
-/// @warning les epsilon transition ne sont pas considérées
-/// @param a 
-/// @param e 
-/// @param l 
-/// @return 
-Ensemble* Automate_read_letter(Automate* a,Ensemble* e,size_t l)
-{
-    if(l>a->alphabet_size)
-    {
-        fprintf(stderr,"Impossible de lire la lettre %c(%ld) avec un automate d'alphabet de taille %ld\n",(char)l,l,a->alphabet_size);
-        return Ensemble_init(a->nb_etat);
-    }
-
-    Ensemble* dest = Ensemble_init(a->nb_etat);
-    
-    for (size_t i = 0; i < a->nb_etat; i++)
-    {
-        if(Ensemble_mem(e,i))
-        {
-            Ensemble_eat_list(dest,a->transitions[i][l]);
-        }
-    }
-    
-    return dest;
-}
-
-/// @brief détermine si il y a un état final dans un ensemble
-/// @param a 
-/// @param e 
-/// @return 
-bool Automate_is_final_ensemble(Automate* a,Ensemble* e)
-{
-    for(size_t i=0;i<a->finaux->size;i++)
-    {
-        if(Ensemble_mem(e,a->finaux->data[i]))
-            return true;
-    }
-    return false;
-}
-
-/// @brief détermine si un mot est reconnu par un automate
-/// @param a 
-/// @param e 
-/// @param word 
-/// @return 
-bool Automate_read_word(Automate* a,Lettre* word)
-{
-    // on initialise un ensemble avec les états initiaux et les états dans la cloture instantanée des états initiaux
-    Ensemble* initiaux = Ensemble_init(a->nb_etat);
-    Ensemble_eat_list(initiaux,a->initiaux);
-    Ensemble* temp = Automate_cloture_instantanee(a,initiaux);
-    Ensemble_free(initiaux);
-    initiaux = temp;
-
-    //printf("début de la lecture du mot %s, états de départ : ",word);
-    //Ensemble_print(initiaux);
-
-    // on lit ensuite chaque lettre de manière itérative
-    // sans oublie de calculer la cloture instantanée à chaque fois
-    for(size_t index=0;word[index]!=0;index++)
-    {
-        temp = Automate_read_letter(a,initiaux,word[index]);
-        //printf("Après lecture de la lettre '%c'\n",word[index]);
-        //Ensemble_print(temp);
-
-        Ensemble_free(initiaux);
-        initiaux = Automate_cloture_instantanee(a,temp);
-        Ensemble_free(temp);
-        //printf("Après cloture instantanée\n");
-        //Ensemble_print(initiaux);
-    }
-
-    // on regarde si il y a un état final dans les états obtenus
-    bool is_final = Automate_is_final_ensemble(a,initiaux);
-    Ensemble_free(initiaux);
-
-    return is_final;
-}
+#define TRACE_LIGNES (1024*1024) // octets de lignes de chaque intervalle de la trace, en lecture ligne par ligne
 
-/// @brief retourne un automate, inverse le sens de ses transitions et inverse initiaux et finaux
-/// @param a 
-/// @return un nouvel automate
-Automate* Automate_reverse(Automate* a)
+/// @brief tableau redimensionnable des motifs trouvés dans une ligne
+/// le i-ème motif est [spans[2*i];spans[2*i+1][
+struct Spans
 {
-    Automate* b = Automate_init(a->nb_etat,a->alphabet_size);
-    
-    // on inverse initiaux et finaux
-    ListArray_extend(b->initiaux,a->finaux);
-    ListArray_extend(b->finaux,a->initiaux);
+    size_t* spans;
+    size_t size; // nombre de motifs
+    size_t capacity;
+};
+typedef struct Spans Spans;
 
-    // on inverse les transitions
-    for(Sommet source=0;source<a->nb_etat;source++)
+void Spans_push(Spans* s,size_t start,size_t end)
+{
+    if(s->size==s->capacity)
     {
-        for(Lettre l=0;l<a->alphabet_size;l++)
-        {
-            for(size_t i=0;i<a->transitions[source][l]->size;i++)
-            {
-                Sommet dest = a->transitions[source][l]->data[i];
-                Automate_add_transition(b,dest,l,source);
-            }
-        }
+        s->capacity = (s->capacity==0)?64:s->capacity*2;
+        s->spans = realloc(s->spans,sizeof(size_t)*2*s->capacity);
     }
-
-    return b;
+    s->spans[2*s->size] = start;
+    s->spans[2*s->size+1] = end;
+    s->size++;
 }
 
+/// @brief file circulaire des dernières lignes lues et pas encore affichées (contexte avant un motif, -B)
+/// seules les positions des lignes dans le flux sont conservées, les lignes restent dans le tampon de l'entrée
+struct Contexte
+{
+    size_t* debuts;
+    size_t* tailles;
+    size_t capacity; // nombre de lignes de contexte demandées
+    size_t tete; // index de la plus ancienne ligne
+    size_t size;
+};
+typedef struct Contexte Contexte;
 
-Automate* Automate_line(Automate* a)
+void Contexte_init(Contexte* c,size_t capacity)
 {
-    // on construit l'automate reconnaissant ".*e" avec e l'expression régulière dont le langage est dénoté par a
-    // c'est à dire "(.)*e" 
-    Automate* b = Automate_sigma(a->alphabet_size);
-    Automate* c = Automate_etoile(b);
-    Automate* temp = Automate_concatenation(c,a);
-    Automate_free(b);
-    Automate_free(c);
-    return temp;
+    c->capacity = capacity;
+    c->debuts = malloc(sizeof(size_t)*(capacity+1));
+    c->tailles = malloc(sizeof(size_t)*(capacity+1));
+    c->tete = 0;
+    c->size = 0;
 }
 
-/// @brief lit une chaîne de caractère et détecte les motifs reconnu par l'automate `a`
-/// et renvoie une liste des index de fin de ces motifs dans la chaîne `line`
-/// @note on privilégiera toujours les motifs les plus petits : 
-/// exemple avec le texte "abab" et l'automate reconnaissant "a(a|b)*b", "abab" est vu comme deux motifs
-/// @warning find("ab*a","aabbbaba") -> aa et aba donc [1;7]
-/// @param a 
-/// @param line 
-/// @return 
-ListArray* find_motif_end_indexs(Automate* line_automate,Lettre* line)
+void Contexte_free(Contexte* c)
 {
-    Ensemble* Q = Ensemble_init(line_automate->nb_etat);
-    Ensemble_eat_list(Q,line_automate->initiaux);
-    Q = Automate_cloture_instantanee_inplace(line_automate,Q);
-    Ensemble* Q_init = Ensemble_copy(Q);
-
-    ListArray* indexs = ListArray_init();
-    size_t current_index = 0;
-
-    //printf("avant lecture : \n");
-    //Ensemble_print(Q);
-
-    while (line[current_index]!='\0')// tant que toutes la chaîne n'a pas été lue
-    {
-        Lettre l = line[current_index];
-        Ensemble* next_Q = Automate_cloture_instantanee_inplace(line_automate,Automate_read_letter(line_automate,Q,l));
-        bool next_Q_final = Automate_is_final_ensemble(line_automate,next_Q);
-
-        //printf("lecture de la lettre %c, etat_final=%d, Q = ",(char)l,next_Q_final);Ensemble_print(next_Q);
-
-
-        if(next_Q_final)
-        {
-            // current_index est donc le dernier carectère d'un motif reconnu
-            ListArray_push(indexs,current_index);
-            Ensemble_free(next_Q);
-            next_Q = Ensemble_copy(Q_init);
-        }
-
-
-        current_index++;
-        Ensemble_free(Q);
-        Q = next_Q;
-    }
-
-    Ensemble_free(Q);
-    Ensemble_free(Q_init);
-    //printf("retour des index de fins : ");ListArray_print(indexs);printf("\n");
-    return indexs;
+    free(c->debuts);
+    free(c->tailles);
 }
 
-/// @brief Retrouve les index de début des motifs reconnu par `a` dans `line`
-/// à partir des index de fin de ces même motifs, (obtenu précedemment avec `find_motif_end_indexs`)
-ListArray* find_motif_start_indexs(Automate* reverse_automate,Lettre* line,ListArray* end_indexs)
+/// @brief ajoute une ligne au contexte, en oubliant la plus ancienne si il est plein
+/// @param c 
+/// @param line 
+void Contexte_push(Contexte* c,Ligne* line)
 {
-    ListArray* indexs = ListArray_init();
-
-    for(size_t i=0;i<end_indexs->size;i++)
-    {
-        size_t end = end_indexs->data[i];
-        Ensemble* Q = Ensemble_init(reverse_automate->nb_etat);
-        Ensemble_eat_list(Q,reverse_automate->initiaux);
-        Q = Automate_cloture_instantanee_inplace(reverse_automate,Q);
-
-        size_t current_index = end;
-        while (!Automate_is_final_ensemble(reverse_automate,Q))
-        {
-            Lettre l = line[current_index];
-            Ensemble* next_Q = Automate_cloture_instantanee_inplace(reverse_automate,Automate_read_letter(reverse_automate,Q,l));
-            Ensemble_free(Q);
-            Q = next_Q;
-            current_index--;
-        }
-        ListArray_push(indexs,current_index+((current_index==end)?0:1)); 
-        Ensemble_free(Q);
-    }
-    return indexs;
+    if(c->capacity==0)
+        return;
+    size_t i = (c->tete+c->size)%c->capacity;
+    if(c->size==c->capacity)
+        c->tete = (c->tete+1)%c->capacity;
+    else
+        c->size++;
+    c->debuts[i] = line->debut;
+    c->tailles[i] = line->size;
 }
 
-/// @brief lit une ligne d'un flux
-/// @param flux 
+/// @brief position dans le flux de la plus ancienne ligne du contexte, SIZE_MAX si il est vide
+/// @param c 
 /// @return 
-Lettre* get_line(FILE* flux)
+size_t Contexte_garder(Contexte* c)
 {
-    ListArray* list = ListArray_init();
-    int l = getc(flux);
-    if(l<=0)goto EOF_HAPPEND;
-    if(l=='\n' && flux==stdin)goto EOF_HAPPEND;
-
-    while (l!='\n' && l>0)
-    {
-        ListArray_push(list,l);
-        l = getc(flux);
-    }
-    ListArray_push(list,0);
-
-    //printf("lecture de %ld octets : ",list->size);ListArray_print(list);printf("\n");
-    Lettre* line = malloc(sizeof(Lettre)*list->size);
-    for(size_t i=0;i<list->size;i++)
-        line[i] = list->data[i];
-    
-    ListArray_free(list);
-    return line;
-
-    EOF_HAPPEND:
-    ListArray_free(list);
-    return NULL;
+    return (c->size==0)?SIZE_MAX:c->debuts[c->tete];
 }
 
+/// @brief traitement des fichiers contenant des octets binaires (voir `octets_binaires`)
+enum BINAIRE
+{
+    BINAIRE_SIGNALER,   // on indique seulement que le fichier contient un motif
+    BINAIRE_IGNORER,    // le fichier est abandonné sans rien afficher
+    BINAIRE_TEXTE       // le fichier est lu comme du texte
+};
+
 enum COLOR
 {
     WHITE,
     RED
 };
 
-void set_stdout_color(enum COLOR color)
+void set_stdout_color(Sortie* sortie,enum COLOR color)
 {
 #ifdef __linux
     switch (color)
     {
     case WHITE:
-        printf("\e[0;37m");
+        Sortie_chaine(sortie,"\e[0;37m");
         break;
     case RED:
-        printf("\e[0;31m");
+        Sortie_chaine(sortie,"\e[0;31m");
         break;
     default:
         break;
@@ -1533,6 +142,7 @@ void set_stdout_color(enum COLOR color)
     int k;
 
     hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+    Sortie_flush(sortie); // la couleur s'applique à ce qui est écrit ensuite
 
 
     switch (color)
@@ -1557,229 +167,874 @@ void set_stdout_color(enum COLOR color)
 
 }
 
-void afficher_motifs(Lettre* line,ListArray* starts,ListArray* ends)
+/// @brief options de la ligne de commande qui concernent l'affichage des lignes
+struct Options
+{
+    bool verbose;
+    bool show_line;
+    bool line_match;
+    size_t avant; // nombre de lignes de contexte avant et après chaque ligne contenant un motif
+    size_t apres;
+    enum BINAIRE binaire;
+    bool plusieurs_fichiers; // le nom du fichier précède chaque ligne affichée
+    bool json; // un objet JSON par ligne contenant un motif
+    bool seulement_motifs; // -o : chaque motif sur sa propre ligne, sans le reste de la ligne
+    bool positions; // -b : position dans le fichier de la ligne (ou du motif avec -o)
+    Sortie* sortie;
+};
+typedef struct Options Options;
+
+/// @brief affiche le nom du fichier, le numéro de la ligne et sa position si nécessaire
+/// @param options 
+/// @param nom 
+/// @param numero 
+/// @param position position dans le fichier de la ligne ou du motif
+/// @param separateur ':' pour une ligne contenant un motif, '-' pour une ligne de contexte
+void afficher_prefixe(Options* options,const char* nom,size_t numero,size_t position,char separateur)
+{
+    char fin[3] = {' ',separateur,' '};
+    if(options->plusieurs_fichiers)
+    {
+        Sortie_chaine(options->sortie,nom);
+        Sortie_ecrire(options->sortie,fin,3);
+    }
+    if(options->show_line)
+    {
+        Sortie_nombre(options->sortie,numero);
+        Sortie_ecrire(options->sortie,fin,3);
+    }
+    if(options->positions)
+    {
+        Sortie_nombre(options->sortie,position);
+        Sortie_ecrire(options->sortie,fin,3);
+    }
+}
+
+/// @brief affiche une ligne de contexte (sans motif)
+/// @param options 
+/// @param nom 
+/// @param data 
+/// @param size 
+/// @param numero 
+/// @param position position de la ligne dans le fichier
+void afficher_contexte(Options* options,const char* nom,const char* data,size_t size,size_t numero,size_t position)
+{
+    afficher_prefixe(options,nom,numero,position,'-');
+    Sortie_ecrire(options->sortie,data,size);
+    Sortie_caractere(options->sortie,'\n');
+}
+
+void afficher_motifs(Sortie* sortie,Ligne* line,Spans* spans)
 {
     size_t current_index = 0;
-    for(size_t i =0;i<starts->size;i++)
+    for(size_t i =0;i<spans->size;i++)
     {
-        size_t start = starts->data[i];
-        size_t end = ends->data[i];
+        size_t start = spans->spans[2*i];
+        size_t end = spans->spans[2*i+1];
     
-        while (current_index<start)
-        {
-            putc(line[current_index++],stdout);
-        }
+        Sortie_ecrire(sortie,line->data+current_index,start-current_index);
         
-        set_stdout_color(RED);
-        while (current_index<=end)
+        set_stdout_color(sortie,RED);
+        Sortie_ecrire(sortie,line->data+start,end-start);
+        set_stdout_color(sortie,WHITE);
+        current_index = end;
+    }
+
+    Sortie_ecrire(sortie,line->data+current_index,line->size-current_index);
+    Sortie_caractere(sortie,'\n');
+}
+
+/// @brief affiche chaque motif d'une ligne sur sa propre ligne (-o)
+/// @param options 
+/// @param nom 
+/// @param line 
+/// @param numero 
+/// @param spans 
+void afficher_seulement_motifs(Options* options,const char* nom,Ligne* line,size_t numero,Spans* spans)
+{
+    for(size_t i=0;i<spans->size;i++)
+    {
+        size_t start = spans->spans[2*i];
+        size_t end = spans->spans[2*i+1];
+        afficher_prefixe(options,nom,numero,line->debut+start,':');
+        Sortie_ecrire(options->sortie,line->data+start,end-start);
+        Sortie_caractere(options->sortie,'\n');
+    }
+}
+
+/// @brief affiche une ligne contenant des motifs sous la forme d'un objet JSON sur une seule ligne :
+/// {"file":nom,"line":numéro,"offset":position de la ligne,"text":ligne,"spans":[[début,fin[,...]]}
+/// @param options 
+/// @param nom 
+/// @param line 
+/// @param numero 
+/// @param spans motifs de la ligne, les positions sont relatives au début de la ligne
+void afficher_json(Options* options,const char* nom,Ligne* line,size_t numero,Spans* spans)
+{
+    Sortie* sortie = options->sortie;
+    Sortie_chaine(sortie,"{\"file\":");
+    Sortie_json(sortie,nom,strlen(nom));
+    Sortie_chaine(sortie,",\"line\":");
+    Sortie_nombre(sortie,numero);
+    Sortie_chaine(sortie,",\"offset\":");
+    Sortie_nombre(sortie,line->debut);
+    Sortie_chaine(sortie,",\"text\":");
+    Sortie_json(sortie,line->data,line->size);
+    Sortie_chaine(sortie,",\"spans\":[");
+    for(size_t i=0;i<spans->size;i++)
+    {
+        Sortie_chaine(sortie,(i==0)?"[":",[");
+        Sortie_nombre(sortie,spans->spans[2*i]);
+        Sortie_caractere(sortie,',');
+        Sortie_nombre(sortie,spans->spans[2*i+1]);
+        Sortie_caractere(sortie,']');
+    }
+    Sortie_chaine(sortie,"]}\n");
+}
+
+/// @brief cherche les motifs d'une ligne
+/// @param motif
+/// @param scratch
+/// @param options
+/// @param line
+/// @param spans motifs non vides trouvés (toute la ligne avec --line-match)
+/// @return true si la ligne contient un motif, même vide
+bool motifs_ligne(Motif* motif,Scratch* scratch,Options* options,Ligne* line,Spans* spans)
+{
+    spans->size = 0;
+    if (!options->line_match)
+    {
+        bool trouve = false;
+        size_t from = 0;
+        size_t start,end;
+        while(Motif_find_next(motif,scratch,line->data,line->size,from,&start,&end))
         {
-            putc(line[current_index++],stdout);
+            trouve = true;
+            // comme grep, un motif vide n'est pas affiché (-o, --json, couleurs) : la recherche reprend à la lettre suivante
+            if(end==start)
+            {
+                from = end+1;
+                continue;
+            }
+            Spans_push(spans,start,end);
+            from = end;
         }
-        set_stdout_color(WHITE);
+        return trouve;
+    }
+    // la ligne entière est le motif
+    if(!Motif_match(motif,scratch,line->data,line->size))
+        return false;
+    Spans_push(spans,0,line->size);
+    return true;
+}
+
+/// @brief indique qu'un fichier binaire contient un motif (ses lignes ne sont pas affichées)
+/// @param options
+/// @param nom
+void afficher_binaire(Options* options,const char* nom)
+{
+    if(options->json)
+    {
+        Sortie_chaine(options->sortie,"{\"file\":");
+        Sortie_json(options->sortie,nom,strlen(nom));
+        Sortie_chaine(options->sortie,",\"binary\":true}\n");
+    }else
+    {
+        Sortie_chaine(options->sortie,"Fichier binaire ");
+        Sortie_chaine(options->sortie,nom);
+        Sortie_chaine(options->sortie," : motif trouvé\n");
     }
+}
 
-    while (line[current_index]!='\0')
+/// @brief affiche une ligne qui contient des motifs, sans son contexte
+/// @param options
+/// @param nom
+/// @param line
+/// @param numero
+/// @param spans
+/// @param motifs_count augmenté du nombre de motifs de la ligne
+void afficher_ligne(Options* options,const char* nom,Ligne* line,size_t numero,Spans* spans,size_t* motifs_count)
+{
+    if(options->json)
+    {
+        afficher_json(options,nom,line,numero,spans);
+        *motifs_count += spans->size;
+    }else if(options->seulement_motifs)
     {
-        putc(line[current_index++],stdout);
+        afficher_seulement_motifs(options,nom,line,numero,spans);
+        *motifs_count += spans->size;
+    }else
+    {
+        afficher_prefixe(options,nom,numero,line->debut,':');
+        if (!options->line_match)
+        {
+            if(options->verbose)
+            {
+                Sortie_caractere(options->sortie,' ');
+                Sortie_nombre(options->sortie,spans->size);
+                Sortie_chaine(options->sortie," motifs : ");
+            }
+            afficher_motifs(options->sortie,line,spans);
+            *motifs_count+= spans->size;
+        }else
+        {
+            Sortie_ecrire(options->sortie,line->data,line->size);
+            Sortie_caractere(options->sortie,'\n');
+            (*motifs_count)++;
+        }
     }
-    putc('\n',stdout);
 }
 
-Lettre* char_to_Lettre(char* sentence,size_t alphabet_size)
+/// @brief cherche le motif dans chaque ligne d'une entrée et affiche les lignes trouvées
+/// @param motif 
+/// @param scratch 
+/// @param options 
+/// @param entree 
+/// @param nom nom du fichier lu
+/// @param motifs_count nombre de motifs trouvés, tous fichiers confondus (augmenté)
+/// @return nombre de lignes lues
+size_t chercher(Motif* motif,Scratch* scratch,Options* options,Entree* entree,const char* nom,size_t* motifs_count)
 {
-    size_t size = strlen(sentence);
-    Lettre* line = malloc(sizeof(Lettre)*(size+1));
-    for(size_t i=0;i<size+1;i++)
-        line[i] = sentence[i];
-    return line;
+    Ligne line;
+    Spans spans = {NULL,0,0};
+    Contexte contexte;
+    Contexte_init(&contexte,options->avant);
+
+    size_t line_count = 0;
+    bool avec_contexte = (options->avant>0 || options->apres>0);
+    size_t reste_apres = 0; // lignes de contexte restant à afficher après le dernier motif
+    size_t prochaine = SIZE_MAX; // numéro de la ligne qui suit la dernière ligne affichée de ce fichier
+    uint64_t trace = Trace_maintenant();
+    size_t trace_position = 0; // début des lignes de l'intervalle en cours
+    while (Entree_ligne(entree,Contexte_garder(&contexte),&line))
+    {
+        if(options->verbose && entree->flux!=stdin)
+        {
+            Sortie_chaine(options->sortie,"line ");
+            Sortie_nombre(options->sortie,line_count);
+            Sortie_caractere(options->sortie,'\r');
+        }
+
+        // un bloc binaire a été lu : plus aucune ligne n'est affichée
+        if(entree->binaire && options->binaire==BINAIRE_IGNORER)
+            break;
+
+        bool found = motifs_ligne(motif,scratch,options,&line,&spans);
+
+        if(entree->binaire)
+        {
+            // on cherche seulement si le fichier contient un motif
+            if(found)
+            {
+                afficher_binaire(options,nom);
+                (*motifs_count)++;
+                break;
+            }
+        }else if(found)
+        {
+            if(avec_contexte && !options->json && !options->seulement_motifs)
+            {
+                // les groupes de lignes qui ne se suivent pas sont séparés par "--"
+                size_t premiere = line_count-contexte.size;
+                if(*motifs_count>0 && premiere!=prochaine)
+                    Sortie_chaine(options->sortie,"--\n");
+                for(size_t i=0;i<contexte.size;i++)
+                {
+                    size_t k = (contexte.tete+i)%contexte.capacity;
+                    afficher_contexte(options,nom,Entree_acces(entree,contexte.debuts[k]),contexte.tailles[k],premiere+i,contexte.debuts[k]);
+                }
+                contexte.size = 0;
+                reste_apres = options->apres;
+                prochaine = line_count+1;
+            }
+            afficher_ligne(options,nom,&line,line_count,&spans,motifs_count);
+        }else if(reste_apres>0)
+        {
+            afficher_contexte(options,nom,line.data,line.size,line_count,line.debut);
+            reste_apres--;
+            prochaine = line_count+1;
+        }else if(options->avant>0)
+        {
+            Contexte_push(&contexte,&line);
+        }
+
+        line_count++;
+        // sur l'entrée standard on affiche le résultat de chaque ligne dès qu'elle est lue
+        if(entree->interactif)
+            Sortie_flush(options->sortie);
+
+        if(trace!=0 && line.debut+line.size-trace_position>=TRACE_LIGNES)
+        {
+            Trace_intervalle("recherche",trace,line.debut+line.size-trace_position);
+            trace = Trace_maintenant();
+            trace_position = line.debut+line.size;
+        }
+    }
+    Trace_intervalle("recherche",trace,entree->decalage+entree->size-trace_position);
+
+    Contexte_free(&contexte);
+    free(spans.spans);
+    return line_count;
+}
+
+/// @brief `chercher` sans lignes de contexte : l'entrée est lue par blocs de lignes, seules les lignes où un motif
+/// peut se trouver (voir `Motif_candidat`) sont délimitées, et leur numéro est le nombre de '\n' qui les précèdent
+/// @param motif
+/// @param scratch
+/// @param options
+/// @param entree entrée qui n'est pas interactive
+/// @param nom
+/// @param motifs_count
+/// @return nombre de lignes lues, seulement si elles sont numérotées (--lines, --json), 0 sinon
+size_t chercher_blocs(Motif* motif,Scratch* scratch,Options* options,Entree* entree,const char* nom,size_t* motifs_count)
+{
+    Ligne bloc;
+    Spans spans = {NULL,0,0};
+    bool numeroter = options->show_line || options->json;
+    size_t line_count = 0; // numéro de la ligne qui commence à l'index `compte` du bloc
+    bool fini = false;
+    while(!fini && Entree_bloc(entree,&bloc))
+    {
+        // un bloc binaire a été lu : plus aucune ligne n'est affichée
+        if(entree->binaire && options->binaire==BINAIRE_IGNORER)
+            break;
+
+        uint64_t trace = Trace_maintenant();
+        size_t compte = 0;
+        size_t debut = 0; // début de la prochaine ligne à examiner
+        size_t position;
+        while(debut<=bloc.size && Motif_candidat(motif,scratch,bloc.data+debut,bloc.size-debut,&position))
+        {
+            // seule la ligne du candidat est délimitée
+            size_t start = debut+position;
+            while(start>debut && bloc.data[start-1]!='\n')
+                start--;
+            const char* fin = memchr(bloc.data+debut+position,'\n',bloc.size-debut-position);
+            size_t end = (fin!=NULL)?(size_t)(fin-bloc.data):bloc.size;
+            Ligne line = {bloc.data+start,end-start,bloc.debut+start};
+            if(numeroter)
+            {
+                line_count += compter_lignes(bloc.data+compte,start-compte);
+                compte = start;
+            }
+
+            if(motifs_ligne(motif,scratch,options,&line,&spans))
+            {
+                if(entree->binaire)
+                {
+                    // on cherche seulement si le fichier contient un motif
+                    afficher_binaire(options,nom);
+                    (*motifs_count)++;
+                    fini = true;
+                    break;
+                }
+                afficher_ligne(options,nom,&line,line_count,&spans,motifs_count);
+            }
+            debut = end+1;
+        }
+        if(numeroter)
+            line_count += compter_lignes(bloc.data+compte,bloc.size-compte)+1;
+        Trace_intervalle("recherche",trace,bloc.size);
+    }
+
+    free(spans.spans);
+    return line_count;
 }
 
-char* Lettre_to_char(Lettre* line)
+/// @brief détermine si un fichier peut être lu par le lecteur (fichier régulier, dont la taille est connue)
+/// @param nom 
+/// @return 
+bool fichier_regulier(const char* nom)
 {
-    size_t size = str_len(line);
-    char* new_line = malloc(sizeof(char)*(size+1));
-        for(size_t i=0;i<size+1;i++)
-            new_line[i] = line[i];
-    return new_line;
+#ifdef LECTURE_DISPONIBLE
+    struct stat infos;
+    return stat(nom,&infos)==0 && S_ISREG(infos.st_mode);
+#else
+    return false;
+#endif
 }
 
-int main(int argc,char** argv)
+/// @brief paramètres de la ligne de commande, ou d'une requête reçue par le serveur (--serve)
+struct Arguments
+{
+    char* regular_expression;
+    char** fichiers;
+    size_t nb_fichiers;
+    size_t alphabet_size;
+    bool gzip;
+    bool expliquer;
+    bool suivre;
+    size_t erreurs;
+    size_t profondeur;      // lectures anticipées en cours, 0 pour lire chaque fichier avec fread
+    const char* socket;     // --serve : socket sur laquelle le serveur attend les requêtes
+    size_t travailleurs;    // --workers : requêtes traitées à la fois par le serveur
+    size_t memoire;         // --max-memory : limite de mémoire du processus, 0 si aucune
+    bool compteurs;         // --perf-counters : compteurs matériels par phase, affichés à la fin
+    const char* trace;      // --trace : fichier de la chronologie de la recherche, ou NULL
+    Options options;
+};
+typedef struct Arguments Arguments;
+
+/// @brief détermine si l'option `arg` est suivie d'une valeur
+/// @param arg
+/// @return
+bool option_avec_valeur(const char* arg)
 {
-    char* input_filename = NULL;
-    char* regular_expression_char = NULL;
-    FILE* source = NULL;
-    size_t alphabet_size = 255;
-    bool verbose = false;
-    bool show_line = false;
-    bool line_match= false;
-
-    for(size_t i=1;i<argc;i++)
+    const char* options[] = {"--alphabet","--after-context","-A","--before-context","-B","--context","-C",
+        "--binary-files","--read-ahead","--errors","--serve","--workers","--max-memory","--trace"};
+    for(size_t i=0;i<sizeof(options)/sizeof(options[0]);i++)
+        if(strcmp(arg,options[i])==0)
+            return true;
+    return false;
+}
+
+/// @brief lit une taille en octets, suivie d'un suffixe K, M ou G facultatif (puissances de 1024)
+/// @param texte
+/// @param taille
+/// @return false si la taille est incorrecte
+bool lire_taille(const char* texte,size_t* taille)
+{
+    char* fin;
+    unsigned long long n = strtoull(texte,&fin,10);
+    if(fin==texte)
+        return false;
+    switch(*fin)
+    {
+    case 'G': case 'g': n *= 1024; // fallthrough
+    case 'M': case 'm': n *= 1024; // fallthrough
+    case 'K': case 'k': n *= 1024; fin++; break;
+    default: break;
+    }
+    *taille = n;
+    return *fin=='\0';
+}
+
+/// @brief lit les arguments de la ligne de commande
+/// @param argc
+/// @param argv arguments, sans le nom du programme
+/// @param a
+/// @param erreurs flux sur lequel une erreur est décrite
+/// @return false si les arguments sont incorrects (rien ne reste alors à libérer)
+bool lire_arguments(size_t argc,char** argv,Arguments* a,FILE* erreurs)
+{
+    Options options = {false,false,false,0,0,BINAIRE_SIGNALER,false,false,false,false,NULL};
+    a->regular_expression = NULL;
+    a->fichiers = malloc(sizeof(char*)*(argc+1));
+    a->nb_fichiers = 0;
+    a->alphabet_size = 255;
+    a->gzip = false;
+    a->expliquer = false;
+    a->suivre = false;
+    a->erreurs = 0;
+    a->profondeur = LECTURE_PROFONDEUR;
+    a->socket = NULL;
+    a->travailleurs = SERVEUR_TRAVAILLEURS;
+    a->memoire = 0;
+    a->compteurs = false;
+    a->trace = NULL;
+    a->options = options;
+
+    for(size_t i=0;i<argc;i++)
     {
         char* arg = argv[i];
+        if(option_avec_valeur(arg) && i+1>=argc)
+        {
+            fprintf(erreurs,"Valeur manquante après %s !\n",arg);
+            free(a->fichiers);
+            return false;
+        }
 
-        if(strcmp(arg,"--alphabet")==0 || strcmp(arg,"-A")==0)
+        if(strcmp(arg,"--alphabet")==0)
+        {
+            a->alphabet_size = atoll(argv[++i]);
+        }else if(strcmp(arg,"--after-context")==0 || strcmp(arg,"-A")==0)
+        {
+            a->options.apres = atoll(argv[++i]);
+        }else if(strcmp(arg,"--before-context")==0 || strcmp(arg,"-B")==0)
+        {
+            a->options.avant = atoll(argv[++i]);
+        }else if(strcmp(arg,"--context")==0 || strcmp(arg,"-C")==0)
+        {
+            a->options.avant = a->options.apres = atoll(argv[++i]);
+        }else if(strcmp(arg,"--binary-files")==0)
+        {
+            char* type = argv[++i];
+            if(strcmp(type,"binary")==0)
+                a->options.binaire = BINAIRE_SIGNALER;
+            else if(strcmp(type,"without-match")==0)
+                a->options.binaire = BINAIRE_IGNORER;
+            else if(strcmp(type,"text")==0)
+                a->options.binaire = BINAIRE_TEXTE;
+            else
+            {
+                fprintf(erreurs,"Type de fichier binaire inconnu : %s (binary, without-match ou text)\n",type);
+                free(a->fichiers);
+                return false;
+            }
+        }else if(strcmp(arg,"--decompress")==0 || strcmp(arg,"-z")==0)
+        {
+            a->gzip = true;
+        }else if(strcmp(arg,"--json")==0)
         {
-            alphabet_size = atoll(argv[++i]);
+            a->options.json = true;
+        }else if(strcmp(arg,"--only-matching")==0 || strcmp(arg,"-o")==0)
+        {
+            a->options.seulement_motifs = true;
+        }else if(strcmp(arg,"--byte-offset")==0 || strcmp(arg,"-b")==0)
+        {
+            a->options.positions = true;
+        }else if(strcmp(arg,"--serve")==0)
+        {
+            a->socket = argv[++i];
+        }else if(strcmp(arg,"--workers")==0)
+        {
+            a->travailleurs = atoll(argv[++i]);
+        }else if(strcmp(arg,"--max-memory")==0)
+        {
+            if(!lire_taille(argv[++i],&a->memoire))
+            {
+                fprintf(erreurs,"Taille incorrecte après --max-memory : %s !\n",argv[i]);
+                free(a->fichiers);
+                return false;
+            }
+        }else if(strcmp(arg,"--follow")==0)
+        {
+            a->suivre = true;
+        }else if(strcmp(arg,"--read-ahead")==0)
+        {
+            a->profondeur = atoll(argv[++i]);
+        }else if(strcmp(arg,"-a")==0)
+        {
+            a->options.binaire = BINAIRE_TEXTE;
+        }else if(strcmp(arg,"-I")==0)
+        {
+            a->options.binaire = BINAIRE_IGNORER;
+        }else if(strcmp(arg,"--errors")==0)
+        {
+            a->erreurs = atoll(argv[++i]);
+        }else if(strcmp(arg,"--explain")==0)
+        {
+            a->expliquer = true;
+        }else if(strcmp(arg,"--perf-counters")==0)
+        {
+            a->compteurs = true;
+        }else if(strcmp(arg,"--trace")==0)
+        {
+            a->trace = argv[++i];
         }else if(strcmp(arg,"--verbose")==0)
         {
-            verbose= true;
+            a->options.verbose= true;
         }else if(strcmp(arg,"--lines")==0)
         {
-            show_line = true;
+            a->options.show_line = true;
         }else if(strcmp(arg,"--line-match")==0)
         {
-            line_match=true;
+            a->options.line_match=true;
         }
         else
         {
-            if(regular_expression_char==NULL)
-                regular_expression_char = arg;
+            if(a->regular_expression==NULL)
+                a->regular_expression = arg;
             else
-                input_filename = arg;
+                a->fichiers[a->nb_fichiers++] = arg;
         }
     }
 
-    if(regular_expression_char==NULL)
+    if(a->regular_expression==NULL && a->socket==NULL)
+    {
+        fprintf(erreurs,"Argument maquant !\n");
+        free(a->fichiers);
+        return false;
+    }
+    if(a->suivre && (a->nb_fichiers!=1 || a->gzip))
+    {
+        fprintf(erreurs,"--follow suit un seul fichier, non compressé !\n");
+        free(a->fichiers);
+        return false;
+    }
+    a->options.plusieurs_fichiers = a->nb_fichiers>1;
+    return true;
+}
+
+
+#ifdef SERVEUR_DISPONIBLE
+/// @brief traite une requête reçue par le serveur (voir `Traitement`) : le motif compilé et les fichiers projetés en mémoire
+/// sont pris dans les caches du serveur, seule la recherche reste à faire
+int servir(Serveur* s,const char* repertoire,size_t argc,char** argv,FILE* sortie,FILE* erreurs)
+{
+    Arguments a;
+    if(!lire_arguments(argc,argv,&a,erreurs))
+        return 1;
+    if(a.socket!=NULL || a.gzip || a.suivre || a.options.verbose || a.compteurs || a.trace!=NULL || (a.nb_fichiers==0 && !a.expliquer))
     {
-        fprintf(stderr,"Argument maquant !\n");
+        fprintf(erreurs,"Le serveur ne lit que des fichiers, sans --serve, -z, --follow, --verbose, --perf-counters ni --trace !\n");
+        free(a.fichiers);
         return 1;
     }
 
+    // le motif est identifié par l'expression et les paramètres de sa compilation
+    size_t taille = strlen(a.regular_expression)+64;
+    char* cle = malloc(taille);
+    snprintf(cle,taille,"%zu %zu %s",a.alphabet_size,a.erreurs,a.regular_expression);
+    Motif* motif = Cache_prendre(s->motifs,cle);
+    if(motif==NULL)
+    {
+        // le client reçoit le même diagnostic qu'une exécution locale
+        Motif_erreurs(erreurs);
+        motif = Motif_compile_approche(a.regular_expression,a.alphabet_size,a.erreurs);
+        Motif_erreurs(NULL);
+        if(motif==NULL)
+        {
+            free(cle);
+            free(a.fichiers);
+            return 1;
+        }
+        motif = Cache_ajouter(s->motifs,cle,motif);
+    }
+    free(cle);
+
+    int code = 0;
+    if(a.expliquer)
+    {
+        Motif_explain(motif,sortie);
+    }else
+    {
+        Scratch* scratch = Scratch_init(motif);
+        a.options.sortie = Sortie_init(sortie);
+        size_t motifs_count = 0;
+        for(size_t i=0;i<a.nb_fichiers;i++)
+        {
+            // les noms relatifs partent du répertoire du client
+            const char* nom = a.fichiers[i];
+            size_t longueur = strlen(repertoire)+strlen(nom)+2;
+            char* chemin = malloc(longueur);
+            if(nom[0]=='/')
+                snprintf(chemin,longueur,"%s",nom);
+            else
+                snprintf(chemin,longueur,"%s/%s",repertoire,nom);
+
+            Corpus* c = Serveur_corpus(s,chemin);
+            free(chemin);
+            if(c==NULL)
+            {
+                fprintf(erreurs,"Impossible d'ouvrir le fichier %s!\n",nom);
+                code = 1;
+                continue;
+            }
+            Entree* entree = Entree_init_memoire(c->data,c->size,a.options.binaire!=BINAIRE_TEXTE && Corpus_binaire(c,a.alphabet_size));
+            if(a.options.avant==0 && a.options.apres==0)
+                chercher_blocs(motif,scratch,&a.options,entree,nom,&motifs_count);
+            else
+                chercher(motif,scratch,&a.options,entree,nom,&motifs_count);
+            Entree_free(entree);
+            Cache_rendre(s->corpus,c);
+        }
+        Sortie_free(a.options.sortie);
+        Scratch_free(scratch);
+    }
+    Cache_rendre(s->motifs,motif);
+    free(a.fichiers);
+    return code;
+}
+#endif
+
+int main(int argc,char** argv)
+{
+#ifdef SERVEUR_DISPONIBLE
+    // --client : les autres arguments sont envoyés au serveur, qui fait la recherche
+    for(int i=1;i+1<argc;i++)
+    {
+        if(strcmp(argv[i],"--client")==0)
+        {
+            char** requete = malloc(sizeof(char*)*argc);
+            size_t n = 0;
+            for(int j=1;j<argc;j++)
+                if(j!=i && j!=i+1)
+                    requete[n++] = argv[j];
+            int code = Client_executer(argv[i+1],n,requete);
+            free(requete);
+            return code;
+        }
+    }
+#endif
 
-    Lettre* regular_expression = char_to_Lettre(regular_expression_char,alphabet_size);
+    Arguments a;
+    if(!lire_arguments(argc-1,argv+1,&a,stderr))
+        return 1;
+    Memoire_limiter(a.memoire);
+    if(a.socket!=NULL)
+    {
+        free(a.fichiers);
+#ifdef SERVEUR_DISPONIBLE
+        return Serveur_executer(a.socket,a.travailleurs,servir);
+#else
+        fprintf(stderr,"--serve n'est pas disponible sur ce système !\n");
+        return 1;
+#endif
+    }
 
-    if(verbose)
+    if(a.options.verbose)
     {
-        fprintf(stderr,"Recherche %s \'%s\' dans ",(line_match)?"de la phrase":"du motif",regular_expression_char);
-        if(input_filename!=NULL)
+        fprintf(stderr,"Recherche %s \'%s\' dans ",(a.options.line_match)?"de la phrase":"du motif",a.regular_expression);
+        if(a.nb_fichiers>0)
         {
-            fprintf(stderr,"le fichier %s \n",input_filename);
+            fprintf(stderr,"%s",(a.nb_fichiers>1)?"les fichiers":"le fichier");
+            for(size_t i=0;i<a.nb_fichiers;i++)
+                fprintf(stderr," %s",a.fichiers[i]);
+            fprintf(stderr,"\n");
         }else
         {
             fprintf(stderr,"l'entrée standard\n");
         }
     }
     
-    Tree* t = NULL;
-    Automate* a = NULL;
-    Automate* reverse_automate = NULL;
-    Automate* line_automate = NULL;
-
-    
-    t = make_syntaxique_tree(regular_expression);
-    if(t==NULL)
+    if(a.trace!=NULL && !Trace_ouvrir(a.trace))
     {
-        fprintf(stderr,"Impossible de comprendre l'expression !\n");
-        goto LIBERATION_ERROR;
+        fprintf(stderr,"Impossible de créer le fichier %s!\n",a.trace);
+        free(a.fichiers);
+        return 1;
     }
-    if(verbose)
+    Mesures* mesures = a.compteurs?Mesures_init(PHASE_COMPILATION):NULL;
+    uint64_t trace = Trace_maintenant();
+    Motif* motif = Motif_compile_approche(a.regular_expression,a.alphabet_size,a.erreurs);
+    Trace_intervalle("compilation",trace,strlen(a.regular_expression));
+    if(motif==NULL)
     {
-        printf("arbre syntaxique : ");Tree_print(t); printf("\n");
+        Mesures_free(mesures);
+        Trace_fermer();
+        free(a.fichiers);
+        return 1;
     }
-        
-    a = make_thomson_automate(t,alphabet_size);
-    if(a==NULL)
+    if(a.options.verbose)
     {
-        fprintf(stderr,"Impossible de construire l'automate associé à l'expression %s !\n",regular_expression_char);
-        goto LIBERATION_ERROR;
+        Motif_print(motif);
     }
-    if(verbose)
+    if(a.expliquer)
     {
-        Automate_print(a);
+        // seulement le plan de recherche, sans lire l'entrée
+        Motif_explain(motif,stdout);
+        if(mesures!=NULL)
+            Mesures_afficher(mesures,stderr,0);
+        Mesures_free(mesures);
+        Trace_fermer();
+        free(a.fichiers);
+        Motif_free(motif);
+        return 0;
     }
 
-    if(input_filename==NULL)
-    {
-        source = stdin;
-    }else
-    {
+    if(mesures!=NULL)
+        Mesures_phase(mesures,PHASE_RECHERCHE);
 
-        source = fopen(input_filename,"r");
-        if (source==NULL)
-        {
-            fprintf(stderr,"Impossible d'ouvrir le fichier %s!\n",input_filename);
-            goto LIBERATION_ERROR;
-        }
-        
+    // les fichiers réguliers sont lus à l'avance, dans l'ordre, par un même lecteur
+    // (les fichiers compressés sont lus par le thread de décompression)
+    Lecteur* lecteur = NULL;
+    char** reguliers = malloc(sizeof(char*)*(a.nb_fichiers+1));
+    bool* lu_par_lecteur = malloc(sizeof(bool)*(a.nb_fichiers+1));
+    size_t nb_reguliers = 0;
+    for(size_t i=0;i<a.nb_fichiers;i++)
+    {
+        lu_par_lecteur[i] = !a.gzip && !a.suivre && a.profondeur>0 && fichier_regulier(a.fichiers[i]);
+        if(lu_par_lecteur[i])
+            reguliers[nb_reguliers++] = a.fichiers[i];
     }
+#ifdef LECTURE_DISPONIBLE
+    if(nb_reguliers>0)
+        lecteur = Lecteur_init(reguliers,nb_reguliers,a.profondeur);
+#endif
 
-    reverse_automate = Automate_reverse(a);
-    line_automate = Automate_line(a);
-
+    Scratch* scratch = Scratch_init(motif);
+    a.options.sortie = Sortie_init(stdout);
+    a.options.sortie->mesures = mesures;
     size_t motifs_count = 0;
     size_t line_count = 0;
-    Lettre* line = NULL;
-    while ((line=get_line(source))!=NULL)
-    {
-        if(verbose && source!=stdin)
+    size_t octets = 0;
+    int code = 0;
+    for(size_t i=0;i<a.nb_fichiers || (a.nb_fichiers==0 && i==0);i++)
+    {
+        const char* nom = (a.nb_fichiers>0)?a.fichiers[i]:"(entrée standard)";
+        FILE* source = NULL;
+        Entree* entree;
+        if(a.nb_fichiers>0 && lu_par_lecteur[i] && lecteur!=NULL)
         {
-            printf("line %ld\r",line_count);
-        }
-        //printf("lecture de \"%s\"\n",line);
-
-        if (!line_match)
+            entree = Entree_init(NULL,a.options.binaire!=BINAIRE_TEXTE,a.alphabet_size);
+            Entree_lire_depuis(entree,lecteur);
+        }else
         {
-            ListArray* ends = find_motif_end_indexs(line_automate,line);
-            ListArray* starts = find_motif_start_indexs(reverse_automate,line,ends);
-
-            if(starts->size>0)
+            if(a.nb_fichiers==0)
+            {
+                source = stdin;
+            }else
             {
-                if(show_line)
-                    printf("%ld : ",line_count);
-                if(verbose)
-                    printf(" %ld motifs : ",ends->size);
-                afficher_motifs(line,starts,ends);
-                motifs_count+= starts->size;
+                source = fopen(nom,"r");
+                if (source==NULL)
+                {
+                    fprintf(stderr,"Impossible d'ouvrir le fichier %s!\n",nom);
+                    code = 1;
+                    continue;
+                }
             }
 
-            ListArray_free(starts);
-            ListArray_free(ends);
-        }else
-        {
-            bool found = Automate_read_word(a,line);
-            if(found)
+            entree = Entree_init(source,a.options.binaire!=BINAIRE_TEXTE,a.alphabet_size);
+            if(a.gzip && !Entree_decompresser(entree))
+            {
+                fprintf(stderr,"Impossible de décompresser l'entrée (mygrep doit être compilé avec zlib) !\n");
+                Entree_free(entree);
+                if(source!=stdin)
+                    fclose(source);
+                code = 1;
+                break;
+            }
+            if(a.suivre && !Entree_suivre(entree,nom,a.options.sortie))
             {
-                motifs_count++;
-                if(show_line)
-                    printf("%ld : ",line_count);
-                char* temp_line = Lettre_to_char(line);
-                printf("%s\n",temp_line);
-                free(temp_line);
+                fprintf(stderr,"--follow n'est pas disponible sur ce système !\n");
+                Entree_free(entree);
+                fclose(source);
+                code = 1;
+                break;
             }
         }
 
-        free(line);
-        line_count++;
+        if(!entree->interactif && a.options.avant==0 && a.options.apres==0 && !a.options.verbose)
+            line_count += chercher_blocs(motif,scratch,&a.options,entree,nom,&motifs_count);
+        else
+            line_count += chercher(motif,scratch,&a.options,entree,nom,&motifs_count);
+
+        octets += entree->decalage+entree->size;
+        Entree_free(entree);
+        if(source!=NULL && source!=stdin)
+            fclose(source);
     }
     
-
-
-    if(a!=NULL)
+    Sortie_free(a.options.sortie);
+    if(mesures!=NULL)
+    {
+        Mesures_afficher(mesures,stderr,octets);
+        Mesures_free(mesures);
+    }
+    if(a.options.verbose)
     {
-        Automate_free(a);
-        if(reverse_automate!=NULL)
-        Automate_free(reverse_automate);
-        if(line_automate!=NULL)
-        Automate_free(line_automate);
+        MotifStats stats = Scratch_stats(scratch);
+        fprintf(stderr,"%ld lignes, %ld motifs, %ld octets lus, %ld octets évités\n",line_count,motifs_count,stats.octets_lus,stats.octets_evites);
+        if(Memoire_limite()>0)
+            fprintf(stderr,"mémoire : pic de %zu octets (limite de %zu octets)\n",Memoire_pic(),Memoire_limite());
+        else
+            fprintf(stderr,"mémoire : pic de %zu octets\n",Memoire_pic());
     }
-    if(t!=NULL)Tree_free(t);
-    if(regular_expression!=NULL)free(regular_expression);
-    Ensemble_free_pool();
-    return 0;
 
-LIBERATION_ERROR:
-    if(a!=NULL)
+#ifdef LECTURE_DISPONIBLE
+    Lecteur_free(lecteur);
+#endif
+    // tous les threads sont terminés : leurs intervalles peuvent être écrits
+    if(!Trace_fermer())
     {
-        Automate_free(a);
-        if(reverse_automate!=NULL)
-        Automate_free(reverse_automate);
-        if(line_automate!=NULL)
-        Automate_free(line_automate);
+        fprintf(stderr,"Impossible d'écrire la trace dans %s!\n",a.trace);
+        code = 1;
     }
-    if(t!=NULL)Tree_free(t);
-    if(regular_expression!=NULL)free(regular_expression);
-    Ensemble_free_pool();
-    return 1;
+    free(reguliers);
+    free(lu_par_lecteur);
+    free(a.fichiers);
+    Scratch_free(scratch);
+    Motif_free(motif);
+    Scratch_thread_cleanup();
+    return code;
 }
-
-
@@ -0,0 +1,106 @@
+/*
+    By Adrien Couvidat
+    libmygrep : interface publique
+
+    utilisation :
+        Motif* m = Motif_compile("a(b|c)*",255);   // une seule fois, partageable entre threads
+        Scratch* s = Scratch_init(m);               // un brouillon par thread
+        size_t start,end,from = 0;
+        while(Motif_find_next(m,s,line,size,from,&start,&end))
+        {
+            ... line[start..end[ est un motif (vide si start==end) ...
+            from = (end>start)?end:end+1;
+        }
+        Scratch_free(s);
+        Motif_free(m);
+        Scratch_thread_cleanup();
+*/
+
+#ifndef MYGREP_H
+#define MYGREP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/// @brief Expression rationnelle compilée (arbre syntaxique et automates associés)
+/// @note un motif n'est jamais modifié après `Motif_compile` : il peut être lu par plusieurs threads à la fois
+typedef struct Motif Motif;
+
+/// @brief Espace de travail utilisé pendant la recherche d'un motif
+/// @note chaque thread doit posséder son propre brouillon, la recherche n'alloue alors aucune mémoire
+typedef struct Scratch Scratch;
+
+/// @brief compile une expression rationnelle
+/// @param regular_expression expression sous forme de chaîne de caractère terminée par '\0'
+/// @param alphabet_size nombre de lettres de l'alphabet (255 pour des octets)
+/// @return le motif compilé ou NULL si l'expression est incorrecte (le détail est écrit sur stderr, ou sur le flux donné à `Motif_erreurs`)
+Motif* Motif_compile(const char* regular_expression,size_t alphabet_size);
+
+/// @brief compile une expression rationnelle pour une recherche approchée :
+/// un motif est un mot reconnu par l'expression à au plus `erreurs` insertions, suppressions ou substitutions de lettres près
+/// @param erreurs 0 pour une recherche exacte (`Motif_compile`)
+Motif* Motif_compile_approche(const char* regular_expression,size_t alphabet_size,size_t erreurs);
+
+/// @brief redirige les messages d'erreur des compilations du thread appelant (par exemple vers le client d'un serveur)
+/// @param flux NULL pour revenir à stderr
+void Motif_erreurs(FILE* flux);
+
+/// @brief libère un motif compilé (aucun brouillon associé ne doit encore être utilisé)
+void Motif_free(Motif* m);
+
+/// @brief affiche l'arbre syntaxique et l'automate d'un motif sur la sortie standard
+void Motif_print(const Motif* m);
+
+/// @brief décrit la méthode de recherche choisie pour le motif (chaîne fixe, automate, préfiltre...) et la raison de ce choix
+void Motif_explain(const Motif* m,FILE* flux);
+
+/// @brief instancie un brouillon pour rechercher le motif `m`
+Scratch* Scratch_init(const Motif* m);
+
+void Scratch_free(Scratch* s);
+
+/// @brief libère la mémoire que la bibliothèque conserve pour le thread appelant
+/// (à appeler avant la fin de chaque thread ayant utilisé la bibliothèque)
+void Scratch_thread_cleanup(void);
+
+/// @brief détermine si la ligne entière est reconnue par le motif
+/// @param line ligne à lire (pas forcément terminée par '\0')
+/// @param size nombre d'octets de `line`
+bool Motif_match(const Motif* m,Scratch* s,const char* line,size_t size);
+
+/// @brief cherche le prochain motif de `line` qui commence à partir de l'index `from`
+/// @note comme grep, le motif le plus à gauche puis le plus long (le plus court pour une recherche approchée)
+/// @param start index du premier octet du motif trouvé
+/// @param end index qui suit le dernier octet du motif trouvé (`*end==*start` pour un motif vide :
+/// la recherche suivante doit alors reprendre à `*end+1`)
+/// @return true si un motif a été trouvé
+bool Motif_find_next(const Motif* m,Scratch* s,const char* line,size_t size,size_t from,size_t* start,size_t* end);
+
+/// @brief cherche dans un bloc de lignes séparées par '\n' le premier octet à partir duquel une ligne peut contenir un motif,
+/// pour ne découper en lignes que les parties du bloc qui peuvent en contenir
+/// @param data lignes, séparées par '\n'
+/// @param size nombre d'octets de `data`
+/// @param position aucune ligne qui se termine avant `data[*position]` ne contient de motif
+/// @return false si aucune ligne du bloc ne contient de motif
+bool Motif_candidat(const Motif* m,Scratch* s,const char* data,size_t size,size_t* position);
+
+/// @brief statistiques de lecture cumulées par un brouillon
+typedef struct MotifStats
+{
+    size_t octets_lus;      // octets lus par un automate
+    size_t octets_evites;   // octets qu'il n'a pas été nécessaire de lire (automate mort ou lettres neutres)
+} MotifStats;
+
+MotifStats Scratch_stats(const Scratch* s);
+
+/// @brief limite la mémoire des grandes allocations du processus (automates, ensembles d'états, préfiltres, tampons, caches) :
+/// au-delà, un motif est construit sans ses structures facultatives (réduction de l'automate, automate de Glushkov, préfiltres),
+/// ou n'est pas construit du tout, plutôt que d'épuiser la mémoire
+/// @param octets 0 pour aucune limite
+void Memoire_limiter(size_t octets);
+size_t Memoire_limite(void);
+/// @brief plus grande mémoire comptée depuis le début du processus
+size_t Memoire_pic(void);
+
+#endif // MYGREP_H
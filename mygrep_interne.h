@@ -0,0 +1,511 @@
+/*
+    By Adrien Couvidat
+    structures et fonctions internes de libmygrep
+    (arbres syntaxiques, listes, automates et ensembles d'états)
+*/
+
+#ifndef MYGREP_INTERNE_H
+#define MYGREP_INTERNE_H
+
+#define _CRT_SECURE_NO_WARNINGS // pour éviter des alerte de compilation avec msvc sous Windows
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "mygrep.h"
+#include "memoire.h"
+
+#define max(a,b) ((a>b)?a:b)
+#define min(a,b) ((a>b)?b:a)
+
+// variable globale propre à chaque thread
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+typedef size_t Sommet;
+typedef size_t Lettre;
+
+/*
+    Classes de lettres
+*/
+
+/// @brief Ensemble de lettres (octets) représenté par 256 bits
+struct Classe
+{
+    uint64_t bits[4];
+};
+typedef struct Classe Classe;
+
+void Classe_clear(Classe* c);
+void Classe_add(Classe* c,Lettre l);
+void Classe_add_range(Classe* c,Lettre debut,Lettre fin);
+void Classe_union(Classe* dest,Classe* source);
+void Classe_complement(Classe* c);
+bool Classe_mem(const Classe* c,Lettre l);
+size_t Classe_cardinal(const Classe* c);
+void Lettre_print(Lettre l);
+void Classe_print(Classe* c);
+
+/*
+    Arbre syntaxique
+*/
+
+#define SYNTAXE_OPERATOR_CONCATENATION '@' // priorité 2
+#define SYNTAXE_OPERATOR_ETOILE '*' // priorité 1
+#define SYNTAXE_OPERATOR_UNION '|'  // priorité 3
+#define SYNTAXE_OPERATOR_SIGMA '.'
+#define SYNTAXE_OPERATOR_JOKER '?' // priorité 1
+#define SYNTAXE_OPERATOR_REPETITION '{' // {n}, {n,} ou {n,m}, priorité 1
+#define SYNTAXE_OPERATOR_CLASSE '[' // [abc], [a-z] ou [^a-z], se comporte comme une lettre
+#define SYNTAXE_ANCRE_DEBUT '^' // noeud unaire à la racine (début d'expression), une feuille '^' est une lettre
+#define SYNTAXE_ANCRE_FIN '$' // noeud unaire à la racine (fin d'expression), une feuille '$' est une lettre
+
+#define REPETITION_MAX 100000 // borne maximale d'une répétition {n,m}
+#define REPETITION_INFINIE ((size_t)-1) // borne max de {n,}
+
+struct Tree
+{
+    Lettre etiquette;
+
+    struct Tree* left_chilfren;
+    struct Tree* right_children;
+
+    size_t min; // bornes d'une répétition {min,max}
+    size_t max;
+    Classe classe; // lettres d'une classe [...]
+
+};
+
+/// @brief Structure représentant un arbre syntaxique 
+/// l'étiquette est un opérateur autorisé ou une lettre
+/// `left_children` et `right_children` sont les enfants du noeud
+/// @note le noeud n'a pas d'enfant si et seulement si `left_children=NULL`
+/// @note le noeud n'a qu'un seul enfant si et seulement si  `right_children=NULL`
+/// @note `min` et `max` ne sont utilisés que par l'opérateur de répétition, `classe` que par les classes de lettres
+typedef struct Tree Tree;
+
+bool is_operator(Lettre l);
+bool is_operator_binaire(Lettre l);
+bool is_operator_unaire(Lettre l);
+Tree* Tree_init(Lettre etiquette,Tree* left,Tree* right);
+void Tree_free(Tree* tree);
+void Tree_print(Tree* tree);
+bool is_racine(Tree* tree);
+size_t str_len(Lettre* str);
+Tree** make_forest(Lettre* er,size_t* forest_size);
+Tree* merge_forest(Tree** forest,size_t forest_size);
+size_t fin_classe(Lettre* er,size_t i);
+Tree* Tree_mot_vide(void);
+Tree* make_syntaxique_tree(Lettre* er);
+FILE* Motif_flux_erreurs(void);
+bool Tree_egal(Tree* a,Tree* b);
+void Tree_operandes(Tree* tree,Lettre operateur,Tree** elements,size_t* size);
+Tree* Tree_operation(Lettre operateur,Tree** elements,size_t size);
+Tree* Tree_factoriser(Tree** branches,size_t nb_branches,size_t alphabet_size);
+Tree* Tree_simplifier_union(Tree* tree,size_t alphabet_size);
+Tree* Tree_simplifier(Tree* tree,size_t alphabet_size);
+
+/*
+    Listes
+*/
+
+#define MIN_LISTARRAY_CAPACITY 4
+#define LISTARRAY_EXPANSION_COEF 2
+struct ListArray
+{
+    size_t capacity;
+    size_t size;
+    Sommet* data;
+};
+
+/// @brief Structure de liste implémentée par tableau redimensionnable
+/// @brief possibilité de faire for(size_t index=0;index<list->size;index++) list->data[index] ;;; pour parcourir la liste
+/// @brief ou de faire list->data[index] pour accéder à une valeur précise en temps constant tant que index<list->size
+typedef struct ListArray ListArray;
+
+ListArray* ListArray_init(void);
+void ListArray_free(ListArray* list);
+void ListArray_push(ListArray* list,Sommet s);
+Sommet ListArray_pop(ListArray* list);
+Sommet ListArray_remove(ListArray* list,size_t index);
+bool ListArray_empty(ListArray* list);
+void ListArray_print(ListArray* list);
+ListArray* ListArray_copy(ListArray* list);
+void ListArray_iter(ListArray* list,void (*f)(Sommet));
+void ListArray_map(ListArray* list,Sommet (*f)(Sommet));
+ListArray* ListArray_concatenation(ListArray* list1,ListArray* list2);
+void ListArray_extend(ListArray* dest,ListArray* source);
+void ListArray_reindexation(ListArray* list,long long delta_index);
+
+/*
+    Automates (construction de Thomson)
+*/
+
+#define EPSILON_TRANSITION_INDEX 0
+
+#define REPETITION_SEUIL_COMPTEUR 16 // au delà, une répétition d'un corps de peu de positions est représentée par un compteur
+#define REPETITION_MAX_OCTETS ((size_t)256*1024*1024) // mémoire maximale des automates d'une répétition dépliée (ses AUTOMATE_COPIES copies)
+#define AUTOMATE_COPIES 3 // copies d'un automate indispensables à la recherche : l'automate, son inverse et l'automate (.)*e
+#define COMPTEUR_POSITIONS_MAX 16 // positions de Glushkov au plus du corps d'une répétition représentée par un compteur
+#define COMPTEURS_LISTE_MIN 8 // au delà, les compteurs en cours sont listés et ceux qui commencent cherchés par l'index
+
+/// @brief Répétition bornée e{min,max} d'une expression e qui ne reconnaît pas le mot vide et a peu de positions
+/// au lieu de recopier max fois l'automate de e, on lit e par ses positions de Glushkov (sans epsilon transition)
+/// et on retient pour chaque position j un vecteur de bits : le bit k indique qu'une lecture a terminé k copies de e
+/// et vient de lire la position j de la copie suivante. Une lettre fait passer les bits d'une position à ses suivantes,
+/// une copie terminée (dernière position) décale les bits d'un rang et recommence aux premières positions
+struct Compteur
+{
+    Sommet entree; // lorsque cet état est actif, un nouveau décompte commence (0 copie terminée)
+    Sommet sortie; // état rendu actif lorsque le nombre de copies terminées est dans [min;max]
+    size_t min;
+    size_t max;    // REPETITION_INFINIE pour e{min,}
+    size_t borne;  // plus grand nombre de copies retenu : max, ou min si max est infini (le rang min est alors saturant)
+    size_t offset; // index du premier mot des vecteurs de bits parmi ceux de l'automate
+    size_t nb_mots; // mots de tous les vecteurs du compteur : nb_positions*largeur
+    size_t largeur; // mots du vecteur de bits d'une position (rangs 0 à borne)
+    size_t nb_positions;
+    Classe positions[COMPTEUR_POSITIONS_MAX];  // lettres acceptées par chaque position de e
+    uint64_t premiers;                          // positions qui commencent une copie de e (bit j : position j)
+    uint64_t derniers;                          // positions qui terminent une copie de e
+    uint64_t suivants[COMPTEUR_POSITIONS_MAX];  // positions qui suivent la position j dans une même copie de e
+};
+typedef struct Compteur Compteur;
+
+/// @brief transition de `source` vers `dest` par n'importe quelle lettre d'une classe
+/// (une seule transition au lieu d'une par lettre)
+struct TransitionClasse
+{
+    Sommet source;
+    Sommet dest;
+    Classe classe;
+};
+typedef struct TransitionClasse TransitionClasse;
+
+struct Automate
+{
+    size_t alphabet_size;
+    size_t nb_etat; // nombre d'état de l'automate
+    ListArray* initiaux; // liste des états initiaux de l'automate
+    ListArray* finaux; // liste des états finaux de l'automate
+    ListArray*** transitions; // tableau des transitions de l'automate (une liste par état) : 
+                              //j est accessible depuis i par la lettre a ssi j est dans transitions[i][a]
+                              // les lettres possibles sont 1 à 255
+                              // le 0 étant réservé pour les epsilon transitions
+    TransitionClasse* classes; // transitions par classe de lettres
+    size_t nb_classes;
+    Compteur* compteurs; // répétitions bornées (voir `Compteur`)
+    size_t nb_compteurs;
+    size_t nb_mots_compteurs; // nombre total de mots des vecteurs de bits des compteurs
+    size_t* classes_debut;    // index (voir `Automate_indexer`) : les transitions par classe depuis q sont
+                              // classes[classes_debut[q]] à classes[classes_debut[q+1]-1], NULL sans index
+    size_t* compteurs_debut;  // de même pour les compteurs dont q est l'entrée
+};
+typedef struct Automate Automate;
+
+size_t Automate_octets(size_t nb_etat,size_t alphabet_size);
+Automate* Automate_init(size_t nb_etat,size_t alphabet_size);
+void Automate_free(Automate* a);
+void Automate_print(Automate* a);
+Automate* Automate_copy(Automate* a);
+void Automate_reindexation(Automate* a,long long delta_index);
+void Automate_add_etat_initial(Automate* a,size_t q);
+void Automate_add_etat_final(Automate* a,size_t q);
+void Automate_add_transition(Automate* a,size_t source,size_t lettre,size_t dest);
+Automate* Automate_merge(Automate* a1,Automate* a2);
+Automate* Automate_lettre(Lettre lettre,size_t alphabet_size);
+Automate* Automate_union(Automate* a1,Automate* a2);
+Automate* Automate_concatenation(Automate* a1,Automate* a2);
+Automate* Automate_etoile(Automate* a);
+Automate* Automate_joker(Automate* a);
+Automate* Automate_sigma(size_t alphabet_size);
+void Automate_add_transition_classe(Automate* a,Sommet source,Classe* classe,Sommet dest);
+void Automate_add_classes_et_compteurs(Automate* dest,Automate* source,size_t delta_index);
+Automate* Automate_classe(Classe* classe,size_t alphabet_size);
+Automate* Automate_compteur(Tree* corps,size_t min,size_t max,size_t alphabet_size);
+void Compteur_inverser(Compteur* k);
+Automate* Automate_repetition(Automate* a,size_t min,size_t max);
+bool Tree_classe(Tree* tree,Classe* lettres,size_t alphabet_size);
+Automate* Automate_reverse(Automate* a);
+Automate* Automate_line(Automate* a);
+Automate* make_thomson_automate(Tree* syntaxique_tree,size_t alphabet_size,bool compteurs);
+void Automate_indexer(Automate* a);
+void Automate_desindexer(Automate* a);
+size_t Automate_mots_bits(Automate* a);
+void Automate_compteurs_clear(Automate* a,uint64_t* bits);
+bool Automate_etat_relais(Automate* a,Sommet q,bool compteur,bool source_classe,bool final,Sommet* suivant);
+Automate* Automate_reduire(Automate* a);
+
+/*
+    Ensembles d'états
+*/
+
+#define ENSEMBLE_NB_CLASSES 64
+#define ENSEMBLE_POOL_MAX_OCTETS (16*1024*1024) // mémoire maximale conservée par thread pour réutiliser les ensembles
+
+/// @brief Implémentation des ensembles finies
+/// Interface : initialisation O(n); libération O(1); ajout O(1);
+/// test d'appartenance O(1); fusion O(n)
+struct Ensemble
+{
+    bool* data;         // data[s] vaut true si s est dans l'ensemble
+    Sommet* elements;   // liste des éléments actifs, dans l'ordre d'insertion
+    size_t cardinal;    // nombre d'éléments de `elements`
+    size_t size;
+    size_t classe; // `data` peut contenir 2^classe éléments
+    struct Ensemble* suivant; // ensemble libre suivant dans la réserve
+};
+typedef struct Ensemble Ensemble;
+
+size_t Ensemble_classe(size_t n);
+size_t Ensemble_octets(size_t classe);
+void Ensemble_pool_teardown(void);
+Ensemble* Ensemble_init(size_t n);
+void Ensemble_free(Ensemble* e);
+void Ensemble_print(Ensemble* e);
+void Ensemble_add(Ensemble* e,Sommet s);
+bool Ensemble_mem(Ensemble* e,Sommet s);
+Ensemble* Ensemble_copy(Ensemble* e);
+void Ensemble_copy_into(Ensemble* dest,Ensemble* source);
+void Ensemble_clear(Ensemble* e);
+Ensemble* Ensemble_merge(Ensemble* a,Ensemble* b);
+bool Ensemble_vide(Ensemble* e);
+bool Ensemble_egal(Ensemble* a,Ensemble* b);
+void Ensemble_eat_list(Ensemble* e,ListArray* list);
+uint64_t Ensemble_empreinte(Ensemble* e);
+
+/*
+    Lecture d'un texte par un automate
+*/
+
+/// @brief Brouillon d'un thread : ensembles d'états réutilisés d'une lecture à l'autre
+struct Scratch
+{
+    Ensemble* Q;        // états courants de l'automate ligne
+    Ensemble* next_Q;   // états de l'automate ligne après lecture d'une lettre
+    Ensemble* R;        // états courants de l'automate (ou de son inverse)
+    Ensemble* next_R;   // états de l'automate (ou de son inverse) après lecture d'une lettre
+    uint64_t* bits_Q;   // vecteurs de bits des compteurs associés à chacun des ensembles
+    uint64_t* bits_next_Q;
+    uint64_t* bits_R;
+    uint64_t* bits_next_R;
+    uint64_t* rangs;    // recherche approchée : une ligne de positions par nombre d'erreurs (voir approche.c)
+    uint64_t* rangs_suivants;
+    Ensemble** ensembles;   // recherche approchée sans automate de Glushkov : une ligne d'états par nombre d'erreurs
+    Ensemble** ensembles_suivants;
+    Ensemble* tampon;
+    size_t erreurs;
+    size_t memoire;         // octets des vecteurs de bits et des lignes de rangs, comptés dans le budget de mémoire
+                            // (les ensembles le sont par leur réserve)
+    size_t octets_lus;      // statistiques de lecture (voir `Scratch_stats`)
+    size_t octets_evites;
+};
+
+/*
+    Plan de recherche
+*/
+
+#define BNDM_POSITIONS_MAX 64      // une position par bit d'un uint64_t
+#define BNDM_LETTRES_SELECTIVES 8   // une position qui accepte plus de lettres ne permet pas de sauter beaucoup
+#define BNDM_LITTERAL_MIN 4         // une chaîne fixe plus courte est cherchée avec memmem
+#define BNDM_FACTEUR_MIN 3          // positions sélectives d'un facteur obligatoire pour qu'il serve de préfiltre
+
+/// @brief recherche BNDM d'une suite d'au plus BNDM_POSITIONS_MAX classes de lettres (voir bndm.c)
+struct Bndm
+{
+    size_t m;               // nombre de positions
+    uint64_t masques[256];  // bit m-1-i : la lettre est acceptée à la position i
+};
+typedef struct Bndm Bndm;
+
+Bndm* Bndm_init(const Classe* positions,size_t m);
+void Bndm_free(Bndm* b);
+bool Bndm_chercher(const Bndm* b,Scratch* s,const unsigned char* texte,size_t size,size_t* position);
+bool Bndm_egal(const Bndm* b,const unsigned char* texte,size_t size);
+bool Tree_positions(Tree* tree,size_t alphabet_size,Classe* positions,size_t* size);
+size_t Tree_facteur(Tree* tree,size_t alphabet_size,Classe* positions,size_t* size);
+
+#define ACCELERATION_SORTIES 3  // lettres de sortie au plus d'un état accéléré
+
+/// @brief état accéléré : il boucle sur toutes les lettres sauf ses lettres de sortie,
+/// qui sont cherchées directement pour le quitter (voir acceleration.c)
+struct Acceleration
+{
+    bool active;            // faux si l'état a plus de ACCELERATION_SORTIES lettres de sortie
+    size_t nb_sorties;
+    unsigned char sorties[ACCELERATION_SORTIES];
+};
+typedef struct Acceleration Acceleration;
+
+void Acceleration_init(Acceleration* a,const Classe* boucles);
+size_t Acceleration_sauter(const Acceleration* a,const unsigned char* texte,size_t size);
+
+#define TEDDY_MOTS_MAX 64      // chaînes d'une recherche Teddy
+#define TEDDY_SEAUX 8           // un bit par seau dans les masques
+#define TEDDY_PREFIXE_MAX 3     // premiers octets des chaînes comparés par les masques
+#define TEDDY_TAILLE_MIN 2      // des chaînes plus courtes filtrent trop peu (voir `Acceleration`)
+
+/// @brief ensemble fini de mots (voir `Tree_mots`)
+struct Mots
+{
+    size_t nb;
+    unsigned char* mots[TEDDY_MOTS_MAX];
+    size_t tailles[TEDDY_MOTS_MAX];
+};
+typedef struct Mots Mots;
+
+/// @brief jeu d'instructions de `Teddy_chercher`, choisi à l'exécution
+enum TEDDY_JEU
+{
+    TEDDY_SCALAIRE,
+    TEDDY_SSSE3,
+    TEDDY_AVX2,
+};
+
+/// @brief recherche Teddy d'un ensemble de chaînes fixes (voir teddy.c)
+struct Teddy
+{
+    Mots mots;                      // chaînes triées par préfixe, les chaînes d'un seau se suivent
+    size_t debuts[TEDDY_SEAUX+1];   // première chaîne de chaque seau
+    size_t prefixe;                 // octets comparés par les masques : longueur de la chaîne la plus courte, au plus TEDDY_PREFIXE_MAX
+    uint8_t bas[TEDDY_PREFIXE_MAX][16];     // bas[k][q] : seaux dont une chaîne a le quartet bas q à la position k
+    uint8_t hauts[TEDDY_PREFIXE_MAX][16];   // hauts[k][q] : de même pour le quartet haut
+    uint8_t octets[TEDDY_PREFIXE_MAX][256]; // octets[k][o] : seaux dont une chaîne a l'octet o à la position k (version scalaire)
+    enum TEDDY_JEU jeu;
+};
+typedef struct Teddy Teddy;
+
+void Mots_free(Mots* mots);
+void Mots_ajouter(Mots* dest,const unsigned char* a,size_t a_size,const unsigned char* b,size_t b_size);
+bool Mots_concatener(Mots* dest,const Mots* suite);
+size_t Mots_taille_min(const Mots* mots);
+int Mots_comparer_prefixes(const Mots* mots,size_t i,size_t j);
+bool Tree_mots(Tree* tree,size_t alphabet_size,Mots* dest);
+Teddy* Teddy_init(Mots* mots);
+void Teddy_free(Teddy* t);
+const char* Teddy_jeu_nom(enum TEDDY_JEU jeu);
+bool Teddy_chercher(const Teddy* t,Scratch* s,const unsigned char* texte,size_t size,size_t* position);
+Teddy* Tree_teddy(Tree* tree,size_t alphabet_size,bool* debut);
+
+#define GLUSHKOV_POSITIONS_MAX 63  // le bit 0 d'un uint64_t est l'état initial
+
+/// @brief automate de Glushkov en vecteurs de bits, pour la recherche approchée (voir approche.c)
+struct Glushkov
+{
+    size_t m;                   // positions 1..m (lettres, classes et '.' de l'arbre, répétitions dépliées)
+    uint64_t lettres[256];      // bit j : la position j accepte la lettre
+    uint64_t suivants[64];      // positions qui peuvent suivre la position j (suivants[0] : premières positions)
+    uint64_t finaux;            // dernières positions, et l'état initial si le mot vide est reconnu
+    size_t nb_tables;           // octets utiles d'un vecteur de positions
+    uint64_t tables[8][256];    // tables[k][o] : réunion des suivants des positions 8k+i pour chaque bit i de o
+};
+typedef struct Glushkov Glushkov;
+
+Glushkov* Glushkov_init(Tree* tree,size_t alphabet_size,bool inverse);
+void Glushkov_free(Glushkov* g);
+uint64_t Glushkov_suivants(const Glushkov* g,uint64_t d);
+void Glushkov_depart(const Glushkov* g,size_t erreurs,uint64_t* r);
+void Glushkov_pas(const Glushkov* g,size_t erreurs,const uint64_t* r,uint64_t* n,unsigned char c,bool recherche);
+
+/// @brief méthode utilisée pour chercher un motif, choisie d'après l'arbre syntaxique (voir `Motif_planifier`)
+enum STRATEGIE
+{
+    STRATEGIE_NFA,      // simulation de l'automate de Thomson (lettres neutres sautées, voir `find_motif_end_index`)
+    STRATEGIE_LITTERAL, // chaîne fixe : memmem, ou une seule comparaison si elle est ancrée
+    STRATEGIE_BNDM,     // suite de classes de lettres (dont les chaînes fixes assez longues) : BNDM
+    STRATEGIE_APPROCHE, // au plus K erreurs : Wu-Manber sur les positions de Glushkov, ou sur les ensembles d'états
+};
+
+struct Plan
+{
+    enum STRATEGIE strategie;
+    unsigned char* litteral;    // octets de la chaîne fixe, NULL si l'expression n'en est pas une
+    size_t litteral_size;
+    size_t nb_noeuds;           // noeuds de l'arbre syntaxique
+    size_t nb_positions;        // positions de Glushkov : lettres, classes et '.'
+    size_t nb_litteraux;        // branches si l'expression est une union de chaînes fixes, 0 sinon
+    Glushkov* glushkov;         // STRATEGIE_APPROCHE : automate de Glushkov de l'expression et de son miroir,
+    Glushkov* glushkov_inverse; // NULL si il y a trop de positions (les automates de Thomson sont alors simulés)
+    Bndm* bndm;                 // motif entier (STRATEGIE_BNDM), ou facteur obligatoire qui préfiltre les lignes de STRATEGIE_NFA, ou NULL
+    Teddy* teddy;               // STRATEGIE_NFA sans facteur BNDM : chaînes fixes dont l'une se trouve dans tout motif, ou NULL
+    bool teddy_debut;           // tout motif commence par une chaîne de `teddy` : l'automate est lu depuis l'occurrence trouvée
+    bool saut_neutres;          // une ligne formée de lettres neutres (voir `Automate_repos`) ne contient aucun motif
+    Acceleration saut;          // lettres de sortie de l'état de repos, les fins de ligne comprises parmi les neutres (voir `Motif_candidat`)
+    const char* raison;         // justification du choix, affichée par `Motif_explain`
+    bool sans_reduction;        // limite de mémoire : automates non réduits (voir `Automate_reduire`)
+    bool sans_glushkov;         // limite de mémoire : recherche approchée sur les ensembles d'états
+    bool sans_prefiltre;        // limite de mémoire : facteur obligatoire ou chaînes de Teddy non cherchés
+};
+typedef struct Plan Plan;
+
+size_t Tree_nb_noeuds(Tree* tree);
+size_t Tree_nb_positions(Tree* tree);
+Tree* Tree_sans_ancres(Tree* tree);
+bool Tree_litteral(Tree* tree,size_t alphabet_size,unsigned char* dest,size_t* size);
+size_t Tree_nb_litteraux(Tree* tree,size_t alphabet_size);
+const char* Strategie_nom(enum STRATEGIE strategie);
+const unsigned char* chercher_litteral(const unsigned char* texte,size_t size,const unsigned char* litteral,size_t litteral_size);
+
+/// @brief Expression rationnelle compilée, en lecture seule une fois construite
+struct Motif
+{
+    Lettre* regular_expression;
+    size_t alphabet_size;
+    Tree* tree;                 // arbre syntaxique simplifié (voir `Tree_simplifier`)
+    size_t nb_noeuds_initial;   // noeuds de l'arbre avant simplification
+    size_t nb_etats_initial;    // états de l'automate de Thomson avant `Automate_reduire`
+    Automate* automate;         // automate de Thomson de l'expression
+    Automate* reverse_automate; // automate inverse, pour retrouver le début des motifs
+    Automate* line_automate;    // automate reconnaissant (.)*e, pour trouver la fin des motifs
+    Ensemble* init;             // cloture des états initiaux de chacun des automates
+    Ensemble* reverse_init;
+    Ensemble* line_init;
+    Ensemble* line_repos;       // états de `line_automate` quand aucun motif n'est en cours de lecture (ou NULL)
+    Classe line_neutres;        // lettres qui laissent `line_repos` inchangé, sautées par `find_motif_end_index`
+    Acceleration line_acceleration; // `line_repos` accéléré si il a peu de lettres de sortie
+    bool ancre_debut;           // motif ancré en début de ligne (^e), `line_automate` est alors inutile et vaut NULL
+    bool ancre_fin;             // motif ancré en fin de ligne (e$)
+    size_t erreurs;             // nombre maximal d'erreurs d'un motif (`Motif_compile_approche`)
+    size_t memoire_arbre;       // octets de l'arbre syntaxique, comptés dans le budget de mémoire
+    Plan plan;                  // méthode de recherche choisie à la compilation
+};
+
+Ensemble* Automate_cloture_instantanee_etat(Automate* a,Sommet q);
+Ensemble* Automate_cloture_instantanee(Automate* a,Ensemble* e);
+Ensemble* Automate_cloture_instantanee_inplace(Automate* a,Ensemble* e);
+void Automate_cloture_instantanee_into(Automate* a,Ensemble* e);
+Ensemble* Automate_read_letter(Automate* a,Ensemble* e,size_t l);
+void Automate_read_letter_into(Automate* a,Ensemble* e,size_t l,Ensemble* dest);
+void Automate_read_compteurs(Automate* a,Ensemble* e,uint64_t* bits,size_t l,Ensemble* dest,uint64_t* dest_bits);
+size_t Compteur_lire(Compteur* k,bool entree,uint64_t* bits,size_t haut,size_t l,Ensemble* dest,uint64_t* dest_bits);
+void Automate_step(Automate* a,Ensemble* e,uint64_t* bits,size_t l,Ensemble* dest,uint64_t* dest_bits);
+bool Automate_is_dead(Automate* a,Ensemble* e,uint64_t* bits);
+bool Automate_compteurs_inactifs(Automate* a,uint64_t* bits);
+Ensemble* Automate_repos(Automate* a,Ensemble* init,Classe* neutres);
+bool Automate_is_final_ensemble(Automate* a,Ensemble* e);
+Ensemble* Automate_initiaux_clos(Automate* a);
+int Automate_equivalents(Automate* a,Automate* b,size_t budget);
+bool Automate_read_word(Automate* a,Ensemble* init,Scratch* s,const unsigned char* word,size_t size);
+bool find_motif_end_index(Automate* line_automate,Ensemble* line_init,Ensemble* repos,const Classe* neutres,const Acceleration* acceleration,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* end);
+bool find_motif_avant(Automate* a,Ensemble* init,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t limite,size_t* end);
+bool find_motif_prefixe(Automate* a,Ensemble* init,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* end);
+bool find_motif_suffixe(Automate* reverse_automate,Ensemble* reverse_init,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* start);
+size_t find_motif_start_index(Automate* reverse_automate,Ensemble* reverse_init,Scratch* s,const unsigned char* line,size_t from,size_t end);
+void Motif_planifier(Motif* m);
+void Automate_read_any_into(Automate* a,Ensemble* e,Ensemble* dest);
+void Ensemble_ajouter(Ensemble* dest,Ensemble* source);
+void Automate_depart_approche(Automate* a,Ensemble* init,size_t erreurs,Ensemble** r,Ensemble* tampon);
+void Automate_pas_approche(Automate* a,size_t erreurs,Ensemble** r,Ensemble** n,Ensemble* tampon,unsigned char c);
+bool approche_fin(const Motif* m,Scratch* s,const unsigned char* line,size_t size,size_t from,bool recherche,bool fin,size_t* end,bool* vide);
+size_t approche_debut(const Motif* m,Scratch* s,const unsigned char* line,size_t from,size_t end);
+bool find_approche(const Motif* m,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* start,size_t* end);
+bool match_approche(const Motif* m,Scratch* s,const unsigned char* line,size_t size);
+bool find_litteral(const Motif* m,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* start,size_t* end);
+
+#endif // MYGREP_INTERNE_H
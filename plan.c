@@ -0,0 +1,393 @@
+/*
+    By Adrien Couvidat
+    planification : choix de la méthode de recherche d'un motif d'après son arbre syntaxique
+*/
+
+#define _GNU_SOURCE // memmem
+#include "mygrep_interne.h"
+
+/// @brief nombre de noeuds de l'arbre
+/// @param tree
+/// @return
+size_t Tree_nb_noeuds(Tree* tree)
+{
+    if(tree==NULL)
+        return 0;
+    return 1+Tree_nb_noeuds(tree->left_chilfren)+Tree_nb_noeuds(tree->right_children);
+}
+
+/// @brief nombre de positions de Glushkov de l'arbre (feuilles : lettres, classes et '.')
+/// @param tree
+/// @return
+size_t Tree_nb_positions(Tree* tree)
+{
+    if(tree==NULL)
+        return 0;
+    if(tree->left_chilfren==NULL)
+        return 1;
+    return Tree_nb_positions(tree->left_chilfren)+Tree_nb_positions(tree->right_children);
+}
+
+/// @brief sous-arbre de l'expression sans les ancres '^' et '$' de la racine
+/// @param tree
+/// @return
+Tree* Tree_sans_ancres(Tree* tree)
+{
+    while(tree!=NULL && (tree->etiquette==SYNTAXE_ANCRE_DEBUT || tree->etiquette==SYNTAXE_ANCRE_FIN) && tree->left_chilfren!=NULL)
+        tree = tree->left_chilfren;
+    return tree;
+}
+
+/// @brief détermine si l'arbre n'est qu'une concaténation de lettres, et écrit ces lettres dans `dest`
+/// @param tree arbre sans ancre
+/// @param alphabet_size les lettres hors de l'alphabet ne sont reconnues par aucun automate, l'arbre n'est alors pas une chaîne fixe
+/// @param dest au moins `Tree_nb_positions(tree)` octets, ou NULL pour seulement tester l'arbre
+/// @param size nombre de lettres déjà écrites, augmenté des lettres de l'arbre
+/// @return
+bool Tree_litteral(Tree* tree,size_t alphabet_size,unsigned char* dest,size_t* size)
+{
+    if(tree==NULL)
+        return false;
+    if(tree->left_chilfren==NULL)
+    {
+        if(tree->etiquette==SYNTAXE_OPERATOR_SIGMA || tree->etiquette==SYNTAXE_OPERATOR_CLASSE
+            || tree->etiquette==0 || tree->etiquette>=alphabet_size || tree->etiquette>255)
+            return false;
+        if(dest!=NULL)
+            dest[*size] = (unsigned char)tree->etiquette;
+        (*size)++;
+        return true;
+    }
+    if(tree->etiquette!=SYNTAXE_OPERATOR_CONCATENATION)
+        return false;
+    return Tree_litteral(tree->left_chilfren,alphabet_size,dest,size) && Tree_litteral(tree->right_children,alphabet_size,dest,size);
+}
+
+/// @brief nombre de branches si l'arbre est une union de chaînes fixes
+/// @param tree
+/// @param alphabet_size
+/// @return le nombre de chaînes, 0 si une branche n'est pas une chaîne fixe
+size_t Tree_nb_litteraux(Tree* tree,size_t alphabet_size)
+{
+    if(tree==NULL)
+        return 0;
+    if(tree->etiquette==SYNTAXE_OPERATOR_UNION && tree->left_chilfren!=NULL)
+    {
+        size_t gauche = Tree_nb_litteraux(tree->left_chilfren,alphabet_size);
+        size_t droite = Tree_nb_litteraux(tree->right_children,alphabet_size);
+        return (gauche==0 || droite==0)?0:gauche+droite;
+    }
+    size_t size = 0;
+    return Tree_litteral(tree,alphabet_size,NULL,&size)?1:0;
+}
+
+const char* Strategie_nom(enum STRATEGIE strategie)
+{
+    switch(strategie)
+    {
+    case STRATEGIE_LITTERAL: return "chaîne fixe (memmem, ou memcmp si elle est ancrée)";
+    case STRATEGIE_BNDM: return "BNDM (fenêtres lues de droite à gauche)";
+    case STRATEGIE_APPROCHE: return "recherche approchée (Wu-Manber)";
+    case STRATEGIE_NFA: return "automate de Thomson (NFA)";
+    }
+    return "?";
+}
+
+/// @brief première occurrence d'une chaîne fixe dans `texte`
+/// @param texte
+/// @param size
+/// @param litteral
+/// @param litteral_size au moins 1
+/// @return l'adresse de l'occurrence, NULL si il n'y en a pas
+const unsigned char* chercher_litteral(const unsigned char* texte,size_t size,const unsigned char* litteral,size_t litteral_size)
+{
+#ifdef __GLIBC__
+    return memmem(texte,size,litteral,litteral_size);
+#else
+    // premier octet avec memchr, puis comparaison du reste
+    const unsigned char* fin = texte+size;
+    while((size_t)(fin-texte)>=litteral_size)
+    {
+        const unsigned char* p = memchr(texte,litteral[0],fin-texte-litteral_size+1);
+        if(p==NULL)
+            return NULL;
+        if(memcmp(p+1,litteral+1,litteral_size-1)==0)
+            return p;
+        texte = p+1;
+    }
+    return NULL;
+#endif
+}
+
+/// @brief choisit la méthode de recherche du motif d'après son arbre syntaxique
+/// @note appelée par `Motif_compile`, une fois les ancres et les automates connus
+/// @param m
+void Motif_planifier(Motif* m)
+{
+    Plan* p = &m->plan;
+    Tree* tree = Tree_sans_ancres(m->tree);
+    p->nb_noeuds = Tree_nb_noeuds(m->tree);
+    p->nb_positions = Tree_nb_positions(tree);
+    p->nb_litteraux = Tree_nb_litteraux(tree,m->alphabet_size);
+    p->litteral = NULL;
+    p->litteral_size = 0;
+    p->bndm = NULL;
+    p->teddy = NULL;
+    p->teddy_debut = false;
+    bool ancre = m->ancre_debut || m->ancre_fin;
+    // l'automate (.)*e part de son état de repos : il n'en sort que par une lettre qui n'est pas neutre
+    p->saut_neutres = m->line_repos!=NULL && Ensemble_egal(m->line_init,m->line_repos);
+    p->saut.active = false;
+    if(p->saut_neutres)
+    {
+        Classe neutres = m->line_neutres;
+        Classe_add(&neutres,'\n');
+        Acceleration_init(&p->saut,&neutres);
+    }
+
+    if(m->erreurs>0)
+    {
+        // les chaînes fixes et BNDM ne tolèrent pas d'erreur
+        p->strategie = STRATEGIE_APPROCHE;
+        p->sans_glushkov = !Memoire_disponible(2*sizeof(Glushkov));
+        if(!p->sans_glushkov)
+            p->glushkov = Glushkov_init(tree,m->alphabet_size,false);
+        if(p->glushkov!=NULL)
+        {
+            p->glushkov_inverse = Glushkov_init(tree,m->alphabet_size,true);
+            p->raison = "recherche approchée : Wu-Manber en vecteurs de bits sur les positions de Glushkov (une ligne par nombre d'erreurs)";
+        }else if(p->sans_glushkov)
+            p->raison = "recherche approchée : pas de place pour l'automate de Glushkov, Wu-Manber sur les ensembles d'états de l'automate";
+        else
+            p->raison = "recherche approchée : trop de positions pour un uint64_t, Wu-Manber sur les ensembles d'états de l'automate";
+        return;
+    }
+
+    Classe* positions = malloc(sizeof(Classe)*(p->nb_positions+1));
+    size_t nb = 0;
+
+    if(p->nb_litteraux==1)
+    {
+        p->litteral = malloc(p->nb_positions);
+        Tree_litteral(tree,m->alphabet_size,p->litteral,&p->litteral_size);
+        if(!ancre && p->litteral_size>=BNDM_LITTERAL_MIN && p->litteral_size<=BNDM_POSITIONS_MAX)
+        {
+            Tree_positions(tree,m->alphabet_size,positions,&nb);
+            p->bndm = Bndm_init(positions,nb);
+            p->strategie = STRATEGIE_BNDM;
+            p->raison = "chaîne fixe assez longue : BNDM lit chaque fenêtre de droite à gauche et saute jusqu'à sa longueur sans lire";
+        }else
+        {
+            p->strategie = STRATEGIE_LITTERAL;
+            if(ancre)
+                p->raison = "chaîne fixe ancrée : une seule comparaison (memcmp) au début ou à la fin de la ligne";
+            else
+                p->raison = "chaîne fixe courte : memmem trouve la première occurrence, qui est aussi le motif qui finit le plus tôt";
+        }
+        free(positions);
+        return;
+    }
+
+    // mots de même longueur, une classe de lettres par position : toute occurrence est un motif de longueur m
+    if(!ancre && Tree_positions(tree,m->alphabet_size,positions,&nb) && nb<=BNDM_POSITIONS_MAX && nb>1)
+    {
+        p->bndm = Bndm_init(positions,nb);
+        p->strategie = STRATEGIE_BNDM;
+        p->raison = "suite de classes de lettres (motifs de même longueur) : BNDM lit chaque fenêtre de droite à gauche";
+        free(positions);
+        return;
+    }
+
+    p->strategie = STRATEGIE_NFA;
+    nb = 0;
+    size_t selectives = Tree_facteur(tree,m->alphabet_size,positions,&nb);
+    // les préfiltres sont facultatifs : sans place dans la limite de mémoire, seul l'automate est lu
+    p->sans_prefiltre = !Memoire_disponible(sizeof(Bndm)+sizeof(Teddy));
+    if(p->sans_prefiltre)
+        ;
+    else if(selectives>=BNDM_FACTEUR_MIN)
+        p->bndm = Bndm_init(positions,nb);
+    else
+    {
+        // des chaînes fixes (union) dont l'une est dans tout motif : Teddy ; si elles commencent les motifs,
+        // aucun motif ne commence avant l'occurrence trouvée
+        p->teddy = Tree_teddy(tree,m->alphabet_size,&p->teddy_debut);
+        p->teddy_debut = p->teddy!=NULL && p->teddy_debut && !ancre;
+    }
+    free(positions);
+
+    if(m->ancre_debut)
+        p->raison = "motif ancré en début de ligne : l'automate est lu depuis le début de la ligne jusqu'à ce qu'il n'ait plus d'état actif";
+    else if(m->ancre_fin)
+        p->raison = "motif ancré en fin de ligne : l'automate inverse est lu depuis la fin de la ligne";
+    else if(p->bndm!=NULL)
+        p->raison = "facteur obligatoire : seules les lignes qui le contiennent (cherché par BNDM) sont lues par l'automate";
+    else if(p->teddy_debut)
+        p->raison = "tout motif commence par une chaîne fixe d'une union : Teddy cherche leurs occurrences, l'automate est lu depuis chacune pour la confirmer";
+    else if(p->teddy!=NULL)
+        p->raison = "facteur obligatoire formé de chaînes fixes : seules les lignes qui contiennent l'une d'elles (cherchées par Teddy) sont lues par l'automate";
+    else if(p->nb_litteraux>1)
+        p->raison = "union de chaînes fixes trop nombreuses ou trop courtes pour Teddy : l'automate est simulé en sautant les lettres neutres";
+    else if(m->line_repos!=NULL && Classe_cardinal(&m->line_neutres)>0)
+        p->raison = "expression générale : simulation de l'automate, préfiltrée par le saut des lettres qui ne peuvent pas commencer un motif";
+    else
+        p->raison = "expression générale sans préfiltre possible (toute lettre peut commencer un motif) : simulation de l'automate";
+}
+
+/// @brief `Motif_find_next` pour la stratégie `STRATEGIE_LITTERAL`
+/// @param m
+/// @param s
+/// @param line
+/// @param size
+/// @param from
+/// @param start
+/// @param end
+/// @return
+bool find_litteral(const Motif* m,Scratch* s,const unsigned char* line,size_t size,size_t from,size_t* start,size_t* end)
+{
+    const unsigned char* litteral = m->plan.litteral;
+    size_t n = m->plan.litteral_size;
+    if(from>size || size-from<n)
+        return false;
+
+    size_t debut;
+    if(m->ancre_debut)
+    {
+        // début et fin : la ligne entière, sinon un seul motif possible au début de la ligne
+        if(from>0 || (m->ancre_fin && size!=n))
+            return false;
+        debut = 0;
+    }else if(m->ancre_fin)
+    {
+        debut = size-n;
+    }else
+    {
+        const unsigned char* p = chercher_litteral(line+from,size-from,litteral,n);
+        s->octets_lus += (p==NULL)?size-from:(size_t)(p-line)+n-from;
+        if(p==NULL)
+            return false;
+        *start = p-line;
+        *end = *start+n;
+        return true;
+    }
+
+    s->octets_lus += n;
+    if(memcmp(line+debut,litteral,n)!=0)
+        return false;
+    *start = debut;
+    *end = debut+n;
+    return true;
+}
+
+bool Motif_candidat(const Motif* m,Scratch* s,const char* data,size_t size,size_t* position)
+{
+    const unsigned char* texte = (const unsigned char*)data;
+    *position = 0;
+    switch(m->plan.strategie)
+    {
+    case STRATEGIE_LITTERAL:
+    {
+        // un motif ancré contient aussi la chaîne fixe
+        if(m->plan.litteral_size==0)
+            return true;
+        const unsigned char* trouve = chercher_litteral(texte,size,m->plan.litteral,m->plan.litteral_size);
+        if(trouve==NULL)
+            return false;
+        *position = trouve-texte;
+        return true;
+    }
+    case STRATEGIE_BNDM:
+        return Bndm_chercher(m->plan.bndm,s,texte,size,position);
+    case STRATEGIE_NFA:
+        if(m->plan.bndm!=NULL)
+            return Bndm_chercher(m->plan.bndm,s,texte,size,position);
+        if(m->plan.teddy!=NULL)
+            return Teddy_chercher(m->plan.teddy,s,texte,size,position);
+        if(m->plan.saut_neutres)
+        {
+            // les lettres neutres et les fins de ligne laissent l'automate au repos
+            size_t i = 0;
+            if(m->plan.saut.active)
+                i = Acceleration_sauter(&m->plan.saut,texte,size);
+            else
+                while(i<size && (texte[i]=='\n' || Classe_mem(&m->line_neutres,texte[i])))
+                    i++;
+            s->octets_evites += i;
+            *position = i;
+            return i<size;
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+/// @brief décrit le plan de recherche choisi pour le motif et la raison de ce choix
+/// @param m
+/// @param flux
+void Motif_explain(const Motif* m,FILE* flux)
+{
+    const Plan* p = &m->plan;
+    fprintf(flux,"arbre syntaxique : %zu noeuds (%zu avant simplification), %zu positions (lettres, classes et '.')\n",
+        p->nb_noeuds,m->nb_noeuds_initial,p->nb_positions);
+    fprintf(flux,"ancrage : %s\n",(m->ancre_debut && m->ancre_fin)?"ligne entière":m->ancre_debut?"début de ligne":m->ancre_fin?"fin de ligne":"aucun");
+    if(p->litteral!=NULL)
+    {
+        fprintf(flux,"chaîne fixe : \"");
+        fwrite(p->litteral,1,p->litteral_size,flux);
+        fprintf(flux,"\" (%zu octets)\n",p->litteral_size);
+    }else if(p->nb_litteraux>1)
+        fprintf(flux,"union de %zu chaînes fixes\n",p->nb_litteraux);
+    else
+        fprintf(flux,"chaîne fixe : non\n");
+
+    Automate* a = m->automate;
+    fprintf(flux,"automate : %zu états (%zu avant réduction), %zu transitions par classe, %zu compteurs\n",
+        a->nb_etat,m->nb_etats_initial,a->nb_classes,a->nb_compteurs);
+    // un DFA reconnaissant une chaîne fixe (ou une union de chaînes, Aho-Corasick) a au plus une position de plus que l'expression,
+    // sinon au plus un état par sous-ensemble de positions
+    if(p->nb_litteraux>0)
+        fprintf(flux,"taille estimée du DFA : %zu états\n",p->nb_positions+1);
+    else if(p->nb_positions<64)
+        fprintf(flux,"taille estimée du DFA : au plus %llu états\n",1ULL<<p->nb_positions);
+    else
+        fprintf(flux,"taille estimée du DFA : au plus 2^%zu états\n",p->nb_positions);
+    if(p->strategie==STRATEGIE_NFA && m->line_repos!=NULL)
+    {
+        fprintf(flux,"préfiltre : %zu lettres sautées tant qu'aucun motif n'est commencé\n",Classe_cardinal(&m->line_neutres));
+        if(m->line_acceleration.active)
+        {
+            fprintf(flux,"état de repos accéléré : %zu lettres de sortie cherchées directement (",m->line_acceleration.nb_sorties);
+            for(size_t i=0;i<m->line_acceleration.nb_sorties;i++)
+            {
+                unsigned char c = m->line_acceleration.sorties[i];
+                if(c>=0x20 && c<0x7f)
+                    fprintf(flux,i==0?"'%c'":", '%c'",c);
+                else
+                    fprintf(flux,i==0?"0x%02x":", 0x%02x",c);
+            }
+            fprintf(flux,")\n");
+        }
+    }
+
+    if(p->strategie==STRATEGIE_NFA && p->bndm!=NULL)
+        fprintf(flux,"facteur obligatoire : %zu positions, cherché par BNDM avant de lire l'automate\n",p->bndm->m);
+    if(p->strategie==STRATEGIE_NFA && p->teddy!=NULL)
+        fprintf(flux,"Teddy : %zu chaînes, %zu octets comparés par les masques (%s)\n",
+            p->teddy->mots.nb,p->teddy->prefixe,Teddy_jeu_nom(p->teddy->jeu));
+    if(p->sans_reduction)
+        fprintf(flux,"limite de mémoire : automates non réduits\n");
+    if(p->sans_glushkov)
+        fprintf(flux,"limite de mémoire : automate de Glushkov abandonné\n");
+    if(p->sans_prefiltre)
+        fprintf(flux,"limite de mémoire : préfiltre abandonné\n");
+    if(p->strategie==STRATEGIE_APPROCHE)
+    {
+        if(p->glushkov!=NULL)
+            fprintf(flux,"recherche approchée : %zu erreurs, %zu positions de Glushkov (répétitions dépliées)\n",m->erreurs,p->glushkov->m);
+        else
+            fprintf(flux,"recherche approchée : %zu erreurs, plus de %d positions de Glushkov\n",m->erreurs,GLUSHKOV_POSITIONS_MAX);
+    }
+    fprintf(flux,"plan : %s\n",Strategie_nom(p->strategie));
+    fprintf(flux,"raison : %s\n",p->raison);
+}
@@ -0,0 +1,455 @@
+/*
+    By Adrien Couvidat
+    réduction des automates de Thomson : chaînes d'epsilon transitions, états inutiles, numérotation en largeur
+*/
+
+#include "mygrep_interne.h"
+
+/// @brief détermine si l'état `q` ne fait que transmettre vers un unique état par epsilon transition
+/// (ni final, ni lettre, ni classe, ni compteur) : entrer dans `q` revient alors à entrer dans cet état
+/// @param a
+/// @param q
+/// @param compteur true si q est l'entrée ou la sortie d'un compteur
+/// @param source_classe true si une transition par classe part de q
+/// @param final
+/// @param suivant l'état vers lequel q transmet
+/// @return
+bool Automate_etat_relais(Automate* a,Sommet q,bool compteur,bool source_classe,bool final,Sommet* suivant)
+{
+    if(compteur || source_classe || final)
+        return false;
+    for(Lettre l=EPSILON_TRANSITION_INDEX+1;l<a->alphabet_size;l++)
+        if(a->transitions[q][l]->size>0)
+            return false;
+    ListArray* epsilon = a->transitions[q][EPSILON_TRANSITION_INDEX];
+    if(epsilon->size==0)
+        return false;
+    for(size_t i=1;i<epsilon->size;i++)
+        if(epsilon->data[i]!=epsilon->data[0])
+            return false;
+    *suivant = epsilon->data[0];
+    return *suivant!=q;
+}
+
+/// @brief arcs (source,dest) de toutes les transitions de `a`, rangés par source et par destination
+struct Arcs
+{
+    size_t nb_arcs;
+    size_t* debut_sortants;  // arcs sortants de q : sortants[debut_sortants[q]..debut_sortants[q+1][
+    Sommet* sortants;
+    size_t* debut_entrants;
+    Sommet* entrants;
+};
+typedef struct Arcs Arcs;
+
+/// @brief range les arcs donnés par `sources` et `dests` par source et par destination
+/// @param nb_etat
+/// @param sources
+/// @param dests
+/// @param nb_arcs
+/// @param arcs
+void Arcs_init(size_t nb_etat,Sommet* sources,Sommet* dests,size_t nb_arcs,Arcs* arcs)
+{
+    arcs->nb_arcs = nb_arcs;
+    arcs->debut_sortants = calloc(nb_etat+1,sizeof(size_t));
+    arcs->debut_entrants = calloc(nb_etat+1,sizeof(size_t));
+    arcs->sortants = malloc(sizeof(Sommet)*(nb_arcs+1));
+    arcs->entrants = malloc(sizeof(Sommet)*(nb_arcs+1));
+    for(size_t i=0;i<nb_arcs;i++)
+    {
+        arcs->debut_sortants[sources[i]+1]++;
+        arcs->debut_entrants[dests[i]+1]++;
+    }
+    for(size_t q=0;q<nb_etat;q++)
+    {
+        arcs->debut_sortants[q+1] += arcs->debut_sortants[q];
+        arcs->debut_entrants[q+1] += arcs->debut_entrants[q];
+    }
+    size_t* place_sortants = malloc(sizeof(size_t)*(nb_etat+1));
+    size_t* place_entrants = malloc(sizeof(size_t)*(nb_etat+1));
+    memcpy(place_sortants,arcs->debut_sortants,sizeof(size_t)*(nb_etat+1));
+    memcpy(place_entrants,arcs->debut_entrants,sizeof(size_t)*(nb_etat+1));
+    for(size_t i=0;i<nb_arcs;i++)
+    {
+        arcs->sortants[place_sortants[sources[i]]++] = dests[i];
+        arcs->entrants[place_entrants[dests[i]]++] = sources[i];
+    }
+    free(place_sortants);
+    free(place_entrants);
+}
+
+void Arcs_free(Arcs* arcs)
+{
+    free(arcs->debut_sortants);
+    free(arcs->debut_entrants);
+    free(arcs->sortants);
+    free(arcs->entrants);
+}
+
+/// @brief marque les états accessibles depuis `depart` en suivant les arcs (sortants, ou entrants si `inverse`)
+/// @param arcs
+/// @param nb_etat
+/// @param depart
+/// @param marque
+/// @param inverse
+void Arcs_parcours(Arcs* arcs,size_t nb_etat,ListArray* depart,bool* marque,bool inverse)
+{
+    Sommet* file = malloc(sizeof(Sommet)*(nb_etat+1));
+    size_t tete = 0,queue = 0;
+    for(size_t i=0;i<depart->size;i++)
+    {
+        if(!marque[depart->data[i]])
+        {
+            marque[depart->data[i]] = true;
+            file[queue++] = depart->data[i];
+        }
+    }
+    size_t* debut = inverse?arcs->debut_entrants:arcs->debut_sortants;
+    Sommet* voisins = inverse?arcs->entrants:arcs->sortants;
+    while(tete<queue)
+    {
+        Sommet q = file[tete++];
+        for(size_t i=debut[q];i<debut[q+1];i++)
+        {
+            if(!marque[voisins[i]])
+            {
+                marque[voisins[i]] = true;
+                file[queue++] = voisins[i];
+            }
+        }
+    }
+    free(file);
+}
+
+/// @brief construit un automate reconnaissant le même langage que `a`, avec moins d'états :
+/// les états qui ne font que transmettre par epsilon transition sont court-circuités,
+/// les états inaccessibles ou qui ne mènent à aucun état final sont supprimés,
+/// et les états restants sont numérotés dans l'ordre d'un parcours en largeur depuis les états initiaux
+/// @param a automate inchangé
+/// @return le nouvel automate (une copie de `a` si il ne reconnaît aucun mot)
+Automate* Automate_reduire(Automate* a)
+{
+    size_t n = a->nb_etat;
+    bool* compteur = calloc(n,sizeof(bool));
+    bool* source_classe = calloc(n,sizeof(bool));
+    bool* final = calloc(n,sizeof(bool));
+    for(size_t c=0;c<a->nb_compteurs;c++)
+        compteur[a->compteurs[c].entree] = compteur[a->compteurs[c].sortie] = true;
+    for(size_t c=0;c<a->nb_classes;c++)
+        source_classe[a->classes[c].source] = true;
+    for(size_t i=0;i<a->finaux->size;i++)
+        final[a->finaux->data[i]] = true;
+
+    // cible[q] : état dans lequel on entre à la place de q (q lui-même s'il n'est pas un relais)
+    Sommet* suivant = malloc(sizeof(Sommet)*n);
+    bool* relais = malloc(sizeof(bool)*n);
+    for(Sommet q=0;q<n;q++)
+        relais[q] = Automate_etat_relais(a,q,compteur[q],source_classe[q],final[q],&suivant[q]);
+    Sommet* cible = malloc(sizeof(Sommet)*n);
+    for(Sommet q=0;q<n;q++)
+    {
+        Sommet r = q;
+        size_t pas = 0;
+        while(relais[r] && pas<=n)
+        {
+            r = suivant[r];
+            pas++;
+        }
+        // une boucle de relais ne mène à aucun état final, elle est supprimée avec les états inutiles
+        cible[q] = (pas>n)?q:r;
+    }
+
+    // arcs de l'automate dont les destinations sont court-circuitées
+    size_t nb_arcs = a->nb_classes+a->nb_compteurs;
+    for(Sommet q=0;q<n;q++)
+        for(Lettre l=0;l<a->alphabet_size;l++)
+            nb_arcs += a->transitions[q][l]->size;
+    Sommet* sources = malloc(sizeof(Sommet)*(nb_arcs+1));
+    Sommet* dests = malloc(sizeof(Sommet)*(nb_arcs+1));
+    nb_arcs = 0;
+    for(Sommet q=0;q<n;q++)
+    {
+        if(cible[q]!=q)
+            continue;
+        for(Lettre l=0;l<a->alphabet_size;l++)
+        {
+            for(size_t i=0;i<a->transitions[q][l]->size;i++)
+            {
+                sources[nb_arcs] = q;
+                dests[nb_arcs++] = cible[a->transitions[q][l]->data[i]];
+            }
+        }
+    }
+    for(size_t c=0;c<a->nb_classes;c++)
+    {
+        sources[nb_arcs] = a->classes[c].source;
+        dests[nb_arcs++] = cible[a->classes[c].dest];
+    }
+    for(size_t c=0;c<a->nb_compteurs;c++)
+    {
+        sources[nb_arcs] = a->compteurs[c].entree;
+        dests[nb_arcs++] = cible[a->compteurs[c].sortie];
+    }
+    Arcs arcs;
+    Arcs_init(n,sources,dests,nb_arcs,&arcs);
+    free(sources);
+    free(dests);
+
+    // états utiles : accessibles depuis un état initial et co-accessibles depuis un état final
+    ListArray* initiaux = ListArray_init();
+    for(size_t i=0;i<a->initiaux->size;i++)
+        ListArray_push(initiaux,cible[a->initiaux->data[i]]);
+    bool* accessible = calloc(n,sizeof(bool));
+    bool* coaccessible = calloc(n,sizeof(bool));
+    Arcs_parcours(&arcs,n,initiaux,accessible,false);
+    Arcs_parcours(&arcs,n,a->finaux,coaccessible,true);
+    bool* utile = accessible;
+    for(Sommet q=0;q<n;q++)
+        utile[q] = accessible[q] && coaccessible[q];
+
+    // numérotation en largeur des états utiles, pour que les états lus ensemble soient proches en mémoire
+    size_t* numero = malloc(sizeof(size_t)*n);
+    for(Sommet q=0;q<n;q++)
+        numero[q] = SIZE_MAX;
+    Sommet* ordre = malloc(sizeof(Sommet)*(n+1));
+    size_t nb_utiles = 0;
+    for(size_t i=0;i<initiaux->size;i++)
+    {
+        Sommet q = initiaux->data[i];
+        if(utile[q] && numero[q]==SIZE_MAX)
+        {
+            numero[q] = nb_utiles;
+            ordre[nb_utiles++] = q;
+        }
+    }
+    for(size_t tete=0;tete<nb_utiles;tete++)
+    {
+        Sommet q = ordre[tete];
+        for(size_t i=arcs.debut_sortants[q];i<arcs.debut_sortants[q+1];i++)
+        {
+            Sommet r = arcs.sortants[i];
+            if(utile[r] && numero[r]==SIZE_MAX)
+            {
+                numero[r] = nb_utiles;
+                ordre[nb_utiles++] = r;
+            }
+        }
+    }
+
+    Automate* b;
+    if(nb_utiles==0)
+    {
+        b = Automate_copy(a);
+    }else
+    {
+        b = Automate_init(nb_utiles,a->alphabet_size);
+        // `vu[r]` vaut `marque` si r est déjà dans la liste en cours de construction
+        size_t* vu = malloc(sizeof(size_t)*nb_utiles);
+        for(size_t i=0;i<nb_utiles;i++)
+            vu[i] = SIZE_MAX;
+        size_t marque = 0;
+
+        for(size_t i=0;i<initiaux->size;i++)
+        {
+            size_t r = numero[initiaux->data[i]];
+            if(r!=SIZE_MAX && vu[r]!=marque)
+            {
+                vu[r] = marque;
+                Automate_add_etat_initial(b,r);
+            }
+        }
+        marque++;
+        for(size_t i=0;i<a->finaux->size;i++)
+        {
+            size_t r = numero[a->finaux->data[i]];
+            if(r!=SIZE_MAX && vu[r]!=marque)
+            {
+                vu[r] = marque;
+                Automate_add_etat_final(b,r);
+            }
+        }
+
+        for(size_t k=0;k<nb_utiles;k++)
+        {
+            Sommet q = ordre[k];
+            for(Lettre l=0;l<a->alphabet_size;l++)
+            {
+                marque++;
+                ListArray* liste = a->transitions[q][l];
+                for(size_t i=0;i<liste->size;i++)
+                {
+                    size_t r = numero[cible[liste->data[i]]];
+                    // une epsilon transition vers soi-même ne change pas la cloture
+                    if(r==SIZE_MAX || vu[r]==marque || (l==EPSILON_TRANSITION_INDEX && r==k))
+                        continue;
+                    vu[r] = marque;
+                    Automate_add_transition(b,k,l,r);
+                }
+            }
+        }
+        free(vu);
+
+        for(size_t c=0;c<a->nb_classes;c++)
+        {
+            TransitionClasse* t = &a->classes[c];
+            if(numero[t->source]!=SIZE_MAX && numero[cible[t->dest]]!=SIZE_MAX)
+                Automate_add_transition_classe(b,numero[t->source],&t->classe,numero[cible[t->dest]]);
+        }
+
+        // les compteurs inutiles sont supprimés, les vecteurs de bits des autres sont renumérotés
+        b->compteurs = malloc(sizeof(Compteur)*(a->nb_compteurs+1));
+        for(size_t c=0;c<a->nb_compteurs;c++)
+        {
+            Compteur k = a->compteurs[c];
+            if(numero[k.entree]==SIZE_MAX || numero[cible[k.sortie]]==SIZE_MAX)
+                continue;
+            k.entree = numero[k.entree];
+            k.sortie = numero[cible[k.sortie]];
+            k.offset = b->nb_mots_compteurs;
+            b->nb_mots_compteurs += k.nb_mots;
+            b->compteurs[b->nb_compteurs++] = k;
+        }
+    }
+
+    Arcs_free(&arcs);
+    ListArray_free(initiaux);
+    free(compteur);
+    free(source_classe);
+    free(final);
+    free(suivant);
+    free(relais);
+    free(cible);
+    free(accessible);
+    free(coaccessible);
+    free(numero);
+    free(ordre);
+    return b;
+}
+
+/// @brief empreinte d'un ensemble, indépendante de l'ordre de ses éléments
+/// @param e
+/// @return
+uint64_t Ensemble_empreinte(Ensemble* e)
+{
+    uint64_t h = e->cardinal;
+    for(size_t i=0;i<e->cardinal;i++)
+    {
+        uint64_t x = e->elements[i]+1;
+        x *= 0x9E3779B97F4A7C15ULL;
+        h += x^(x>>29);
+    }
+    return h;
+}
+
+/// @brief vérifie que deux automates sans compteur reconnaissent le même langage,
+/// en déterminisant leur produit (paires d'ensembles d'états) à la volée
+/// @note les lettres qui ne sont lues que par les mêmes classes sont confondues
+/// @param a
+/// @param b
+/// @param budget nombre maximal de paires d'ensembles explorées
+/// @return 1 si les langages sont égaux, 0 sinon, -1 si on ne peut pas conclure (compteurs ou budget dépassé)
+int Automate_equivalents(Automate* a,Automate* b,size_t budget)
+{
+    if(a->nb_compteurs>0 || b->nb_compteurs>0)
+        return -1;
+
+    // une lettre par groupe de lettres lues de la même façon
+    Lettre lettres[256];
+    size_t nb_lettres = 0;
+    for(Lettre l=0;l<256;l++)
+    {
+        bool liste = false;
+        for(size_t k=0;k<2 && !liste && l!=EPSILON_TRANSITION_INDEX;k++)
+        {
+            Automate* x = (k==0)?a:b;
+            for(Sommet q=0;q<x->nb_etat && l<x->alphabet_size && !liste;q++)
+                liste = x->transitions[q][l]->size>0;
+        }
+        bool nouvelle = true;
+        for(size_t i=0;i<nb_lettres && !liste && nouvelle;i++)
+        {
+            bool meme = true;
+            for(size_t c=0;c<a->nb_classes && meme;c++)
+                meme = Classe_mem(&a->classes[c].classe,l)==Classe_mem(&a->classes[c].classe,lettres[i]);
+            for(size_t c=0;c<b->nb_classes && meme;c++)
+                meme = Classe_mem(&b->classes[c].classe,l)==Classe_mem(&b->classes[c].classe,lettres[i]);
+            // une lettre lue par une liste de transitions est toujours seule dans son groupe
+            for(size_t k=0;k<2 && meme && lettres[i]!=EPSILON_TRANSITION_INDEX;k++)
+            {
+                Automate* x = (k==0)?a:b;
+                for(Sommet q=0;q<x->nb_etat && lettres[i]<x->alphabet_size && meme;q++)
+                    meme = x->transitions[q][lettres[i]]->size==0;
+            }
+            nouvelle = !meme;
+        }
+        if(nouvelle)
+            lettres[nb_lettres++] = l;
+    }
+
+    // paires déjà rencontrées, retrouvées par leur empreinte (adressage ouvert)
+    size_t capacite = 16;
+    while(capacite<4*budget)
+        capacite *= 2;
+    size_t* table = malloc(sizeof(size_t)*capacite);
+    for(size_t i=0;i<capacite;i++)
+        table[i] = SIZE_MAX;
+    Ensemble** paires = malloc(sizeof(Ensemble*)*2*(budget+1));
+    uint64_t* empreintes = malloc(sizeof(uint64_t)*(budget+1));
+    size_t nb_paires = 0;
+
+    paires[0] = Automate_initiaux_clos(a);
+    paires[1] = Automate_initiaux_clos(b);
+    empreintes[0] = Ensemble_empreinte(paires[0])*31+Ensemble_empreinte(paires[1]);
+    table[empreintes[0]&(capacite-1)] = 0;
+    nb_paires = 1;
+
+    Ensemble* ea = Ensemble_init(a->nb_etat);
+    Ensemble* eb = Ensemble_init(b->nb_etat);
+    int resultat = 1;
+    for(size_t p=0;p<nb_paires && resultat==1;p++)
+    {
+        if(Automate_is_final_ensemble(a,paires[2*p])!=Automate_is_final_ensemble(b,paires[2*p+1]))
+        {
+            resultat = 0;
+            break;
+        }
+        for(size_t i=0;i<nb_lettres;i++)
+        {
+            Automate_read_letter_into(a,paires[2*p],lettres[i],ea);
+            Automate_cloture_instantanee_into(a,ea);
+            Automate_read_letter_into(b,paires[2*p+1],lettres[i],eb);
+            Automate_cloture_instantanee_into(b,eb);
+
+            uint64_t h = Ensemble_empreinte(ea)*31+Ensemble_empreinte(eb);
+            size_t place = h&(capacite-1);
+            bool connue = false;
+            while(table[place]!=SIZE_MAX && !connue)
+            {
+                size_t k = table[place];
+                connue = empreintes[k]==h && Ensemble_egal(paires[2*k],ea) && Ensemble_egal(paires[2*k+1],eb);
+                place = (place+1)&(capacite-1);
+            }
+            if(connue)
+                continue;
+            if(nb_paires==budget)
+            {
+                resultat = -1;
+                break;
+            }
+            table[place] = nb_paires;
+            empreintes[nb_paires] = h;
+            paires[2*nb_paires] = Ensemble_copy(ea);
+            paires[2*nb_paires+1] = Ensemble_copy(eb);
+            nb_paires++;
+        }
+    }
+
+    Ensemble_free(ea);
+    Ensemble_free(eb);
+    for(size_t p=0;p<2*nb_paires;p++)
+        Ensemble_free(paires[p]);
+    free(paires);
+    free(empreintes);
+    free(table);
+    return resultat;
+}
@@ -0,0 +1,559 @@
+/*
+    By Adrien Couvidat
+    mode serveur (voir serveur.h)
+*/
+
+#define _GNU_SOURCE // accept4, open_memstream
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "mygrep.h"
+#include "memoire.h"
+#include "serveur.h"
+
+#ifdef SERVEUR_DISPONIBLE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/*
+    Cache LRU
+*/
+
+/// @brief instancie un cache vide
+/// @param capacity nombre de valeurs conservées
+/// @param liberer libère une valeur retirée du cache
+/// @return
+Cache* Cache_init(size_t capacity,void (*liberer)(void* valeur))
+{
+    Cache* c = malloc(sizeof(Cache));
+    c->capacity = capacity;
+    c->size = 0;
+    c->horloge = 0;
+    c->cles = malloc(sizeof(char*)*capacity);
+    c->valeurs = malloc(sizeof(void*)*capacity);
+    c->usages = malloc(sizeof(size_t)*capacity);
+    c->utilisateurs = malloc(sizeof(size_t)*capacity);
+    c->perimees = malloc(sizeof(bool)*capacity);
+    c->liberer = liberer;
+    pthread_mutex_init(&c->verrou,NULL);
+    return c;
+}
+
+/// @brief retire l'élément `i` du cache et libère sa valeur
+/// @param c
+/// @param i
+void Cache_retirer(Cache* c,size_t i)
+{
+    free(c->cles[i]);
+    c->liberer(c->valeurs[i]);
+    c->size--;
+    c->cles[i] = c->cles[c->size];
+    c->valeurs[i] = c->valeurs[c->size];
+    c->usages[i] = c->usages[c->size];
+    c->utilisateurs[i] = c->utilisateurs[c->size];
+    c->perimees[i] = c->perimees[c->size];
+}
+
+void Cache_free(Cache* c)
+{
+    while(c->size>0)
+        Cache_retirer(c,0);
+    free(c->cles);
+    free(c->valeurs);
+    free(c->usages);
+    free(c->utilisateurs);
+    free(c->perimees);
+    pthread_mutex_destroy(&c->verrou);
+    free(c);
+}
+
+/// @brief index de la valeur associée à `cle`, SIZE_MAX si il n'y en a pas
+/// @warning le verrou doit être pris
+/// @param c
+/// @param cle
+/// @return
+size_t Cache_chercher(Cache* c,const char* cle)
+{
+    for(size_t i=0;i<c->size;i++)
+        if(!c->perimees[i] && strcmp(c->cles[i],cle)==0)
+            return i;
+    return SIZE_MAX;
+}
+
+/// @brief prend la valeur associée à `cle`, qui doit ensuite être rendue avec `Cache_rendre`
+/// @param c
+/// @param cle
+/// @return la valeur, ou NULL si elle n'est pas dans le cache
+void* Cache_prendre(Cache* c,const char* cle)
+{
+    pthread_mutex_lock(&c->verrou);
+    size_t i = Cache_chercher(c,cle);
+    void* valeur = NULL;
+    if(i!=SIZE_MAX)
+    {
+        c->utilisateurs[i]++;
+        c->usages[i] = ++c->horloge;
+        valeur = c->valeurs[i];
+    }
+    pthread_mutex_unlock(&c->verrou);
+    return valeur;
+}
+
+/// @brief ajoute au cache une valeur et la prend, en oubliant la valeur inutilisée la plus ancienne si le cache est plein
+/// @param c
+/// @param cle
+/// @param valeur
+/// @return la valeur à utiliser : si un autre thread a déjà ajouté `cle`, `valeur` est libérée et la sienne est retournée
+void* Cache_ajouter(Cache* c,const char* cle,void* valeur)
+{
+    pthread_mutex_lock(&c->verrou);
+    size_t i = Cache_chercher(c,cle);
+    if(i!=SIZE_MAX)
+    {
+        c->liberer(valeur);
+        valeur = c->valeurs[i];
+    }else
+    {
+        // au-delà de la capacité ou de la limite de mémoire, les valeurs inutilisées les plus anciennes sont libérées
+        while(c->size>=c->capacity || (c->size>0 && Memoire_depassee()))
+        {
+            size_t ancienne = SIZE_MAX;
+            for(size_t j=0;j<c->size;j++)
+                if(c->utilisateurs[j]==0 && (ancienne==SIZE_MAX || c->usages[j]<c->usages[ancienne]))
+                    ancienne = j;
+            if(ancienne!=SIZE_MAX)
+            {
+                Cache_retirer(c,ancienne);
+            }else if(c->size<c->capacity)
+            {
+                break;
+            }else
+            {
+                // toutes les valeurs sont utilisées
+                c->capacity *= 2;
+                c->cles = realloc(c->cles,sizeof(char*)*c->capacity);
+                c->valeurs = realloc(c->valeurs,sizeof(void*)*c->capacity);
+                c->usages = realloc(c->usages,sizeof(size_t)*c->capacity);
+                c->utilisateurs = realloc(c->utilisateurs,sizeof(size_t)*c->capacity);
+                c->perimees = realloc(c->perimees,sizeof(bool)*c->capacity);
+            }
+        }
+        i = c->size++;
+        c->cles[i] = strdup(cle);
+        c->valeurs[i] = valeur;
+        c->utilisateurs[i] = 0;
+        c->perimees[i] = false;
+    }
+    c->utilisateurs[i]++;
+    c->usages[i] = ++c->horloge;
+    pthread_mutex_unlock(&c->verrou);
+    return valeur;
+}
+
+/// @brief rend une valeur prise avec `Cache_prendre` ou `Cache_ajouter`
+/// @note au-delà de la limite de mémoire, une valeur qui n'a plus d'utilisateur est libérée
+/// @param c
+/// @param valeur
+void Cache_rendre(Cache* c,void* valeur)
+{
+    pthread_mutex_lock(&c->verrou);
+    for(size_t i=0;i<c->size;i++)
+    {
+        if(c->valeurs[i]==valeur)
+        {
+            c->utilisateurs[i]--;
+            if((c->perimees[i] || Memoire_depassee()) && c->utilisateurs[i]==0)
+                Cache_retirer(c,i);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&c->verrou);
+}
+
+/// @brief retire du cache une valeur prise qui n'est plus à jour : elle sera libérée quand tous ses utilisateurs l'auront rendue
+/// @param c
+/// @param valeur
+void Cache_perimer(Cache* c,void* valeur)
+{
+    pthread_mutex_lock(&c->verrou);
+    for(size_t i=0;i<c->size;i++)
+        if(c->valeurs[i]==valeur)
+            c->perimees[i] = true;
+    pthread_mutex_unlock(&c->verrou);
+}
+
+/*
+    Fichiers projetés en mémoire
+*/
+
+void Corpus_free(void* valeur)
+{
+    Corpus* c = valeur;
+    if(c->size>0)
+        munmap((void*)c->data,c->size);
+    Memoire_rendre(c->size);
+    free(c);
+}
+
+/// @brief projette un fichier en mémoire
+/// @param chemin
+/// @param infos état du fichier
+/// @return NULL si le fichier ne peut pas être lu
+Corpus* Corpus_init(const char* chemin,struct stat* infos)
+{
+    int fd = open(chemin,O_RDONLY|O_CLOEXEC);
+    if(fd<0)
+        return NULL;
+    Corpus* c = malloc(sizeof(Corpus));
+    c->size = (size_t)infos->st_size;
+    c->modification = infos->st_mtim;
+    c->data = "";
+    if(c->size>0)
+    {
+        void* data = mmap(NULL,c->size,PROT_READ,MAP_SHARED,fd,0);
+        if(data==MAP_FAILED)
+        {
+            close(fd);
+            free(c);
+            return NULL;
+        }
+        madvise(data,c->size,MADV_WILLNEED);
+        c->data = data;
+    }
+    Memoire_prendre(c->size);
+    close(fd);
+
+    // une seule lecture du fichier pour savoir si il est binaire, quel que soit l'alphabet des requêtes
+    const unsigned char* octets = (const unsigned char*)c->data;
+    unsigned char octet_max = 0;
+    unsigned char octet_min = 255;
+    for(size_t i=0;i<c->size;i++)
+    {
+        octet_max = (octets[i]>octet_max)?octets[i]:octet_max;
+        octet_min = (octets[i]<octet_min)?octets[i]:octet_min;
+    }
+    c->octet_max = octet_max;
+    c->nul = c->size>0 && octet_min==0;
+    return c;
+}
+
+/// @brief détermine si le fichier contient un octet nul ou hors de l'alphabet (voir `octets_binaires`)
+/// @param c
+/// @param alphabet_size
+/// @return
+bool Corpus_binaire(const Corpus* c,size_t alphabet_size)
+{
+    unsigned char limite = (alphabet_size>255)?255:(unsigned char)(alphabet_size-1);
+    return c->nul || c->octet_max>limite;
+}
+
+/// @brief prend le fichier `chemin` projeté en mémoire, projeté à nouveau si il a été modifié depuis
+/// @param s
+/// @param chemin chemin absolu
+/// @return le fichier, à rendre avec `Cache_rendre(s->corpus,...)`, ou NULL si il ne peut pas être lu
+Corpus* Serveur_corpus(Serveur* s,const char* chemin)
+{
+    struct stat infos;
+    if(stat(chemin,&infos)!=0 || !S_ISREG(infos.st_mode))
+        return NULL;
+    Corpus* c = Cache_prendre(s->corpus,chemin);
+    if(c!=NULL && (c->size!=(size_t)infos.st_size || c->modification.tv_sec!=infos.st_mtim.tv_sec || c->modification.tv_nsec!=infos.st_mtim.tv_nsec))
+    {
+        Cache_perimer(s->corpus,c);
+        Cache_rendre(s->corpus,c);
+        c = NULL;
+    }
+    if(c==NULL)
+    {
+        c = Corpus_init(chemin,&infos);
+        if(c!=NULL)
+            c = Cache_ajouter(s->corpus,chemin,c);
+    }
+    return c;
+}
+
+/*
+    Protocole
+*/
+
+/// @brief lit exactement `size` octets de la socket
+/// @param fd
+/// @param data
+/// @param size
+/// @return false si la connexion est fermée avant
+bool lire_tout(int fd,void* data,size_t size)
+{
+    size_t lus = 0;
+    while(lus<size)
+    {
+        ssize_t n = read(fd,(char*)data+lus,size-lus);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<=0)
+            return false;
+        lus += (size_t)n;
+    }
+    return true;
+}
+
+/// @brief écrit exactement `size` octets sur la socket
+/// @param fd
+/// @param data
+/// @param size
+/// @return false si la connexion est fermée
+bool ecrire_tout(int fd,const void* data,size_t size)
+{
+    size_t ecrits = 0;
+    while(ecrits<size)
+    {
+        ssize_t n = send(fd,(const char*)data+ecrits,size-ecrits,MSG_NOSIGNAL);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<=0)
+            return false;
+        ecrits += (size_t)n;
+    }
+    return true;
+}
+
+/// @brief répond aux requêtes d'une connexion jusqu'à sa fermeture
+/// @param s
+/// @param fd
+void Serveur_connexion(Serveur* s,int fd)
+{
+    uint32_t taille;
+    while(lire_tout(fd,&taille,sizeof(taille)))
+    {
+        taille = ntohl(taille);
+        if(taille==0 || taille>SERVEUR_REQUETE_MAX)
+            break;
+        char* requete = malloc(taille+1);
+        if(!lire_tout(fd,requete,taille))
+        {
+            free(requete);
+            break;
+        }
+        requete[taille] = '\0';
+
+        // répertoire du client, puis ses arguments
+        char** argv = malloc(sizeof(char*)*(taille+1));
+        size_t argc = 0;
+        for(size_t i=0;i<taille;i+=strlen(requete+i)+1)
+            argv[argc++] = requete+i;
+
+        char* sortie_data = NULL;
+        size_t sortie_size = 0;
+        char* erreurs_data = NULL;
+        size_t erreurs_size = 0;
+        FILE* sortie = open_memstream(&sortie_data,&sortie_size);
+        FILE* erreurs = open_memstream(&erreurs_data,&erreurs_size);
+        int code = s->traitement(s,argv[0],argc-1,argv+1,sortie,erreurs);
+        fclose(sortie);
+        fclose(erreurs);
+
+        uint32_t entete[3] = {htonl((uint32_t)code),htonl((uint32_t)sortie_size),htonl((uint32_t)erreurs_size)};
+        bool ouverte = ecrire_tout(fd,entete,sizeof(entete)) && ecrire_tout(fd,sortie_data,sortie_size) && ecrire_tout(fd,erreurs_data,erreurs_size);
+        free(sortie_data);
+        free(erreurs_data);
+        free(argv);
+        free(requete);
+        if(!ouverte)
+            break;
+    }
+}
+
+/// @brief boucle d'un thread travailleur : traite les connexions de la file
+/// @param arg le serveur
+/// @return
+void* Serveur_travailleur(void* arg)
+{
+    Serveur* s = arg;
+    while(true)
+    {
+        pthread_mutex_lock(&s->verrou);
+        while(s->en_attente==0)
+            pthread_cond_wait(&s->changement,&s->verrou);
+        int client = s->clients[s->tete];
+        s->tete = (s->tete+1)%s->capacity;
+        s->en_attente--;
+        pthread_cond_broadcast(&s->changement);
+        pthread_mutex_unlock(&s->verrou);
+
+        Serveur_connexion(s,client);
+        close(client);
+    }
+    return NULL;
+}
+
+void liberer_motif(void* m)
+{
+    Motif_free(m);
+}
+
+/// @brief ouvre la socket `chemin` et répond aux requêtes, sans jamais terminer
+/// @param chemin
+/// @param nb_travailleurs nombre de requêtes traitées à la fois
+/// @param traitement
+/// @return 1 si le serveur n'a pas pu démarrer
+int Serveur_executer(const char* chemin,size_t nb_travailleurs,Traitement traitement)
+{
+    struct sockaddr_un adresse;
+    memset(&adresse,0,sizeof(adresse));
+    adresse.sun_family = AF_UNIX;
+    if(strlen(chemin)>=sizeof(adresse.sun_path))
+    {
+        fprintf(stderr,"Chemin de socket trop long : %s\n",chemin);
+        return 1;
+    }
+    strcpy(adresse.sun_path,chemin);
+
+    // la socket laissée par un serveur précédent est remplacée, jamais un autre fichier
+    struct stat infos;
+    if(stat(chemin,&infos)==0)
+    {
+        if(!S_ISSOCK(infos.st_mode))
+        {
+            fprintf(stderr,"%s existe et n'est pas une socket !\n",chemin);
+            return 1;
+        }
+        unlink(chemin);
+    }
+
+    int fd = socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+    if(fd<0 || bind(fd,(struct sockaddr*)&adresse,sizeof(adresse))!=0 || listen(fd,SOMAXCONN)!=0)
+    {
+        fprintf(stderr,"Impossible d'ouvrir la socket %s : %s\n",chemin,strerror(errno));
+        if(fd>=0)
+            close(fd);
+        return 1;
+    }
+    signal(SIGPIPE,SIG_IGN);
+
+    Serveur* s = malloc(sizeof(Serveur));
+    s->fd = fd;
+    s->traitement = traitement;
+    s->motifs = Cache_init(CACHE_MOTIFS,liberer_motif);
+    s->corpus = Cache_init(CACHE_CORPUS,Corpus_free);
+    s->nb_travailleurs = (nb_travailleurs==0)?1:nb_travailleurs;
+    s->capacity = 16*s->nb_travailleurs;
+    s->clients = malloc(sizeof(int)*s->capacity);
+    s->tete = 0;
+    s->en_attente = 0;
+    pthread_mutex_init(&s->verrou,NULL);
+    pthread_cond_init(&s->changement,NULL);
+    s->travailleurs = malloc(sizeof(pthread_t)*s->nb_travailleurs);
+    for(size_t i=0;i<s->nb_travailleurs;i++)
+    {
+        if(pthread_create(&s->travailleurs[i],NULL,Serveur_travailleur,s)!=0)
+        {
+            fprintf(stderr,"Impossible de créer les threads du serveur !\n");
+            exit(1);
+        }
+    }
+
+    while(true)
+    {
+        int client = accept4(s->fd,NULL,NULL,SOCK_CLOEXEC);
+        if(client<0)
+        {
+            if(errno==EINTR || errno==ECONNABORTED || errno==EMFILE || errno==ENFILE)
+                continue;
+            fprintf(stderr,"Erreur du serveur : %s\n",strerror(errno));
+            exit(1);
+        }
+        pthread_mutex_lock(&s->verrou);
+        while(s->en_attente==s->capacity)
+            pthread_cond_wait(&s->changement,&s->verrou);
+        s->clients[(s->tete+s->en_attente)%s->capacity] = client;
+        s->en_attente++;
+        pthread_cond_broadcast(&s->changement);
+        pthread_mutex_unlock(&s->verrou);
+    }
+    return 1;
+}
+
+/*
+    Client
+*/
+
+/// @brief recopie `size` octets de la socket dans `flux`
+/// @param fd
+/// @param size
+/// @param flux
+/// @return false si la connexion est fermée avant
+bool recopier(int fd,size_t size,FILE* flux)
+{
+    char bloc[64*1024];
+    while(size>0)
+    {
+        size_t n = (size<sizeof(bloc))?size:sizeof(bloc);
+        if(!lire_tout(fd,bloc,n))
+            return false;
+        fwrite(bloc,1,n,flux);
+        size -= n;
+    }
+    return true;
+}
+
+/// @brief envoie une requête au serveur et affiche sa réponse (--client)
+/// @param chemin socket du serveur
+/// @param argc
+/// @param argv arguments de la requête, comme pour la ligne de commande
+/// @return le code de retour de la requête
+int Client_executer(const char* chemin,size_t argc,char** argv)
+{
+    struct sockaddr_un adresse;
+    memset(&adresse,0,sizeof(adresse));
+    adresse.sun_family = AF_UNIX;
+    char repertoire[PATH_MAX];
+    if(strlen(chemin)>=sizeof(adresse.sun_path) || getcwd(repertoire,sizeof(repertoire))==NULL)
+    {
+        fprintf(stderr,"Chemin trop long : %s\n",chemin);
+        return 1;
+    }
+    strcpy(adresse.sun_path,chemin);
+    int fd = socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+    if(fd<0 || connect(fd,(struct sockaddr*)&adresse,sizeof(adresse))!=0)
+    {
+        fprintf(stderr,"Impossible de joindre le serveur %s : %s\n",chemin,strerror(errno));
+        if(fd>=0)
+            close(fd);
+        return 1;
+    }
+
+    size_t taille = strlen(repertoire)+1;
+    for(size_t i=0;i<argc;i++)
+        taille += strlen(argv[i])+1;
+    char* requete = malloc(sizeof(uint32_t)+taille);
+    uint32_t entete = htonl((uint32_t)taille);
+    memcpy(requete,&entete,sizeof(entete));
+    char* fin = requete+sizeof(entete);
+    fin = stpcpy(fin,repertoire)+1;
+    for(size_t i=0;i<argc;i++)
+        fin = stpcpy(fin,argv[i])+1;
+
+    uint32_t reponse[3];
+    int code = 1;
+    if(taille>SERVEUR_REQUETE_MAX)
+        fprintf(stderr,"Requête trop longue !\n");
+    else if(!ecrire_tout(fd,requete,sizeof(entete)+taille) || !lire_tout(fd,reponse,sizeof(reponse))
+        || !recopier(fd,ntohl(reponse[1]),stdout) || !recopier(fd,ntohl(reponse[2]),stderr))
+        fprintf(stderr,"Connexion au serveur interrompue !\n");
+    else
+        code = (int)ntohl(reponse[0]);
+    free(requete);
+    close(fd);
+    return code;
+}
+
+#endif // SERVEUR_DISPONIBLE
@@ -0,0 +1,105 @@
+/*
+    By Adrien Couvidat
+    mode serveur (--serve) : un processus résident répond aux recherches envoyées sur une socket Unix,
+    en gardant les motifs compilés et les fichiers projetés en mémoire d'une requête à l'autre
+
+    protocole (entiers de 32 bits dans l'ordre réseau) :
+        requête : taille, puis le répertoire courant du client et ses arguments, chacun terminé par '\0'
+        réponse : code de retour, taille de la sortie, taille des erreurs, puis la sortie et les erreurs
+    une connexion peut envoyer plusieurs requêtes à la suite
+*/
+
+#ifndef SERVEUR_H
+#define SERVEUR_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#define SERVEUR_DISPONIBLE // sockets Unix et threads POSIX disponibles
+#endif
+
+#define SERVEUR_TRAVAILLEURS 4          // threads qui traitent les requêtes, par défaut
+#define SERVEUR_REQUETE_MAX (1024*1024) // taille maximale d'une requête
+#define CACHE_MOTIFS 256                // motifs compilés conservés
+#define CACHE_CORPUS 64                 // fichiers projetés en mémoire conservés
+
+#ifdef SERVEUR_DISPONIBLE
+
+/// @brief cache des valeurs les plus récemment utilisées (LRU), partagé entre threads
+/// une valeur prise par un thread n'est jamais libérée avant d'avoir été rendue
+struct Cache
+{
+    char** cles;
+    void** valeurs;
+    size_t* usages;         // date de la dernière utilisation (horloge du cache)
+    size_t* utilisateurs;   // nombre de threads qui utilisent la valeur
+    bool* perimees;         // valeurs qui ne sont plus trouvées, libérées dès qu'elles sont rendues
+    size_t size;
+    size_t capacity;        // dépassée seulement si toutes les valeurs sont utilisées
+    size_t horloge;
+    void (*liberer)(void* valeur);
+    pthread_mutex_t verrou;
+};
+typedef struct Cache Cache;
+
+Cache* Cache_init(size_t capacity,void (*liberer)(void* valeur));
+void Cache_free(Cache* c);
+void* Cache_prendre(Cache* c,const char* cle);
+void* Cache_ajouter(Cache* c,const char* cle,void* valeur);
+void Cache_rendre(Cache* c,void* valeur);
+void Cache_perimer(Cache* c,void* valeur);
+
+/// @brief fichier projeté en mémoire
+struct Corpus
+{
+    const char* data;
+    size_t size;
+    struct timespec modification; // le fichier est projeté à nouveau si il a été modifié
+    bool nul;                   // le fichier contient un octet nul
+    unsigned char octet_max;    // plus grand octet du fichier (voir `octets_binaires`)
+};
+typedef struct Corpus Corpus;
+
+struct Serveur;
+
+/// @brief traite une requête
+/// @param s
+/// @param repertoire répertoire courant du client (les noms de fichiers relatifs en partent)
+/// @param argc
+/// @param argv arguments de la ligne de commande du client
+/// @param sortie
+/// @param erreurs
+/// @return le code de retour de la requête
+typedef int (*Traitement)(struct Serveur* s,const char* repertoire,size_t argc,char** argv,FILE* sortie,FILE* erreurs);
+
+/// @brief serveur : les connexions acceptées forment une file, lue par les threads travailleurs
+struct Serveur
+{
+    int fd;
+    Traitement traitement;
+    Cache* motifs;
+    Cache* corpus;
+    int* clients;           // file circulaire des connexions en attente
+    size_t tete;
+    size_t en_attente;
+    size_t capacity;
+    size_t nb_travailleurs;
+    pthread_t* travailleurs;
+    pthread_mutex_t verrou;
+    pthread_cond_t changement;
+};
+typedef struct Serveur Serveur;
+
+int Serveur_executer(const char* chemin,size_t nb_travailleurs,Traitement traitement);
+Corpus* Serveur_corpus(Serveur* s,const char* chemin);
+bool Corpus_binaire(const Corpus* c,size_t alphabet_size);
+
+int Client_executer(const char* chemin,size_t argc,char** argv);
+
+#endif // SERVEUR_DISPONIBLE
+
+#endif // SERVEUR_H
@@ -0,0 +1,272 @@
+/*
+    By Adrien Couvidat
+    simplification algébrique de l'arbre syntaxique avant la construction des automates
+    (chaque réécriture conserve le langage reconnu, donc les motifs trouvés)
+*/
+
+#include "mygrep_interne.h"
+
+/// @brief détermine si deux arbres sont identiques
+/// @param a
+/// @param b
+/// @return
+bool Tree_egal(Tree* a,Tree* b)
+{
+    if(a==NULL || b==NULL)
+        return a==b;
+    if(a->etiquette!=b->etiquette)
+        return false;
+    if(a->etiquette==SYNTAXE_OPERATOR_REPETITION && (a->min!=b->min || a->max!=b->max))
+        return false;
+    if(a->etiquette==SYNTAXE_OPERATOR_CLASSE && memcmp(a->classe.bits,b->classe.bits,sizeof(a->classe.bits))!=0)
+        return false;
+    return Tree_egal(a->left_chilfren,b->left_chilfren) && Tree_egal(a->right_children,b->right_children);
+}
+
+/// @brief ajoute à `elements` les opérandes successifs des opérateurs `operateur` de l'arbre
+/// (les feuilles de la concaténation abc ou les branches de l'union a|b|c), et libère les noeuds de ces opérateurs
+/// @param tree
+/// @param operateur SYNTAXE_OPERATOR_CONCATENATION ou SYNTAXE_OPERATOR_UNION
+/// @param elements tableau d'au moins `Tree_nb_noeuds(tree)` cases
+/// @param size
+void Tree_operandes(Tree* tree,Lettre operateur,Tree** elements,size_t* size)
+{
+    if(tree->etiquette==operateur && tree->left_chilfren!=NULL)
+    {
+        Tree_operandes(tree->left_chilfren,operateur,elements,size);
+        Tree_operandes(tree->right_children,operateur,elements,size);
+        free(tree);
+        return;
+    }
+    elements[(*size)++] = tree;
+}
+
+/// @brief reconstruit l'arbre a op b op c ... à partir de ses opérandes (inverse de `Tree_operandes`)
+/// @param operateur
+/// @param elements
+/// @param size au moins 1
+/// @return
+Tree* Tree_operation(Lettre operateur,Tree** elements,size_t size)
+{
+    Tree* t = elements[0];
+    for(size_t i=1;i<size;i++)
+        t = Tree_init(operateur,t,elements[i]);
+    return t;
+}
+
+/// @brief factorise les branches d'une union qui commencent par le même opérande : abc|abd -> ab(c|d)
+/// @param branches branches de l'union, libérées ou réutilisées
+/// @param nb_branches
+/// @param alphabet_size
+/// @return l'union factorisée
+Tree* Tree_factoriser(Tree** branches,size_t nb_branches,size_t alphabet_size)
+{
+    // chaque branche est décomposée en la suite de ses opérandes de concaténation
+    Tree*** suites = malloc(sizeof(Tree**)*nb_branches);
+    size_t* tailles = malloc(sizeof(size_t)*nb_branches);
+    bool* utilisee = calloc(nb_branches,sizeof(bool));
+    for(size_t i=0;i<nb_branches;i++)
+    {
+        suites[i] = malloc(sizeof(Tree*)*Tree_nb_noeuds(branches[i]));
+        tailles[i] = 0;
+        Tree_operandes(branches[i],SYNTAXE_OPERATOR_CONCATENATION,suites[i],&tailles[i]);
+    }
+
+    Tree** resultat = calloc(nb_branches,sizeof(Tree*)); // calloc : -O2 ne sait pas que nb_resultat>0 à la fin
+    size_t nb_resultat = 0;
+    size_t* groupe = malloc(sizeof(size_t)*nb_branches);
+    for(size_t i=0;i<nb_branches;i++)
+    {
+        if(utilisee[i])
+            continue;
+
+        // branches qui commencent comme la branche i
+        size_t nb_groupe = 0;
+        for(size_t j=i;j<nb_branches;j++)
+        {
+            if(!utilisee[j] && Tree_egal(suites[i][0],suites[j][0]))
+            {
+                groupe[nb_groupe++] = j;
+                utilisee[j] = true;
+            }
+        }
+        if(nb_groupe==1)
+        {
+            resultat[nb_resultat++] = Tree_operation(SYNTAXE_OPERATOR_CONCATENATION,suites[i],tailles[i]);
+            continue;
+        }
+
+        // plus long préfixe commun au groupe
+        size_t prefixe = 1;
+        bool commun = true;
+        while(commun)
+        {
+            for(size_t k=0;k<nb_groupe && commun;k++)
+                commun = tailles[groupe[k]]>prefixe && Tree_egal(suites[i][prefixe],suites[groupe[k]][prefixe]);
+            if(commun)
+                prefixe++;
+        }
+
+        // préfixe gardé une seule fois, les restes forment une nouvelle union (éventuellement vide : le reste devient optionnel)
+        Tree** restes = malloc(sizeof(Tree*)*nb_groupe);
+        size_t nb_restes = 0;
+        bool vide = false;
+        for(size_t k=0;k<nb_groupe;k++)
+        {
+            size_t b = groupe[k];
+            if(b!=i)
+                for(size_t l=0;l<prefixe;l++)
+                    Tree_free(suites[b][l]);
+            if(tailles[b]==prefixe)
+                vide = true;
+            else
+                restes[nb_restes++] = Tree_operation(SYNTAXE_OPERATOR_CONCATENATION,suites[b]+prefixe,tailles[b]-prefixe);
+        }
+        Tree* suite = Tree_operation(SYNTAXE_OPERATOR_CONCATENATION,suites[i],prefixe);
+        if(nb_restes>0)
+        {
+            Tree* reste = Tree_simplifier(Tree_operation(SYNTAXE_OPERATOR_UNION,restes,nb_restes),alphabet_size);
+            if(vide)
+                reste = Tree_simplifier(Tree_init(SYNTAXE_OPERATOR_JOKER,reste,NULL),alphabet_size);
+            suite = Tree_init(SYNTAXE_OPERATOR_CONCATENATION,suite,reste);
+        }
+        free(restes);
+        resultat[nb_resultat++] = suite;
+    }
+
+    Tree* t = Tree_operation(SYNTAXE_OPERATOR_UNION,resultat,nb_resultat);
+    for(size_t i=0;i<nb_branches;i++)
+        free(suites[i]);
+    free(suites);
+    free(tailles);
+    free(utilisee);
+    free(groupe);
+    free(resultat);
+    return t;
+}
+
+/// @brief simplifie une union : branches en double supprimées, branches d'une seule lettre réunies en une classe,
+/// branches de même début factorisées
+/// @param tree union dont les branches sont déjà simplifiées
+/// @param alphabet_size
+/// @return
+Tree* Tree_simplifier_union(Tree* tree,size_t alphabet_size)
+{
+    Tree** branches = malloc(sizeof(Tree*)*Tree_nb_noeuds(tree));
+    size_t nb_branches = 0;
+    Tree_operandes(tree,SYNTAXE_OPERATOR_UNION,branches,&nb_branches);
+
+    // (a|a) -> a
+    size_t n = 0;
+    for(size_t i=0;i<nb_branches;i++)
+    {
+        bool double_ = false;
+        for(size_t j=0;j<n && !double_;j++)
+            double_ = Tree_egal(branches[j],branches[i]);
+        if(double_)
+            Tree_free(branches[i]);
+        else
+            branches[n++] = branches[i];
+    }
+    nb_branches = n;
+
+    Tree* t = Tree_factoriser(branches,nb_branches,alphabet_size);
+    free(branches);
+
+    // a|b|[c-e] -> [a-e], après la factorisation pour que a|ab reste a(b)?
+    branches = malloc(sizeof(Tree*)*Tree_nb_noeuds(t));
+    nb_branches = 0;
+    Tree_operandes(t,SYNTAXE_OPERATOR_UNION,branches,&nb_branches);
+    Classe lettres;
+    Classe_clear(&lettres);
+    size_t nb_lettres = 0;
+    for(size_t i=0;i<nb_branches;i++)
+    {
+        Classe c;
+        Classe_clear(&c);
+        if(branches[i]->left_chilfren==NULL && Tree_classe(branches[i],&c,alphabet_size))
+            nb_lettres++;
+    }
+    if(nb_lettres>=2)
+    {
+        n = 0;
+        for(size_t i=0;i<nb_branches;i++)
+        {
+            Classe c;
+            Classe_clear(&c);
+            if(branches[i]->left_chilfren==NULL && Tree_classe(branches[i],&c,alphabet_size))
+            {
+                Classe_union(&lettres,&c);
+                Tree_free(branches[i]);
+            }else
+                branches[n++] = branches[i];
+        }
+        Tree* classe = Tree_init(SYNTAXE_OPERATOR_CLASSE,NULL,NULL);
+        classe->classe = lettres;
+        branches[n++] = classe;
+        nb_branches = n;
+    }
+    t = Tree_operation(SYNTAXE_OPERATOR_UNION,branches,nb_branches);
+    free(branches);
+    return t;
+}
+
+/// @brief réécrit l'arbre sous une forme équivalente plus petite
+/// (a*)* -> a*, (a?)* -> a*, (a*)? -> a*, a{1} -> a, (a|a) -> a, abc|abd -> ab[cd], a|b|c -> [abc]
+/// @param tree arbre libéré ou réutilisé
+/// @param alphabet_size
+/// @return l'arbre simplifié
+Tree* Tree_simplifier(Tree* tree,size_t alphabet_size)
+{
+    if(tree==NULL || tree->left_chilfren==NULL)
+        return tree;
+
+    tree->left_chilfren = Tree_simplifier(tree->left_chilfren,alphabet_size);
+    if(tree->right_children!=NULL)
+        tree->right_children = Tree_simplifier(tree->right_children,alphabet_size);
+    Tree* fils = tree->left_chilfren;
+
+    switch(tree->etiquette)
+    {
+    case SYNTAXE_OPERATOR_ETOILE:
+        // (e*)* -> e*
+        if(fils->etiquette==SYNTAXE_OPERATOR_ETOILE)
+        {
+            free(tree);
+            return fils;
+        }
+        // (e?)* -> e*, (e{0,m})* et (e{1,m})* -> e*
+        if(fils->etiquette==SYNTAXE_OPERATOR_JOKER || (fils->etiquette==SYNTAXE_OPERATOR_REPETITION && fils->min<=1 && fils->max>=1))
+        {
+            tree->left_chilfren = fils->left_chilfren;
+            free(fils);
+            return Tree_simplifier(tree,alphabet_size);
+        }
+        break;
+    case SYNTAXE_OPERATOR_JOKER:
+        // (e*)? -> e*, (e?)? -> e?, (e{0,m})? -> e{0,m}
+        if(fils->etiquette==SYNTAXE_OPERATOR_ETOILE || fils->etiquette==SYNTAXE_OPERATOR_JOKER
+            || (fils->etiquette==SYNTAXE_OPERATOR_REPETITION && fils->min==0))
+        {
+            free(tree);
+            return fils;
+        }
+        break;
+    case SYNTAXE_OPERATOR_REPETITION:
+        // e{1} -> e, e{0,} -> e*, e{0,1} -> e?
+        if(tree->min==1 && tree->max==1)
+        {
+            free(tree);
+            return fils;
+        }
+        if(tree->min==0 && (tree->max==REPETITION_INFINIE || tree->max==1))
+        {
+            tree->etiquette = (tree->max==1)?SYNTAXE_OPERATOR_JOKER:SYNTAXE_OPERATOR_ETOILE;
+            return Tree_simplifier(tree,alphabet_size);
+        }
+        break;
+    case SYNTAXE_OPERATOR_UNION:
+        return Tree_simplifier_union(tree,alphabet_size);
+    }
+    return tree;
+}
@@ -0,0 +1,237 @@
+/*
+    By Adrien Couvidat
+    écriture de la sortie par grands blocs (voir sortie.h)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SORTIE_SSE2
+#endif
+
+#include "mygrep.h"
+#include "memoire.h"
+#include "sortie.h"
+#include "mesures.h"
+#include "trace.h"
+
+/// @brief instancie un tampon de sortie vers `flux`
+/// @param flux
+/// @return
+Sortie* Sortie_init(FILE* flux)
+{
+    Sortie* s = malloc(sizeof(Sortie));
+    s->flux = flux;
+    s->capacity = SORTIE_CAPACITE;
+    s->data = malloc(s->capacity);
+    Memoire_prendre(s->capacity);
+    s->size = 0;
+    s->mesures = NULL;
+    return s;
+}
+
+/// @brief écrit le contenu du tampon puis le libère
+/// @param s
+void Sortie_free(Sortie* s)
+{
+    if(s==NULL)
+        return;
+    Sortie_flush(s);
+    free(s->data);
+    Memoire_rendre(s->capacity);
+    free(s);
+}
+
+/// @brief écrit le contenu du tampon dans le flux
+/// @param s
+void Sortie_flush(Sortie* s)
+{
+    enum PHASE phase = PHASE_SORTIE;
+    if(s->mesures!=NULL && s->size>0)
+        phase = Mesures_phase(s->mesures,PHASE_SORTIE);
+    uint64_t trace = Trace_maintenant();
+    size_t size = s->size;
+    if(s->size>0)
+        fwrite(s->data,1,s->size,s->flux);
+    s->size = 0;
+    fflush(s->flux);
+    if(size>0)
+        Trace_intervalle("écriture",trace,size);
+    if(s->mesures!=NULL && phase!=PHASE_SORTIE)
+        Mesures_phase(s->mesures,phase);
+}
+
+/// @brief ajoute `size` octets au tampon
+/// @param s
+/// @param data
+/// @param size
+void Sortie_ecrire(Sortie* s,const char* data,size_t size)
+{
+    if(s->size+size>s->capacity)
+    {
+        Sortie_flush(s);
+        if(size>s->capacity)
+        {
+            // trop grand pour le tampon : écrit directement
+            fwrite(data,1,size,s->flux);
+            return;
+        }
+    }
+    memcpy(s->data+s->size,data,size);
+    s->size += size;
+}
+
+void Sortie_caractere(Sortie* s,char c)
+{
+    if(s->size==s->capacity)
+        Sortie_flush(s);
+    s->data[s->size++] = c;
+}
+
+void Sortie_chaine(Sortie* s,const char* chaine)
+{
+    Sortie_ecrire(s,chaine,strlen(chaine));
+}
+
+/// @brief écrit un entier en base 10
+/// @param s
+/// @param n
+void Sortie_nombre(Sortie* s,size_t n)
+{
+    char chiffres[32];
+    size_t i = sizeof(chiffres);
+    do
+    {
+        chiffres[--i] = (char)('0'+n%10);
+        n /= 10;
+    } while (n>0);
+    Sortie_ecrire(s,chiffres+i,sizeof(chiffres)-i);
+}
+
+/// @brief nombre d'octets en tête de `data` qui s'écrivent tels quels dans une chaîne JSON
+/// (ni '"', ni '\\', ni caractère de contrôle, ni octet >= 0x80 dont la séquence UTF-8 doit être vérifiée)
+/// @note 16 octets par comparaison avec SSE2
+/// @param data
+/// @param size
+/// @return
+size_t json_octets_simples(const unsigned char* data,size_t size)
+{
+    size_t i = 0;
+#ifdef SORTIE_SSE2
+    __m128i guillemet = _mm_set1_epi8('"');
+    __m128i barre = _mm_set1_epi8('\\');
+    __m128i controle = _mm_set1_epi8(0x1f);
+    for(;i+16<=size;i+=16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data+i));
+        // x<=0x1f <=> min(x,0x1f)==x
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x,guillemet),_mm_cmpeq_epi8(x,barre)),
+                                       _mm_cmpeq_epi8(_mm_min_epu8(x,controle),x));
+        int masque = _mm_movemask_epi8(_mm_or_si128(special,x));
+        if(masque!=0)
+        {
+#ifdef __GNUC__
+            return i+__builtin_ctz(masque);
+#else
+            size_t k = 0;
+            while(!((masque>>k)&1))
+                k++;
+            return i+k;
+#endif
+        }
+    }
+#endif
+    for(;i<size;i++)
+        if(data[i]=='"' || data[i]=='\\' || data[i]<0x20 || data[i]>=0x80)
+            return i;
+    return size;
+}
+
+/// @brief longueur de la séquence UTF-8 valide qui commence `data` (RFC 3629 : ni forme trop longue,
+/// ni demi-code d'indirection U+D800-U+DFFF, au plus U+10FFFF)
+/// @param data
+/// @param size
+/// @return 0 si `data[0]` ne commence pas une séquence valide
+size_t utf8_sequence(const unsigned char* data,size_t size)
+{
+    unsigned char c = data[0];
+    unsigned char bas = 0x80;   // bornes du deuxième octet
+    unsigned char haut = 0xbf;
+    size_t n;
+    if(c>=0xc2 && c<=0xdf)
+    {
+        n = 2;
+    }else if(c>=0xe0 && c<=0xef)
+    {
+        n = 3;
+        if(c==0xe0)
+            bas = 0xa0;
+        else if(c==0xed)
+            haut = 0x9f;
+    }else if(c>=0xf0 && c<=0xf4)
+    {
+        n = 4;
+        if(c==0xf0)
+            bas = 0x90;
+        else if(c==0xf4)
+            haut = 0x8f;
+    }else
+    {
+        return 0;
+    }
+    if(size<n || data[1]<bas || data[1]>haut)
+        return 0;
+    for(size_t k=2;k<n;k++)
+        if(data[k]<0x80 || data[k]>0xbf)
+            return 0;
+    return n;
+}
+
+/// @brief écrit `data` comme une chaîne JSON entre guillemets, toujours en UTF-8 valide :
+/// les séquences UTF-8 valides sont écrites telles quelles, un autre octet X >= 0x80 est écrit \u00XX
+/// (le caractère Latin-1 de même code : "caf\xe9" devient "caf\u00e9")
+/// @param s
+/// @param data
+/// @param size
+void Sortie_json(Sortie* s,const char* data,size_t size)
+{
+    static const char hexa[] = "0123456789abcdef";
+    Sortie_caractere(s,'"');
+    size_t i = 0;
+    while(i<size)
+    {
+        size_t n = json_octets_simples((const unsigned char*)data+i,size-i);
+        Sortie_ecrire(s,data+i,n);
+        i += n;
+        if(i==size)
+            break;
+
+        unsigned char c = (unsigned char)data[i++];
+        if(c>=0x80)
+        {
+            size_t n = utf8_sequence((const unsigned char*)data+i-1,size-i+1);
+            if(n>0)
+            {
+                Sortie_ecrire(s,data+i-1,n);
+                i += n-1;
+                continue;
+            }
+        }
+        switch(c)
+        {
+        case '"': Sortie_ecrire(s,"\\\"",2); break;
+        case '\\': Sortie_ecrire(s,"\\\\",2); break;
+        case '\n': Sortie_ecrire(s,"\\n",2); break;
+        case '\r': Sortie_ecrire(s,"\\r",2); break;
+        case '\t': Sortie_ecrire(s,"\\t",2); break;
+        default:
+        {
+            char code[6] = {'\\','u','0','0',hexa[c>>4],hexa[c&15]};
+            Sortie_ecrire(s,code,6);
+        }
+        }
+    }
+    Sortie_caractere(s,'"');
+}
@@ -0,0 +1,35 @@
+/*
+    By Adrien Couvidat
+    écriture de la sortie par grands blocs, et chaînes JSON
+*/
+
+#ifndef SORTIE_H
+#define SORTIE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SORTIE_CAPACITE (1024*1024) // octets accumulés avant chaque écriture
+
+/// @brief tampon de sortie : les lignes affichées sont accumulées puis écrites en un seul appel
+struct Sortie
+{
+    FILE* flux;
+    char* data;
+    size_t size;
+    size_t capacity;
+    struct Mesures* mesures; // --perf-counters : les écritures sont comptées dans la phase de sortie, ou NULL
+};
+typedef struct Sortie Sortie;
+
+Sortie* Sortie_init(FILE* flux);
+void Sortie_free(Sortie* s);
+void Sortie_flush(Sortie* s);
+void Sortie_ecrire(Sortie* s,const char* data,size_t size);
+void Sortie_caractere(Sortie* s,char c);
+void Sortie_chaine(Sortie* s,const char* chaine);
+void Sortie_nombre(Sortie* s,size_t n);
+void Sortie_json(Sortie* s,const char* data,size_t size);
+
+#endif // SORTIE_H
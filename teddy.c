@@ -0,0 +1,426 @@
+/*
+    By Adrien Couvidat
+    recherche Teddy d'un ensemble de chaînes fixes courtes (unions de l'arbre syntaxique) :
+    les chaînes sont rangées dans 8 seaux (un bit chacun), et pour chacun des premiers octets des chaînes,
+    deux tables de 16 octets donnent les seaux compatibles avec son quartet bas et son quartet haut ;
+    16 (SSSE3) ou 32 (AVX2) positions sont testées à la fois avec pshufb, et seules les chaînes des seaux
+    restants sont comparées (memcmp). Le jeu d'instructions est choisi à l'exécution, avec une version scalaire sinon
+*/
+
+#include "mygrep_interne.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TEDDY_X86 // SSSE3 et AVX2 compilés avec l'attribut target, utilisés si le processeur les a
+#endif
+
+/// @brief libère les mots de l'ensemble et le vide
+/// @param mots
+void Mots_free(Mots* mots)
+{
+    for(size_t i=0;i<mots->nb;i++)
+        free(mots->mots[i]);
+    mots->nb = 0;
+}
+
+/// @brief ajoute à `dest` la concaténation des mots `a` et `b`
+/// @param dest
+/// @param a
+/// @param a_size
+/// @param b
+/// @param b_size
+void Mots_ajouter(Mots* dest,const unsigned char* a,size_t a_size,const unsigned char* b,size_t b_size)
+{
+    unsigned char* mot = malloc(a_size+b_size+1);
+    if(a_size>0)
+        memcpy(mot,a,a_size);
+    if(b_size>0)
+        memcpy(mot+a_size,b,b_size);
+    dest->mots[dest->nb] = mot;
+    dest->tailles[dest->nb] = a_size+b_size;
+    dest->nb++;
+}
+
+/// @brief remplace `dest` par les concaténations d'un mot de `dest` et d'un mot de `suite`
+/// @param dest
+/// @param suite
+/// @return false si il y aurait plus de TEDDY_MOTS_MAX mots (`dest` est alors inchangé)
+bool Mots_concatener(Mots* dest,const Mots* suite)
+{
+    if(dest->nb*suite->nb>TEDDY_MOTS_MAX)
+        return false;
+    Mots produit;
+    produit.nb = 0;
+    for(size_t i=0;i<dest->nb;i++)
+        for(size_t j=0;j<suite->nb;j++)
+            Mots_ajouter(&produit,dest->mots[i],dest->tailles[i],suite->mots[j],suite->tailles[j]);
+    Mots_free(dest);
+    *dest = produit;
+    return true;
+}
+
+/// @brief longueur du mot le plus court
+/// @param mots au moins un mot
+/// @return
+size_t Mots_taille_min(const Mots* mots)
+{
+    size_t min = mots->tailles[0];
+    for(size_t i=1;i<mots->nb;i++)
+        if(mots->tailles[i]<min)
+            min = mots->tailles[i];
+    return min;
+}
+
+/// @brief énumère les mots lus par l'arbre, si il n'en lit qu'un nombre fini (lettres, classes, concaténations, unions et '?')
+/// @param tree arbre sans ancre
+/// @param alphabet_size les lettres hors de l'alphabet ne sont reconnues par aucun automate
+/// @param dest ensemble vide, rempli par les mots de l'arbre (le mot vide compris)
+/// @return false si l'arbre lit plus de TEDDY_MOTS_MAX mots (`dest` reste alors vide)
+bool Tree_mots(Tree* tree,size_t alphabet_size,Mots* dest)
+{
+    dest->nb = 0;
+    if(tree==NULL)
+        return false;
+    if(tree->left_chilfren==NULL)
+    {
+        Classe c;
+        Classe_clear(&c);
+        if(tree->etiquette==SYNTAXE_OPERATOR_SIGMA || tree->etiquette==0 || !Tree_classe(tree,&c,alphabet_size)
+            || Classe_cardinal(&c)>TEDDY_MOTS_MAX)
+            return false;
+        for(size_t l=1;l<alphabet_size && l<256;l++)
+        {
+            unsigned char lettre = l;
+            if(Classe_mem(&c,l))
+                Mots_ajouter(dest,&lettre,1,NULL,0);
+        }
+        return dest->nb>0;
+    }
+
+    Mots gauche;
+    Mots droite;
+    switch(tree->etiquette)
+    {
+    case SYNTAXE_OPERATOR_JOKER:
+        if(!Tree_mots(tree->left_chilfren,alphabet_size,dest))
+            return false;
+        if(dest->nb==TEDDY_MOTS_MAX)
+        {
+            Mots_free(dest);
+            return false;
+        }
+        Mots_ajouter(dest,NULL,0,NULL,0);
+        return true;
+    case SYNTAXE_OPERATOR_UNION:
+    case SYNTAXE_OPERATOR_CONCATENATION:
+        if(!Tree_mots(tree->left_chilfren,alphabet_size,&gauche))
+            return false;
+        if(!Tree_mots(tree->right_children,alphabet_size,&droite))
+        {
+            Mots_free(&gauche);
+            return false;
+        }
+        if(tree->etiquette==SYNTAXE_OPERATOR_UNION && gauche.nb+droite.nb<=TEDDY_MOTS_MAX)
+        {
+            *dest = gauche;
+            memcpy(dest->mots+dest->nb,droite.mots,sizeof(unsigned char*)*droite.nb);
+            memcpy(dest->tailles+dest->nb,droite.tailles,sizeof(size_t)*droite.nb);
+            dest->nb += droite.nb;
+            return true;
+        }
+        if(tree->etiquette==SYNTAXE_OPERATOR_CONCATENATION && Mots_concatener(&gauche,&droite))
+        {
+            Mots_free(&droite);
+            *dest = gauche;
+            return true;
+        }
+        Mots_free(&gauche);
+        Mots_free(&droite);
+        return false;
+    default:
+        return false;
+    }
+}
+
+/// @brief compare les préfixes de deux mots (tri des mots dans les seaux)
+/// @param mots
+/// @param i
+/// @param j
+/// @return
+int Mots_comparer_prefixes(const Mots* mots,size_t i,size_t j)
+{
+    size_t n = mots->tailles[i]<mots->tailles[j]?mots->tailles[i]:mots->tailles[j];
+    if(n>TEDDY_PREFIXE_MAX)
+        n = TEDDY_PREFIXE_MAX;
+    int c = memcmp(mots->mots[i],mots->mots[j],n);
+    return c!=0?c:(int)mots->tailles[i]-(int)mots->tailles[j];
+}
+
+/// @brief instancie la recherche des mots, rangés par préfixe pour que les mots d'un même seau se ressemblent
+/// @param mots au moins un mot, aucun n'est vide ; l'ensemble appartient ensuite à la recherche
+/// @return
+Teddy* Teddy_init(Mots* mots)
+{
+    Teddy* t = malloc(sizeof(Teddy));
+    Memoire_prendre(sizeof(Teddy));
+    t->mots = *mots;
+    mots->nb = 0;
+    Mots* m = &t->mots;
+
+    // tri par insertion : au plus TEDDY_MOTS_MAX mots
+    for(size_t i=1;i<m->nb;i++)
+        for(size_t j=i;j>0 && Mots_comparer_prefixes(m,j-1,j)>0;j--)
+        {
+            unsigned char* mot = m->mots[j];
+            size_t taille = m->tailles[j];
+            m->mots[j] = m->mots[j-1];
+            m->tailles[j] = m->tailles[j-1];
+            m->mots[j-1] = mot;
+            m->tailles[j-1] = taille;
+        }
+
+    t->prefixe = Mots_taille_min(m);
+    if(t->prefixe>TEDDY_PREFIXE_MAX)
+        t->prefixe = TEDDY_PREFIXE_MAX;
+    memset(t->bas,0,sizeof(t->bas));
+    memset(t->hauts,0,sizeof(t->hauts));
+    memset(t->octets,0,sizeof(t->octets));
+    for(size_t s=0;s<=TEDDY_SEAUX;s++)
+        t->debuts[s] = m->nb;
+    for(size_t i=m->nb;i>0;i--)
+    {
+        size_t s = (i-1)*TEDDY_SEAUX/m->nb;
+        t->debuts[s] = i-1;
+        for(size_t k=0;k<t->prefixe;k++)
+        {
+            unsigned char o = m->mots[i-1][k];
+            t->bas[k][o&0x0f] |= 1<<s;
+            t->hauts[k][o>>4] |= 1<<s;
+            t->octets[k][o] |= 1<<s;
+        }
+    }
+    // un seau vide commence là où commence le suivant
+    for(size_t s=TEDDY_SEAUX;s>0;s--)
+        if(t->debuts[s-1]>t->debuts[s])
+            t->debuts[s-1] = t->debuts[s];
+
+    t->jeu = TEDDY_SCALAIRE;
+#ifdef TEDDY_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        t->jeu = TEDDY_AVX2;
+    else if(__builtin_cpu_supports("ssse3"))
+        t->jeu = TEDDY_SSSE3;
+#endif
+    return t;
+}
+
+void Teddy_free(Teddy* t)
+{
+    Mots_free(&t->mots);
+    Memoire_rendre(sizeof(Teddy));
+    free(t);
+}
+
+const char* Teddy_jeu_nom(enum TEDDY_JEU jeu)
+{
+    switch(jeu)
+    {
+    case TEDDY_AVX2: return "AVX2, 32 positions par comparaison";
+    case TEDDY_SSSE3: return "SSSE3, 16 positions par comparaison";
+    case TEDDY_SCALAIRE: return "scalaire";
+    }
+    return "?";
+}
+
+#ifdef TEDDY_X86
+/// @brief seaux compatibles avec chacune des 16 positions de `texte`
+/// @param t
+/// @param texte au moins 16+t->prefixe-1 octets
+/// @param seaux reçoit les seaux de chaque position
+/// @return bit j : au moins un seau est compatible avec la position j
+__attribute__((target("ssse3")))
+uint32_t Teddy_bloc_ssse3(const Teddy* t,const unsigned char* texte,uint8_t* seaux)
+{
+    __m128i quartet = _mm_set1_epi8(0x0f);
+    __m128i r = _mm_set1_epi8((char)0xff);
+    for(size_t k=0;k<t->prefixe;k++)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(texte+k));
+        __m128i bas = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)t->bas[k]),_mm_and_si128(x,quartet));
+        __m128i hauts = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)t->hauts[k]),_mm_and_si128(_mm_srli_epi16(x,4),quartet));
+        r = _mm_and_si128(r,_mm_and_si128(bas,hauts));
+    }
+    _mm_storeu_si128((__m128i*)seaux,r);
+    return ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(r,_mm_setzero_si128()))&0xffff;
+}
+
+/// @brief `Teddy_bloc_ssse3` sur 32 positions
+__attribute__((target("avx2")))
+uint32_t Teddy_bloc_avx2(const Teddy* t,const unsigned char* texte,uint8_t* seaux)
+{
+    __m256i quartet = _mm256_set1_epi8(0x0f);
+    __m256i r = _mm256_set1_epi8((char)0xff);
+    for(size_t k=0;k<t->prefixe;k++)
+    {
+        // pshufb ne mélange que les octets d'une même moitié : les tables sont copiées dans les deux moitiés
+        __m256i x = _mm256_loadu_si256((const __m256i*)(texte+k));
+        __m256i bas = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)t->bas[k]));
+        __m256i hauts = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)t->hauts[k]));
+        bas = _mm256_shuffle_epi8(bas,_mm256_and_si256(x,quartet));
+        hauts = _mm256_shuffle_epi8(hauts,_mm256_and_si256(_mm256_srli_epi16(x,4),quartet));
+        r = _mm256_and_si256(r,_mm256_and_si256(bas,hauts));
+    }
+    _mm256_storeu_si256((__m256i*)seaux,r);
+    return ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(r,_mm256_setzero_si256()));
+}
+#endif
+
+/// @brief cherche la première occurrence de l'un des mots dans `texte`
+/// @param t
+/// @param s brouillon dont les statistiques de lecture sont mises à jour
+/// @param texte
+/// @param size
+/// @param position index de l'occurrence trouvée (début du mot)
+/// @return true si une occurrence a été trouvée
+bool Teddy_chercher(const Teddy* t,Scratch* s,const unsigned char* texte,size_t size,size_t* position)
+{
+    if(size<t->prefixe)
+    {
+        s->octets_evites += size;
+        return false;
+    }
+    // positions où un mot peut commencer, un bloc lit aussi les t->prefixe-1 octets suivants
+    size_t fin = size-t->prefixe+1;
+    uint8_t seaux[32];
+    size_t lus = 0;
+    size_t i = 0;
+    while(i<fin)
+    {
+        uint32_t candidats;
+        size_t largeur;
+#ifdef TEDDY_X86
+        if(t->jeu==TEDDY_AVX2 && fin-i>=32)
+        {
+            candidats = Teddy_bloc_avx2(t,texte+i,seaux);
+            largeur = 32;
+        }else if(t->jeu!=TEDDY_SCALAIRE && fin-i>=16)
+        {
+            candidats = Teddy_bloc_ssse3(t,texte+i,seaux);
+            largeur = 16;
+        }else
+#endif
+        {
+            seaux[0] = 0xff;
+            for(size_t k=0;k<t->prefixe;k++)
+                seaux[0] &= t->octets[k][texte[i+k]];
+            candidats = seaux[0]!=0;
+            largeur = 1;
+        }
+
+        while(candidats!=0)
+        {
+#ifdef __GNUC__
+            size_t j = __builtin_ctz(candidats);
+#else
+            size_t j = 0;
+            while(!((candidats>>j)&1))
+                j++;
+#endif
+            candidats &= candidats-1;
+            // les mots des seaux compatibles sont comparés en entier
+            for(size_t seau=0;seau<TEDDY_SEAUX;seau++)
+            {
+                if(!((seaux[j]>>seau)&1))
+                    continue;
+                for(size_t m=t->debuts[seau];m<t->debuts[seau+1];m++)
+                {
+                    size_t taille = t->mots.tailles[m];
+                    if(i+j+taille>size)
+                        continue;
+                    lus += taille;
+                    if(memcmp(texte+i+j,t->mots.mots[m],taille)==0)
+                    {
+                        *position = i+j;
+                        s->octets_lus += lus;
+                        s->octets_evites += i+j;
+                        return true;
+                    }
+                }
+            }
+        }
+        i += largeur;
+    }
+    s->octets_lus += lus;
+    s->octets_evites += size;
+    return false;
+}
+
+/// @brief cherche dans la concaténation principale la suite d'opérandes qui lit le moins de mots les plus longs,
+/// un de ces mots se trouve dans tout motif et sert de préfiltre (voir `Teddy_chercher`)
+/// @param tree arbre sans ancre
+/// @param alphabet_size
+/// @param debut reçoit true si la suite commence la concaténation : tout motif commence alors par un des mots
+/// @return la recherche des mots, ou NULL si aucune suite ne lit des mots d'au moins TEDDY_TAILLE_MIN lettres
+Teddy* Tree_teddy(Tree* tree,size_t alphabet_size,bool* debut)
+{
+    size_t nb_noeuds = Tree_nb_noeuds(tree);
+    Tree** operandes = malloc(sizeof(Tree*)*(nb_noeuds+1));
+    size_t nb_operandes = 0;
+
+    // opérandes de la concaténation principale, de gauche à droite, sans modifier l'arbre
+    Tree** pile = malloc(sizeof(Tree*)*(nb_noeuds+1));
+    size_t hauteur = 0;
+    pile[hauteur++] = tree;
+    while(hauteur>0)
+    {
+        Tree* t = pile[--hauteur];
+        if(t->etiquette==SYNTAXE_OPERATOR_CONCATENATION && t->left_chilfren!=NULL)
+        {
+            pile[hauteur++] = t->right_children;
+            pile[hauteur++] = t->left_chilfren;
+        }else
+            operandes[nb_operandes++] = t;
+    }
+    free(pile);
+
+    Mots meilleurs;
+    meilleurs.nb = 0;
+    size_t meilleure_taille = 0;
+    for(size_t a=0;a<nb_operandes;a++)
+    {
+        // les opérandes suivants sont concaténés tant que les mots restent en nombre fini et plus courts que les masques
+        Mots suite;
+        if(!Tree_mots(operandes[a],alphabet_size,&suite))
+            continue;
+        for(size_t b=a+1;b<nb_operandes && Mots_taille_min(&suite)<TEDDY_PREFIXE_MAX;b++)
+        {
+            Mots suivant;
+            if(!Tree_mots(operandes[b],alphabet_size,&suivant))
+                break;
+            bool possible = Mots_concatener(&suite,&suivant);
+            Mots_free(&suivant);
+            if(!possible)
+                break;
+        }
+        size_t taille = Mots_taille_min(&suite);
+        if(taille>TEDDY_PREFIXE_MAX)
+            taille = TEDDY_PREFIXE_MAX;
+        if(taille>meilleure_taille || (taille==meilleure_taille && suite.nb<meilleurs.nb))
+        {
+            Mots_free(&meilleurs);
+            meilleurs = suite;
+            meilleure_taille = taille;
+            *debut = a==0;
+        }else
+            Mots_free(&suite);
+    }
+    free(operandes);
+
+    if(meilleure_taille<TEDDY_TAILLE_MIN)
+    {
+        Mots_free(&meilleurs);
+        return NULL;
+    }
+    return Teddy_init(&meilleurs);
+}
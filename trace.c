@@ -0,0 +1,219 @@
+/*
+    By Adrien Couvidat
+    chronologie de la recherche au format des traces de Chrome (voir trace.h) :
+    chaque thread note ses intervalles dans son propre tampon, sans verrou, et les tampons sont écrits à la fin
+*/
+
+#define _CRT_SECURE_NO_WARNINGS // pour éviter des alerte de compilation avec msvc sous Windows
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "trace.h"
+
+#ifdef _MSC_VER
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL _Thread_local
+#endif
+
+/// @brief intervalle [debut, fin] en nanosecondes depuis `Trace_ouvrir`
+struct TraceIntervalle
+{
+    const char* nom;    // chaîne constante, écrite telle quelle dans le JSON
+    uint64_t debut;
+    uint64_t fin;
+    size_t octets;
+    const char* piste;  // NULL : la piste du thread qui a noté l'intervalle
+    size_t index;       // numéro de la piste `piste`
+};
+typedef struct TraceIntervalle TraceIntervalle;
+
+/// @brief intervalles notés par un thread, qui seul écrit dans son tampon
+struct TraceTampon
+{
+    TraceIntervalle* intervalles;
+    size_t size;
+    size_t capacity;
+    size_t tid;
+    const char* nom;
+    struct TraceTampon* suivant; // tampon du thread précédent, dans la liste de tous les tampons
+};
+typedef struct TraceTampon TraceTampon;
+
+FILE* trace_fichier = NULL;     // NULL : pas de trace
+struct timespec trace_origine;
+TraceTampon* trace_tampons = NULL;
+size_t trace_threads = 0;
+TRACE_THREAD_LOCAL TraceTampon* trace_tampon = NULL;
+
+/// @brief nanosecondes depuis `origine`
+/// @param origine
+/// @return
+uint64_t Trace_depuis(const struct timespec* origine)
+{
+    struct timespec t;
+#ifdef _WIN32
+    timespec_get(&t,TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC,&t);
+#endif
+    return (uint64_t)(t.tv_sec-origine->tv_sec)*1000000000ULL+(uint64_t)t.tv_nsec-(uint64_t)origine->tv_nsec;
+}
+
+/// @brief commence la trace : les intervalles seront écrits dans `chemin` par `Trace_fermer`
+/// @param chemin
+/// @return false si le fichier ne peut pas être créé
+bool Trace_ouvrir(const char* chemin)
+{
+    trace_fichier = fopen(chemin,"w");
+    if(trace_fichier==NULL)
+        return false;
+#ifdef _WIN32
+    timespec_get(&trace_origine,TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC,&trace_origine);
+#endif
+    Trace_nommer("principal");
+    return true;
+}
+
+/// @brief instant présent pour le début d'un intervalle
+/// @return 0 si il n'y a pas de trace (les intervalles qui commencent à 0 ne sont pas notés)
+uint64_t Trace_maintenant(void)
+{
+    if(trace_fichier==NULL)
+        return 0;
+    // jamais 0 pendant une trace
+    return Trace_depuis(&trace_origine)|1;
+}
+
+/// @brief tampon du thread appelant, créé et ajouté à la liste des tampons à sa première utilisation
+/// @return
+TraceTampon* Trace_tampon(void)
+{
+    if(trace_tampon!=NULL)
+        return trace_tampon;
+    TraceTampon* t = malloc(sizeof(TraceTampon));
+    t->capacity = 256;
+    t->size = 0;
+    t->intervalles = malloc(sizeof(TraceIntervalle)*t->capacity);
+    t->nom = NULL;
+#ifdef __GNUC__
+    t->tid = __atomic_add_fetch(&trace_threads,1,__ATOMIC_RELAXED);
+    t->suivant = __atomic_load_n(&trace_tampons,__ATOMIC_RELAXED);
+    while(!__atomic_compare_exchange_n(&trace_tampons,&t->suivant,t,true,__ATOMIC_RELEASE,__ATOMIC_RELAXED));
+#else
+    // sans les threads POSIX, seul le thread principal note des intervalles
+    t->tid = ++trace_threads;
+    t->suivant = trace_tampons;
+    trace_tampons = t;
+#endif
+    trace_tampon = t;
+    return t;
+}
+
+/// @brief nomme la piste du thread appelant
+/// @param nom chaîne constante
+void Trace_nommer(const char* nom)
+{
+    if(trace_fichier==NULL)
+        return;
+    Trace_tampon()->nom = nom;
+}
+
+/// @brief ajoute l'intervalle au tampon du thread appelant (voir `Trace_intervalle_piste`)
+void Trace_noter(const char* piste,size_t index,const char* nom,uint64_t debut,size_t octets)
+{
+    TraceTampon* t = Trace_tampon();
+    if(t->size==t->capacity)
+    {
+        t->capacity *= 2;
+        t->intervalles = realloc(t->intervalles,sizeof(TraceIntervalle)*t->capacity);
+    }
+    TraceIntervalle* i = &t->intervalles[t->size++];
+    i->nom = nom;
+    i->debut = debut;
+    i->fin = Trace_depuis(&trace_origine);
+    if(i->fin<debut)
+        i->fin = debut; // `debut` a été rendu impair par `Trace_maintenant`
+    i->octets = octets;
+    i->piste = piste;
+    i->index = index;
+}
+
+/// @brief note sur la piste du thread appelant l'intervalle de `debut` à maintenant
+/// @param nom chaîne constante
+/// @param debut valeur de `Trace_maintenant` au début de l'intervalle
+/// @param octets octets traités pendant l'intervalle
+void Trace_intervalle(const char* nom,uint64_t debut,size_t octets)
+{
+    if(debut==0)
+        return;
+    Trace_noter(NULL,0,nom,debut,octets);
+}
+
+/// @brief note l'intervalle sur la piste `index` du groupe `piste`, pour les opérations en cours à la fois
+/// qu'aucun thread n'exécute (les intervalles d'une même piste ne doivent pas se chevaucher)
+/// @param piste chaîne constante
+/// @param index
+/// @param nom chaîne constante
+/// @param debut valeur de `Trace_maintenant` au début de l'intervalle
+/// @param octets
+void Trace_intervalle_piste(const char* piste,size_t index,const char* nom,uint64_t debut,size_t octets)
+{
+    if(debut==0)
+        return;
+    Trace_noter(piste,index,nom,debut,octets);
+}
+
+/// @brief écrit tous les intervalles notés et termine la trace
+/// @warning les autres threads doivent être terminés
+/// @return false si le fichier n'a pas pu être écrit
+bool Trace_fermer(void)
+{
+    if(trace_fichier==NULL)
+        return true;
+    FILE* f = trace_fichier;
+    trace_fichier = NULL;
+
+    fprintf(f,"{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool premier = true;
+    bool pistes_nommees[TRACE_PISTES] = {false};
+    for(TraceTampon* t=trace_tampons;t!=NULL;t=t->suivant)
+    {
+        fprintf(f,"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+            premier?"":",\n",t->tid,t->nom!=NULL?t->nom:"thread");
+        premier = false;
+        for(size_t k=0;k<t->size;k++)
+        {
+            TraceIntervalle* i = &t->intervalles[k];
+            size_t tid = t->tid;
+            if(i->piste!=NULL)
+            {
+                tid = TRACE_PISTES+i->index;
+                if(i->index<TRACE_PISTES && !pistes_nommees[i->index])
+                {
+                    fprintf(f,",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}}",tid,i->piste,i->index);
+                    pistes_nommees[i->index] = true;
+                }
+            }
+            fprintf(f,",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"octets\":%zu}}",
+                i->nom,tid,(double)i->debut/1000,(double)(i->fin-i->debut)/1000,i->octets);
+        }
+    }
+    fprintf(f,"\n]}\n");
+    bool ecrit = !ferror(f);
+    ecrit = fclose(f)==0 && ecrit;
+
+    while(trace_tampons!=NULL)
+    {
+        TraceTampon* t = trace_tampons;
+        trace_tampons = t->suivant;
+        free(t->intervalles);
+        free(t);
+    }
+    trace_tampon = NULL;
+    return ecrit;
+}
@@ -0,0 +1,23 @@
+/*
+    By Adrien Couvidat
+    chronologie de la recherche (--trace FICHIER) : intervalles de compilation, de lecture, de recherche et d'écriture
+    de chaque thread, écrits à la fin au format JSON des traces de Chrome (chrome://tracing, ui.perfetto.dev)
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_PISTES 1000 // identifiants des pistes qui ne sont pas des threads (lectures io_uring en cours)
+
+bool Trace_ouvrir(const char* chemin);
+bool Trace_fermer(void);
+uint64_t Trace_maintenant(void);
+void Trace_nommer(const char* nom);
+void Trace_intervalle(const char* nom,uint64_t debut,size_t octets);
+void Trace_intervalle_piste(const char* piste,size_t index,const char* nom,uint64_t debut,size_t octets);
+
+#endif // TRACE_H
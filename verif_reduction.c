@@ -0,0 +1,187 @@
+/*
+    By Adrien Couvidat
+    vérification de la réduction des automates (make verif-reduction) : pour chaque expression d'un corpus,
+    l'automate de Thomson et l'automate réduit (ainsi que leurs automates (.)*e) doivent reconnaître le même langage,
+    et trouver la même première fin de motif dans chaque ligne d'un texte
+*/
+
+#include "mygrep_interne.h"
+
+#define VERIF_ALPHABET 255
+#define VERIF_BUDGET 4096           // paires d'ensembles explorées par `Automate_equivalents`
+#define VERIF_LIGNES_MAX 20000      // lignes du texte lues pour chaque expression
+#define VERIF_LIGNE_TAILLE 4096
+
+/// @brief index qui suit la dernière lettre du premier motif reconnu par l'automate (.)*e dans `line` (0 pour le motif vide)
+/// @param a automate (.)*e
+/// @param Q
+/// @param next_Q
+/// @param bits
+/// @param next_bits
+/// @param line
+/// @param size
+/// @return SIZE_MAX si la ligne ne contient pas de motif
+size_t premiere_fin(Automate* a,Ensemble* Q,Ensemble* next_Q,uint64_t* bits,uint64_t* next_bits,const unsigned char* line,size_t size)
+{
+    Ensemble* init = Automate_initiaux_clos(a);
+    Ensemble_copy_into(Q,init);
+    Ensemble_free(init);
+    Automate_compteurs_clear(a,bits);
+    if(Automate_is_final_ensemble(a,Q))
+        return 0;
+    for(size_t i=0;i<size;i++)
+    {
+        Automate_step(a,Q,bits,line[i],next_Q,next_bits);
+        if(Automate_is_final_ensemble(a,next_Q))
+            return i+1;
+        Ensemble* temp = Q;
+        Q = next_Q;
+        next_Q = temp;
+        uint64_t* temp_bits = bits;
+        bits = next_bits;
+        next_bits = temp_bits;
+    }
+    return SIZE_MAX;
+}
+
+/// @brief compare deux automates (.)*e sur chaque ligne du texte
+/// @param a
+/// @param b
+/// @param texte
+/// @param ligne_fausse première ligne (numérotée à partir de 1) où les fins diffèrent
+/// @return true si les premières fins sont les mêmes sur toutes les lignes
+bool memes_fins(Automate* a,Automate* b,FILE* texte,size_t* ligne_fausse)
+{
+    Ensemble* Q[2][2];
+    uint64_t* bits[2][2];
+    Automate* x[2] = {a,b};
+    for(size_t k=0;k<2;k++)
+        for(size_t j=0;j<2;j++)
+        {
+            Q[k][j] = Ensemble_init(x[k]->nb_etat);
+            bits[k][j] = calloc(Automate_mots_bits(x[k]),sizeof(uint64_t));
+        }
+
+    rewind(texte);
+    char line[VERIF_LIGNE_TAILLE];
+    bool memes = true;
+    for(size_t n=1;memes && n<=VERIF_LIGNES_MAX && fgets(line,sizeof(line),texte)!=NULL;n++)
+    {
+        size_t size = strcspn(line,"\n");
+        size_t fin[2];
+        for(size_t k=0;k<2;k++)
+            fin[k] = premiere_fin(x[k],Q[k][0],Q[k][1],bits[k][0],bits[k][1],(const unsigned char*)line,size);
+        memes = fin[0]==fin[1];
+        if(!memes)
+            *ligne_fausse = n;
+    }
+
+    for(size_t k=0;k<2;k++)
+        for(size_t j=0;j<2;j++)
+        {
+            Ensemble_free(Q[k][j]);
+            free(bits[k][j]);
+        }
+    return memes;
+}
+
+/// @brief vérifie la réduction de l'automate d'une expression
+/// @param expression
+/// @param texte NULL : seule l'équivalence des langages est vérifiée
+/// @return false si la réduction a changé les motifs reconnus
+bool verifier(const char* expression,FILE* texte)
+{
+    size_t size = strlen(expression);
+    Lettre* er = malloc(sizeof(Lettre)*(size+1));
+    for(size_t i=0;i<size+1;i++)
+        er[i] = (unsigned char)expression[i];
+    Tree* tree = make_syntaxique_tree(er);
+    if(tree==NULL)
+    {
+        printf("%-40s expression incorrecte\n",expression);
+        free(er);
+        return false;
+    }
+    tree = Tree_simplifier(tree,VERIF_ALPHABET);
+    Automate* a = make_thomson_automate(tree,VERIF_ALPHABET,true);
+    Tree_free(tree);
+    free(er);
+    if(a==NULL)
+    {
+        printf("%-40s automate impossible à construire\n",expression);
+        return false;
+    }
+
+    Automate* reduit = Automate_reduire(a);
+    Automate* line = Automate_line(a);
+    Automate* line_reduit = Automate_reduire(line);
+
+    // -1 : on ne peut pas conclure (compteurs, budget dépassé), la lecture du texte seule décide
+    int langage = Automate_equivalents(a,reduit,VERIF_BUDGET);
+    int langage_line = Automate_equivalents(line,line_reduit,VERIF_BUDGET);
+    size_t ligne_fausse = 0;
+    bool fins = texte==NULL || memes_fins(line,line_reduit,texte,&ligne_fausse);
+    bool ok = langage!=0 && langage_line!=0 && fins;
+
+    printf("%-40s %6zu -> %-6zu %-12s %s",expression,a->nb_etat,reduit->nb_etat,
+        (langage==1 && langage_line==1)?"équivalents":(langage==0 || langage_line==0)?"DIFFÉRENTS":"non conclu",
+        ok?"ok":"ÉCHEC");
+    if(!fins)
+        printf(" (ligne %zu)",ligne_fausse);
+    printf("\n");
+
+    Automate_free(a);
+    Automate_free(reduit);
+    Automate_free(line);
+    Automate_free(line_reduit);
+    return ok;
+}
+
+int main(int argc,char** argv)
+{
+    if(argc<2 || argc>3)
+    {
+        fprintf(stderr,"usage : %s MOTIFS [TEXTE]\n"
+            "    MOTIFS : une expression par ligne (les lignes vides et celles qui commencent par # sont ignorées)\n"
+            "    TEXTE : les premières fins de motif sont comparées sur ses %d premières lignes\n",argv[0],VERIF_LIGNES_MAX);
+        return 2;
+    }
+    FILE* motifs = fopen(argv[1],"r");
+    if(motifs==NULL)
+    {
+        fprintf(stderr,"Impossible d'ouvrir le fichier %s!\n",argv[1]);
+        return 2;
+    }
+    FILE* texte = NULL;
+    if(argc==3)
+    {
+        texte = fopen(argv[2],"r");
+        if(texte==NULL)
+        {
+            fprintf(stderr,"Impossible d'ouvrir le fichier %s!\n",argv[2]);
+            fclose(motifs);
+            return 2;
+        }
+    }
+
+    printf("%-40s %16s %-12s %s\n","expression","états","langages","");
+    char expression[VERIF_LIGNE_TAILLE];
+    size_t nb = 0;
+    size_t echecs = 0;
+    while(fgets(expression,sizeof(expression),motifs)!=NULL)
+    {
+        expression[strcspn(expression,"\n")] = '\0';
+        if(expression[0]=='\0' || expression[0]=='#')
+            continue;
+        nb++;
+        if(!verifier(expression,texte))
+            echecs++;
+    }
+    printf("%zu expressions, %zu échecs\n",nb,echecs);
+
+    fclose(motifs);
+    if(texte!=NULL)
+        fclose(texte);
+    Scratch_thread_cleanup();
+    return echecs>0;
+}